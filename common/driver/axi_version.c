@@ -23,6 +23,7 @@
 #include <AxiVersion.h>
 #include <dma_common.h>
 #include <linux/seq_file.h>
+#include <linux/slab.h>
 
 /**
  * AxiVersion_Get - Retrieve the AXI version information.
@@ -62,12 +63,46 @@ int32_t AxiVersion_Get(struct DmaDevice *dev, void *base, uint64_t arg) {
  * @base: Base address of the AXI version registers.
  * @aVer: Pointer to the AxiVersion structure to populate.
  *
+ * This function populates the provided AxiVersion structure from the copy
+ * cached by AxiVersion_Cache, reading only the scratch pad and up time count
+ * from the hardware. Without a cached copy all fields are read from the
+ * hardware registers.
+ */
+void AxiVersion_Read(struct DmaDevice *dev, void * base, struct AxiVersion *aVer) {
+   struct AxiVersion_Reg *reg = (struct AxiVersion_Reg *)base;
+   bool cached = false;
+
+   // Copy the static fields
+   spin_lock(&dev->commandLock);
+   if (dev->aVer != NULL) {
+      memcpy(aVer, dev->aVer, sizeof(struct AxiVersion));
+      cached = true;
+   }
+   spin_unlock(&dev->commandLock);
+
+   if (!cached) {
+      AxiVersion_ReadHw(dev, base, aVer);
+      return;
+   }
+
+   // Read the dynamic fields
+   aVer->scratchPad  = readl(&(reg->scratchPad));
+   aVer->upTimeCount = readl(&(reg->upTimeCount));
+}
+
+/**
+ * AxiVersion_ReadHw - Reads the AXI version information from the hardware.
+ * @dev: Pointer to the DmaDevice structure.
+ * @base: Base address of the AXI version registers.
+ * @aVer: Pointer to the AxiVersion structure to populate.
+ *
  * This function reads the AXI version information from the hardware registers
  * and populates the provided AxiVersion structure with the firmware version,
  * scratch pad, up time count, feature descriptor value, user-defined values,
- * device ID, git hash, device DNA value, and build string.
+ * device ID, git hash, device DNA value, and build string. This is about 180
+ * register reads, each a round trip over the bus.
  */
-void AxiVersion_Read(struct DmaDevice *dev, void * base, struct AxiVersion *aVer) {
+void AxiVersion_ReadHw(struct DmaDevice *dev, void * base, struct AxiVersion *aVer) {
    struct AxiVersion_Reg *reg = (struct AxiVersion_Reg *)base;
    uint32_t x;
 
@@ -105,6 +140,52 @@ void AxiVersion_Read(struct DmaDevice *dev, void * base, struct AxiVersion *aVer
    }
 }
 
+/**
+ * AxiVersion_Cache - Cache the static AXI version information.
+ * @dev: Pointer to the DmaDevice structure.
+ * @base: Base address of the AXI version registers.
+ *
+ * This function reads the AXI version information from the hardware and
+ * replaces the copy used by AxiVersion_Read. It is called when the device
+ * is loaded and on the AVER_Refresh command, for example after the FPGA
+ * has been reprogrammed.
+ *
+ * Return: 0 on success, -ENOMEM on allocation failure.
+ */
+int32_t AxiVersion_Cache(struct DmaDevice *dev, void *base) {
+   struct AxiVersion *aVer;
+   struct AxiVersion *old;
+
+   if ((aVer = kzalloc(sizeof(struct AxiVersion), GFP_KERNEL)) == NULL)
+      return -ENOMEM;
+
+   AxiVersion_ReadHw(dev, base, aVer);
+
+   // Swap in the new copy, readers copy it under the lock
+   spin_lock(&dev->commandLock);
+   old = dev->aVer;
+   dev->aVer = aVer;
+   spin_unlock(&dev->commandLock);
+
+   kfree(old);
+   return 0;
+}
+
+/**
+ * AxiVersion_Free - Free the cached AXI version information.
+ * @dev: Pointer to the DmaDevice structure.
+ */
+void AxiVersion_Free(struct DmaDevice *dev) {
+   struct AxiVersion *old;
+
+   spin_lock(&dev->commandLock);
+   old = dev->aVer;
+   dev->aVer = NULL;
+   spin_unlock(&dev->commandLock);
+
+   kfree(old);
+}
+
 /**
  * AxiVersion_Show - Display AXI version information.
  * @s: sequence file pointer to which this function will write.
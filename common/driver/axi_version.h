@@ -83,6 +83,9 @@ struct AxiVersion_Reg {
 // Function prototypes
 int32_t AxiVersion_Get(struct DmaDevice *dev, void *base, uint64_t arg);
 void AxiVersion_Read(struct DmaDevice *dev, void *base, struct AxiVersion *aVer);
+void AxiVersion_ReadHw(struct DmaDevice *dev, void *base, struct AxiVersion *aVer);
+int32_t AxiVersion_Cache(struct DmaDevice *dev, void *base);
+void AxiVersion_Free(struct DmaDevice *dev);
 void AxiVersion_Show(struct seq_file *s, struct DmaDevice *dev, struct AxiVersion *aVer);
 void AxiVersion_SetUserReset(void *base, bool state);
 
@@ -20,6 +20,7 @@
 
 #include <axis_gen2.h>
 #include <AxisDriver.h>
+#include <dma_trace.h>
 #include <linux/seq_file.h>
 #include <linux/signal.h>
 #include <linux/slab.h>
@@ -50,6 +51,7 @@ struct hardware_functions AxisG2_functions = {
    .sendBuffer   = AxisG2_SendBuffer,
    .command      = AxisG2_Command,
    .seqShow      = AxisG2_SeqShow,
+   .statsRegs    = AxisG2_StatsRegs,
 };
 
 /**
@@ -105,7 +107,7 @@ inline uint8_t AxisG2_MapReturn(struct DmaDevice * dev, struct AxisG2Return *ret
    }
 
    // Logging for debug purposes
-   if ( dev->debug > 0 )
+   if ( dmaDebug(dev) )
       dev_info(dev->device, "MapReturn: desc idx %i, raw 0x%x, 0x%x, 0x%x, 0x%x\n", index, ptr[0], ptr[1], ptr[2], ptr[3]);
 
    // Clear the processed descriptor area
@@ -126,6 +128,12 @@ inline uint8_t AxisG2_MapReturn(struct DmaDevice * dev, struct AxisG2Return *ret
  */
 inline void AxisG2_WriteFree(struct DmaBuffer *buff, struct AxisG2Reg *reg, uint32_t desc128En) {
    uint32_t wrData[2];
+   dma_addr_t handle;
+
+   dmaLcMark(buff->buffList->dev, buff, DMA_LC_FREE);
+
+   // Buffer memory or a zero-copy receive slot
+   handle = dmaRxZcAttach(buff);
 
    // Mask the buffer index to fit within the 28-bit field
    wrData[0] = buff->index & 0x0FFFFFFF;
@@ -133,9 +141,9 @@ inline void AxisG2_WriteFree(struct DmaBuffer *buff, struct AxisG2Reg *reg, uint
    if (desc128En) {
       // If using 128-bit descriptors, encode the buffer handle across two 32-bit writes
       // First part: Addr bits 7:4 into the upper 4 bits of the first word
-      wrData[0] |= (buff->buffHandle << 24) & 0xF0000000;
+      wrData[0] |= (handle << 24) & 0xF0000000;
       // Second part: Addr bits 39:8 into the entirety of the second word
-      wrData[1]  = (buff->buffHandle >>  8) & 0xFFFFFFFF;
+      wrData[1]  = (handle >>  8) & 0xFFFFFFFF;
 
       // Write the second part to the device's write FIFO B
       writel(wrData[1], &(reg->writeFifoB));
@@ -144,7 +152,7 @@ inline void AxisG2_WriteFree(struct DmaBuffer *buff, struct AxisG2Reg *reg, uint
    // to the device's DMA address table based on the buffer index
    } else {
       // For 64-bit descriptors
-      writel(buff->buffHandle, &(reg->dmaAddr[buff->index]));
+      writel(handle, &(reg->dmaAddr[buff->index]));
    }
 
    // Write the first part (or the entire buffer index for 32-bit descriptors)
@@ -164,10 +172,14 @@ inline void AxisG2_WriteFree(struct DmaBuffer *buff, struct AxisG2Reg *reg, uint
  * enabled by the `desc128En` flag.
  */
 inline void AxisG2_WriteTx(struct DmaBuffer *buff, struct AxisG2Reg *reg, uint32_t desc128En) {
+   dma_addr_t handle;
    uint32_t rdData[4];
    uint32_t dest;
    uint32_t chan;
 
+   // Zero-copy buffers carry the address of the user data
+   handle = (buff->zcRegion != NULL) ? buff->zcHandle : buff->buffHandle;
+
    // Configure buffer flags for transmission
    rdData[0]  = (buff->flags >> 13) & 0x00000008;  // bit[3] = continue = flags[16]
    rdData[0] |= (buff->flags <<  8) & 0x00FF0000;  // Bits[23:16] = lastUser = flags[15:8]
@@ -185,8 +197,8 @@ inline void AxisG2_WriteTx(struct DmaBuffer *buff, struct AxisG2Reg *reg, uint32
 
       // Buffer index and handle for 128-bit descriptor
       rdData[2] = buff->index & 0x0FFFFFFF;
-      rdData[2] |= (buff->buffHandle << 24) & 0xF0000000;  // Addr bits[31:28]
-      rdData[3]  = (buff->buffHandle >>  8) & 0xFFFFFFFF;  // Addr bits[39:8]
+      rdData[2] |= (handle << 24) & 0xF0000000;  // Addr bits[31:28]
+      rdData[3]  = (handle >>  8) & 0xFFFFFFFF;  // Addr bits[39:8]
 
       // Write to FIFO registers for 128-bit descriptor
       writel(rdData[3], &(reg->readFifoD));
@@ -199,7 +211,7 @@ inline void AxisG2_WriteTx(struct DmaBuffer *buff, struct AxisG2Reg *reg, uint32
       rdData[1] |= (buff->dest << 24) & 0xFF000000;  // Destination ID
 
       // Write buffer handle to DMA address table
-      writel(buff->buffHandle, &(reg->dmaAddr[buff->index]));
+      writel(handle, &(reg->dmaAddr[buff->index]));
    }
 
    // Write to FIFO registers
@@ -228,8 +240,11 @@ uint32_t AxisG2_Process(struct DmaDevice * dev, struct AxisG2Reg *reg, struct Ax
    uint32_t bCnt;
    uint32_t rCnt;
    uint32_t handleCount;
+   uint64_t now;
 
    handleCount = 0;
+   trace_dma_service_start(dev);
+
    ////////////////// Transmit Buffers /////////////////////////
 
    // Check read (transmit) returns
@@ -237,7 +252,11 @@ uint32_t AxisG2_Process(struct DmaDevice * dev, struct AxisG2Reg *reg, struct Ax
       ++handleCount;
       --(hwData->hwRdBuffCnt);
 
-      if ( dev->debug > 0 ) dev_info(dev->device, "Process: Got TX Descriptor: Idx=%i, Pos=%i\n", ret.index, hwData->readIndex);
+      if ( dmaDebug(dev) ) dev_info(dev->device, "Process: Got TX Descriptor: Idx=%i, Pos=%i\n", ret.index, hwData->readIndex);
+
+      // Lookup is only done while the event is enabled
+      if ( trace_dma_tx_done_enabled() && ((buff = dmaGetBufferList(&(dev->txBuffers), ret.index)) != NULL) )
+         trace_dma_tx_done(dev, buff);
 
       // Attempt to find buffer in tx pool and return. otherwise return rx entry to hw.
       // Must adjust counters here and check for buffer need
@@ -268,12 +287,15 @@ uint32_t AxisG2_Process(struct DmaDevice * dev, struct AxisG2Reg *reg, struct Ax
    // Lock to protect shared resources
    spin_lock(&dev->maskLock);
 
+   // Harvest time of this pass, the clock is only read for extended read records
+   now = (dev->rxStamp > 0) ? ktime_get_ns() : 0;
+
    // Check write (receive) descriptors
    while ( AxisG2_MapReturn(dev, &ret, hwData->desc128En, hwData->writeIndex, hwData->writeAddr) ) {
       ++handleCount;
       --(hwData->hwWrBuffCnt);
 
-      if ( dev->debug > 0 ) dev_info(dev->device, "Process: Got RX Descriptor: Idx=%i, Pos=%i\n", ret.index, hwData->writeIndex);
+      if ( dmaDebug(dev) ) dev_info(dev->device, "Process: Got RX Descriptor: Idx=%i, Pos=%i\n", ret.index, hwData->writeIndex);
 
       if ( (buff = dmaGetBufferList(&(dev->rxBuffers), ret.index)) != NULL ) {
          // Set buffer properties based on descriptor info
@@ -289,22 +311,26 @@ uint32_t AxisG2_Process(struct DmaDevice * dev, struct AxisG2Reg *reg, struct Ax
          buff->flags |= (ret.cont << 16) & 0x00010000;  // continue = flags[16]
 
          hwData->contCount += ret.cont;
+         dmaRxStamp(dev, buff, now);
+         dmaLcMark(dev, buff, DMA_LC_HW);
 
-         if ( dev->debug > 0 ) {
+         if ( dmaDebug(dev) ) {
             dev_info(dev->device, "Process: Rx size=%i, Dest=0x%x, fuser=0x%x, luser=0x%x, cont=%i, Error=0x%x\n",
                ret.size, ret.dest, ret.fuser, ret.luser, ret.cont, buff->error);
          }
+         trace_dma_rx(dev, buff);
+         dmaStatsRx(dev, buff);
 
          // Determine the owner of the buffer based on dest
-         if (buff->dest < DMA_MAX_DEST) {
-            desc = dev->desc[buff->dest];
-         } else {
-            desc = NULL;
-         }
+         desc = Dma_DestOwner(dev, buff->dest, ret.cont);
 
          // Return entry to FPGA if descriptor is not open
          if ( desc == NULL ) {
-            if ( dev->debug > 0 ) dev_info(dev->device, "Process: Port not open return to free list.\n");
+            if ( dmaDebug(dev) ) dev_info(dev->device, "Process: Port not open return to free list.\n");
+            trace_dma_rx_drop(dev, buff);
+            dmaStatsDrop(dev, buff);
+            dmaBufferToHw(buff);
+            dmaLcSkip(buff);
 
             if (hwData->hwWrBuffCnt < (hwData->addrCount-1)) {
                AxisG2_WriteFree(buff, reg, hwData->desc128En);
@@ -318,6 +344,17 @@ uint32_t AxisG2_Process(struct DmaDevice * dev, struct AxisG2Reg *reg, struct Ax
                writel(0x1, &(reg->bgCount[buff->id]));
             }
 
+         // Small frame copied out, buffer goes straight back to the free list
+         } else if ( dmaRxSmall(desc, buff) ) {
+            dmaBufferToHw(buff);
+            dmaLcSkip(buff);
+            if (hwData->hwWrBuffCnt < (hwData->addrCount-1)) {
+               AxisG2_WriteFree(buff, reg, hwData->desc128En);
+               ++hwData->hwWrBuffCnt;
+            } else {
+                dmaQueuePushIrq(&(hwData->wrQueue), buff);
+            }
+
          // Lane/VC is open; add to RX queue
          } else {
              dmaRxBufferIrq(desc, buff);
@@ -346,6 +383,8 @@ uint32_t AxisG2_Process(struct DmaDevice * dev, struct AxisG2Reg *reg, struct Ax
       } while (bCnt > 0);
    }
 
+   Dma_ServiceStats(dev, handleCount);
+   trace_dma_service_end(dev, handleCount);
    return handleCount;
 }
 
@@ -372,14 +411,18 @@ irqreturn_t AxisG2_Irq(int irq, void *dev_id) {
 
    // Disable interrupt
    writel(0x0, &(reg->intEnable));
+   trace_dma_irq(dev);
 
    // Log interrupt occurrence if debugging is enabled
-   if (dev->debug > 0) {
+   if (dmaDebug(dev)) {
       dev_info(dev->device, "Irq: Called.\n");
    }
 
    // Schedule work to handle the data if not disabled and work queue is enabled
    if ((!dev->cfgIrqDis) && hwData->wqEnable) {
+#ifdef DMA_LIFECYCLE
+      dev->lcIrq = ktime_get_ns();
+#endif
       queue_work(hwData->wq, &(hwData->irqWork));
    }
 
@@ -417,6 +460,9 @@ void AxisG2_Init(struct DmaDevice *dev) {
    // Determine operation mode (64-bit or 128-bit) based on hardware version
    hwData->desc128En = ((readl(&(reg->enableVer)) & 0x10000) != 0);
 
+   // Buffers are returned by index, allowing zero-copy transmit and receive
+   dev->zeroCopy = 1;
+
    // Initialize buffer counters
    hwData->hwWrBuffCnt = 0;
    hwData->hwRdBuffCnt = 0;
@@ -661,6 +707,9 @@ void AxisG2_RetRxBuffer(struct DmaDevice *dev, struct DmaBuffer **buff, uint32_t
 
    // Prepare for hardware interaction
    for (x = 0; x < count; x++) {
+      dmaLcMark(dev, buff[x], DMA_LC_USER);
+      trace_dma_rx_ret(dev, buff[x]);
+
       if (dmaBufferToHw(buff[x]) < 0) {
          dev_warn(dev->device, "RetRxBuffer: Failed to map dma buffer.\n");
          return;
@@ -719,13 +768,16 @@ int32_t AxisG2_SendBuffer(struct DmaDevice *dev, struct DmaBuffer **buff, uint32
          dev_warn(dev->device, "SendBuffer: Failed to map dma buffer.\n");
          return -1;
       }
+      trace_dma_tx_submit(dev, buff[x]);
+      dmaStatsTx(dev, buff[x]);
+   }
 
-      // Direct hardware write for 64-bit descriptors
-      if (!hwData->desc128En) {
-         spin_lock_irqsave(&dev->writeHwLock, iflags);
+   // Direct hardware write for 64-bit descriptors, one lock hold keeps a chained frame together
+   if (!hwData->desc128En) {
+      spin_lock_irqsave(&dev->writeHwLock, iflags);
+      for (x = 0; x < count; x++)
          AxisG2_WriteTx(buff[x], reg, hwData->desc128En);
-         spin_unlock_irqrestore(&dev->writeHwLock, iflags);
-      }
+      spin_unlock_irqrestore(&dev->writeHwLock, iflags);
    }
 
    // For 128-bit descriptors, push to software queue and force an interrupt
@@ -883,7 +935,7 @@ void AxisG2_WqTask_Poll(struct work_struct *work) {
    handleCount = AxisG2_Process(dev, reg, hwData);
 
    // Log the number of handled items if debugging is enabled
-   if (dev->debug > 0 && handleCount > 0) {
+   if (dmaDebug(dev) && handleCount > 0) {
       dev_info(dev->device, "Poll: Done. Handled = %i\n", handleCount);
    }
 
@@ -916,10 +968,16 @@ void AxisG2_WqTask_Service(struct work_struct *work) {
    dev = (struct DmaDevice *)hwData->dev;
 
    // Debug information: entering service routine
-   if (dev->debug > 0) {
+   if (dmaDebug(dev)) {
       dev_info(dev->device, "Service: Entered\n");
    }
 
+#ifdef DMA_LIFECYCLE
+   // Time from the interrupt to the service work
+   if (dev->lcIrq != 0) dmaLcAdd(dev, DMA_LC_WORK, ktime_get_ns() - dev->lcIrq);
+   dev->lcIrq = 0;
+#endif
+
    // Process incoming data and handle it accordingly
    handleCount = AxisG2_Process(dev, reg, hwData);
 
@@ -929,10 +987,43 @@ void AxisG2_WqTask_Service(struct work_struct *work) {
    }
 
    // Debug information: completion of service routine
-   if (dev->debug > 0) {
+   if (dmaDebug(dev)) {
       dev_info(dev->device, "Service: Done. Handled = %i\n", handleCount);
    }
 
    // Acknowledge interrupt and enable next interrupt
    writel(0x30000 + handleCount, &(reg->intAckAndEnable));
 }
+
+/**
+ * AxisG2_StatsRegs - Snapshot firmware registers for the statistics page.
+ * @dev: Pointer to the device structure.
+ * @regs: Array receiving the register values.
+ * @count: Size of @regs.
+ *
+ * Stores enableVer, intReqCount, hwWrIndex, hwRdIndex, wrReqMissed,
+ * irqHoldOff, cacheConfig and the eight background counts, in that order.
+ *
+ * Return: Number of registers stored.
+ */
+uint32_t AxisG2_StatsRegs(struct DmaDevice *dev, uint32_t *regs, uint32_t count) {
+   struct AxisG2Reg *reg;
+   uint32_t x;
+
+   reg = (struct AxisG2Reg *)dev->reg;
+
+   if (count < 15) return 0;
+
+   regs[0] = readl(&(reg->enableVer));
+   regs[1] = readl(&(reg->intReqCount));
+   regs[2] = readl(&(reg->hwWrIndex));
+   regs[3] = readl(&(reg->hwRdIndex));
+   regs[4] = readl(&(reg->wrReqMissed));
+   regs[5] = readl(&(reg->irqHoldOff));
+   regs[6] = readl(&(reg->cacheConfig));
+
+   for (x = 0; x < 8; x++)
+      regs[7+x] = readl(&(reg->bgCount[x]));
+
+   return 15;
+}
@@ -222,6 +222,7 @@ void AxisG2_RetRxBuffer(struct DmaDevice *dev, struct DmaBuffer **buff, uint32_t
 int32_t AxisG2_SendBuffer(struct DmaDevice *dev, struct DmaBuffer **buff, uint32_t count);
 int32_t AxisG2_Command(struct DmaDevice *dev, uint32_t cmd, uint64_t arg);
 void AxisG2_SeqShow(struct seq_file *s, struct DmaDevice *dev);
+uint32_t AxisG2_StatsRegs(struct DmaDevice *dev, uint32_t *regs, uint32_t count);
 extern struct hardware_functions AxisG2_functions;
 void AxisG2_WqTask_IrqForce(struct work_struct *work);
 void AxisG2_WqTask_Poll(struct work_struct *work);
@@ -25,9 +25,12 @@
 #include <linux/sched.h>
 #include <linux/slab.h>
 #include <linux/version.h>
+#include <linux/eventfd.h>
+#include <linux/highmem.h>
 
 #include <dma_buffer.h>
 #include <dma_common.h>
+#include <dma_trace.h>
 
 /**
  * dmaAllocBuffers - Allocate DMA buffers and organize them into a list
@@ -442,7 +445,7 @@ struct DmaBuffer *dmaRetBufferIrq(struct DmaDevice *dev, dma_addr_t handle) {
    // Attempt to return buffer to transmit queue if found
    if ((buff = dmaFindBufferList(&(dev->txBuffers), handle)) != NULL) {
       dmaBufferFromHw(buff);  // Prepare buffer for hardware interaction
-      dmaQueuePushIrq(&(dev->tq), buff);  // Re-queue the buffer
+      dmaTxBufferPush(dev, buff);  // Re-queue the buffer
       return NULL;
 
    // Attempt to return rx buffer if found in receive list
@@ -477,7 +480,7 @@ struct DmaBuffer *dmaRetBufferIdx(struct DmaDevice *dev, uint32_t index) {
    // Attempt to return buffer to the transmit queue
    if ((buff = dmaGetBufferList(&(dev->txBuffers), index)) != NULL) {
       dmaBufferFromHw(buff);
-      dmaQueuePush(&(dev->tq), buff);
+      dmaTxBufferPush(dev, buff);
       return NULL;
 
    // Attempt to retrieve and return the buffer from the receive queue
@@ -512,7 +515,7 @@ struct DmaBuffer *dmaRetBufferIdxIrq(struct DmaDevice *dev, uint32_t index) {
    // Attempt to return buffer to transmit queue if found
    if ((buff = dmaGetBufferList(&(dev->txBuffers), index)) != NULL) {
       dmaBufferFromHw(buff);
-      dmaQueuePushIrq(&(dev->tq), buff);
+      dmaTxBufferPush(dev, buff);
       return NULL;
 
    // Attempt to return buffer from receive queue if found
@@ -533,11 +536,28 @@ struct DmaBuffer *dmaRetBufferIdxIrq(struct DmaDevice *dev, uint32_t index) {
  *
  * This function pushes a buffer to the descriptor's receive queue. It is
  * intended to be called outside of IRQ context. Before pushing, it ensures
- * the buffer is ready for software processing.
+ * the buffer is ready for software processing. The caller holds the device
+ * maskLock, which keeps the per-destination queue mode from changing.
  */
 void dmaRxBuffer(struct DmaDesc *desc, struct DmaBuffer *buff) {
    dmaBufferFromHw(buff);
-   dmaQueuePush(&(desc->q), buff);
+   if (buff->zcRegion != NULL)
+      dmaRxZcReceive(desc, buff);
+
+   buff->chainNext = NULL;
+   if ((desc->rxChain != NULL) && ((buff = dmaRxChain(desc, buff)) == NULL))
+      return;
+
+   if (desc->dev->rxStamp > 0)
+      buff->pushNs = ktime_get_ns();
+   dmaLcMarkFrame(desc->dev, buff, DMA_LC_DELIVER);
+
+   if (((desc->destQ == NULL) || dmaDestQueuePush(desc, buff)) && dmaQueuePush(&(desc->q), buff))
+      dmaStatsOverflow(desc->dev, buff);
+   trace_dma_queue_push(desc, buff);
+
+   if (desc->rxEvent != NULL)
+      dmaRxEvent(desc);
    if (desc->async_queue)
       kill_fasync(&desc->async_queue, SIGIO, POLL_IN);
 }
@@ -553,9 +573,333 @@ void dmaRxBuffer(struct DmaDesc *desc, struct DmaBuffer *buff) {
  */
 void dmaRxBufferIrq(struct DmaDesc *desc, struct DmaBuffer *buff) {
    dmaBufferFromHw(buff);
-   dmaQueuePushIrq(&(desc->q), buff);
+   if (buff->zcRegion != NULL)
+      dmaRxZcReceive(desc, buff);
+
+   buff->chainNext = NULL;
+   if ((desc->rxChain != NULL) && ((buff = dmaRxChain(desc, buff)) == NULL))
+      return;
+
+   if (desc->dev->rxStamp > 0)
+      buff->pushNs = ktime_get_ns();
+   dmaLcMarkFrame(desc->dev, buff, DMA_LC_DELIVER);
+
+   if (((desc->destQ == NULL) || dmaDestQueuePush(desc, buff)) && dmaQueuePushIrq(&(desc->q), buff))
+      dmaStatsOverflow(desc->dev, buff);
+   trace_dma_queue_push(desc, buff);
+
+   if (desc->rxEvent != NULL)
+      dmaRxEvent(desc);
+   if (desc->async_queue)
+      kill_fasync(&desc->async_queue, SIGIO, POLL_IN);
+}
+
+/**
+ * dmaRxStamp - Record the harvest time and sequence number of a received buffer
+ * @dev: pointer to the DmaDevice structure
+ * @buff: received buffer with dest and flags already set
+ * @now: harvest time in ns, 0 while no descriptor uses extended read records
+ *
+ * Called by the card layer under the device maskLock before the owner of
+ * the buffer is looked up. The sequence number of a destination advances
+ * once per frame, all buffers of a continued frame share it. It also
+ * advances for frames that are dropped for lack of an owner, so a reader
+ * sees lost frames as gaps.
+ */
+void dmaRxStamp(struct DmaDevice *dev, struct DmaBuffer *buff, uint64_t now) {
+   buff->harvestNs = now;
+   buff->pushNs = 0;
+
+   if (buff->dest >= DMA_MAX_DEST) {
+      buff->seq = 0;
+      return;
+   }
+
+   buff->seq = dev->rxSeq[buff->dest];
+   if ((buff->flags & 0x10000) == 0)
+      dev->rxSeq[buff->dest]++;
+}
+
+/**
+ * dmaStatsGet - Find the per CPU counters of a destination
+ * @dev: pointer to the DmaDevice structure
+ * @dest: destination
+ *
+ * Return: Per CPU counters of @dest, or NULL if its block is not allocated.
+ */
+struct DmaDestStats __percpu *dmaStatsGet(struct DmaDevice *dev, uint32_t dest) {
+   struct DmaDestStats __percpu *st;
+
+   if (dest >= DMA_MAX_DEST) return NULL;
+   if ((st = READ_ONCE(dev->destStats[dest / DMA_STATS_BLOCK])) == NULL) return NULL;
+   return st + (dest % DMA_STATS_BLOCK);
+}
+
+/**
+ * dmaStatsRx - Count a received buffer
+ * @dev: pointer to the DmaDevice structure
+ * @buff: received buffer with dest, flags, size and error set
+ *
+ * Called by the card layer for every harvested buffer. The per CPU
+ * updates are safe from any context and take no lock.
+ */
+void dmaStatsRx(struct DmaDevice *dev, struct DmaBuffer *buff) {
+   struct DmaDestStats __percpu *st;
+
+   if ((st = dmaStatsGet(dev, buff->dest)) == NULL) return;
+
+   if ((buff->flags & 0x10000) == 0) this_cpu_inc(st->rxFrames);
+   this_cpu_add(st->rxBytes, buff->size);
+
+   if (unlikely(buff->error != 0)) {
+      if (buff->error & DMA_ERR_FIFO) this_cpu_inc(st->rxErrFifo);
+      if (buff->error & DMA_ERR_LEN)  this_cpu_inc(st->rxErrLen);
+      if (buff->error & DMA_ERR_MAX)  this_cpu_inc(st->rxErrMax);
+      if (buff->error & DMA_ERR_BUS)  this_cpu_inc(st->rxErrBus);
+   }
+}
+
+/**
+ * dmaStatsDrop - Count a received buffer dropped for lack of an owner
+ * @dev: pointer to the DmaDevice structure
+ * @buff: dropped buffer
+ */
+void dmaStatsDrop(struct DmaDevice *dev, struct DmaBuffer *buff) {
+   struct DmaDestStats __percpu *st;
+
+   if ((st = dmaStatsGet(dev, buff->dest)) != NULL) this_cpu_inc(st->rxDrop);
+}
+
+/**
+ * dmaStatsOverflow - Count a received buffer lost to a full receive queue
+ * @dev: pointer to the DmaDevice structure
+ * @buff: lost buffer
+ */
+void dmaStatsOverflow(struct DmaDevice *dev, struct DmaBuffer *buff) {
+   struct DmaDestStats __percpu *st;
+
+   if ((st = dmaStatsGet(dev, buff->dest)) != NULL) this_cpu_inc(st->rxOverflow);
+}
+
+/**
+ * dmaStatsTx - Count a buffer submitted for transmit
+ * @dev: pointer to the DmaDevice structure
+ * @buff: transmit buffer with dest, flags and size set
+ */
+void dmaStatsTx(struct DmaDevice *dev, struct DmaBuffer *buff) {
+   struct DmaDestStats __percpu *st;
+
+   if ((st = dmaStatsGet(dev, buff->dest)) == NULL) return;
+
+   if ((buff->flags & 0x10000) == 0) this_cpu_inc(st->txFrames);
+   this_cpu_add(st->txBytes, buff->size);
+}
+
+#ifdef DMA_LIFECYCLE
+
+/**
+ * dmaLcAdd - Add a sample to a lifecycle histogram
+ * @dev: pointer to the DmaDevice structure
+ * @stage: lifecycle stage, DMA_LC_*
+ * @ns: time spent in the stage in ns
+ */
+void dmaLcAdd(struct DmaDevice *dev, uint32_t stage, uint64_t ns) {
+   struct DmaLcHist *h;
+   uint64_t max;
+   uint32_t bin;
+
+   h = &(dev->lc[stage]);
+   bin = (ns == 0) ? 0 : (fls64(ns) - 1);
+   if (bin >= DMA_LC_BINS) bin = DMA_LC_BINS - 1;
+
+   atomic64_inc(&(h->count));
+   atomic64_add(ns, &(h->total));
+   atomic64_inc(&(h->bin[bin]));
+
+   max = atomic64_read(&(h->max));
+   while ((ns > max) && (atomic64_cmpxchg(&(h->max), max, ns) != max))
+      max = atomic64_read(&(h->max));
+}
+
+/**
+ * dmaLcMark - Record the end of a lifecycle stage of a buffer
+ * @dev: pointer to the DmaDevice structure
+ * @buff: buffer leaving the stage
+ * @stage: stage that ends, DMA_LC_*
+ *
+ * The time since the previous transition of the buffer is added to the
+ * histogram of @stage. The first transition of a buffer only starts its
+ * clock.
+ */
+void dmaLcMark(struct DmaDevice *dev, struct DmaBuffer *buff, uint32_t stage) {
+   uint64_t now;
+
+   now = ktime_get_ns();
+   if (buff->lcTime != 0)
+      dmaLcAdd(dev, stage, now - buff->lcTime);
+   buff->lcTime = now;
+}
+
+/**
+ * dmaLcMarkFrame - Record the end of a lifecycle stage of a frame
+ * @dev: pointer to the DmaDevice structure
+ * @buff: first buffer of the frame
+ * @stage: stage that ends, DMA_LC_*
+ *
+ * Marks every buffer of a reassembled frame. Only valid once the frame
+ * has been delivered, before that chainNext may be stale.
+ */
+void dmaLcMarkFrame(struct DmaDevice *dev, struct DmaBuffer *buff, uint32_t stage) {
+   for (; buff != NULL; buff = buff->chainNext)
+      dmaLcMark(dev, buff, stage);
+}
+
+/**
+ * dmaLcSkip - Exclude the current stage of a buffer from the histograms
+ * @buff: buffer whose stage is not recorded
+ *
+ * The next transition of the buffer only restarts its clock. Used for
+ * buffers the driver recycles without a reader, so their near-zero time
+ * does not skew the return to hardware histogram.
+ */
+void dmaLcSkip(struct DmaBuffer *buff) {
+   buff->lcTime = 0;
+}
+
+#endif
+
+/**
+ * dmaRxChain - Reassemble continued receive buffers into one frame
+ * @desc: pointer to the DmaDesc structure
+ * @buff: pointer to the received DmaBuffer
+ *
+ * Buffers with the continue bit (flags[16]) set are held on the open
+ * chain of their destination until the buffer completing the frame
+ * arrives. The frame is then queued as its first buffer, with the
+ * remaining buffers linked through chainNext. A chain reaching the
+ * descriptor's rxChainMax buffers is queued with the continue bit still
+ * set in its last buffer. Called with the device maskLock held, which
+ * also protects the open chains.
+ *
+ * Return: The first buffer of a completed frame, or NULL if the frame
+ *         continues in a later buffer.
+ */
+struct DmaBuffer *dmaRxChain(struct DmaDesc *desc, struct DmaBuffer *buff) {
+   struct DmaBuffer *head;
+
+   head = desc->rxChain[buff->dest];
+
+   // Start of a frame
+   if (head == NULL) {
+      if ((buff->flags & 0x10000) == 0) return buff;
+
+      buff->chainTail = buff;
+      buff->chainCount = 1;
+      desc->rxChain[buff->dest] = buff;
+      return NULL;
+   }
+
+   // Continuation of an open frame
+   head->chainTail->chainNext = buff;
+   head->chainTail = buff;
+   head->chainCount++;
+
+   if ((buff->flags & 0x10000) && (head->chainCount < desc->rxChainMax))
+      return NULL;
+
+   desc->rxChain[buff->dest] = NULL;
+   return head;
+}
+
+/**
+ * dmaRxSmallPut - Write to the small frame ring
+ * @desc: pointer to the DmaDesc structure owning the ring
+ * @pos: free running ring position
+ * @src: data to write
+ * @size: number of bytes, wrapping at the end of the ring
+ */
+void dmaRxSmallPut(struct DmaDesc *desc, uint32_t pos, void *src, uint32_t size) {
+   uint32_t off;
+   uint32_t len;
+
+   off = pos & (desc->rxSmallSize - 1);
+   len = min_t(uint32_t, size, desc->rxSmallSize - off);
+
+   memcpy(desc->rxSmall + off, src, len);
+   if (len < size) memcpy(desc->rxSmall, src + len, size - len);
+}
+
+/**
+ * dmaRxSmallGet - Read from the small frame ring
+ * @desc: pointer to the DmaDesc structure owning the ring
+ * @pos: free running ring position
+ * @dst: kernel destination
+ * @size: number of bytes, wrapping at the end of the ring
+ */
+void dmaRxSmallGet(struct DmaDesc *desc, uint32_t pos, void *dst, uint32_t size) {
+   uint32_t off;
+   uint32_t len;
+
+   off = pos & (desc->rxSmallSize - 1);
+   len = min_t(uint32_t, size, desc->rxSmallSize - off);
+
+   memcpy(dst, desc->rxSmall + off, len);
+   if (len < size) memcpy(dst + len, desc->rxSmall, size - len);
+}
+
+/**
+ * dmaRxSmall - Copy a small received frame into the descriptor ring
+ * @desc: pointer to the DmaDesc structure receiving the buffer
+ * @buff: pointer to the received DmaBuffer
+ *
+ * Frames up to rxSmallMax bytes are packed into the ring with a
+ * DmaPackedHdr, so that the buffer can be returned to the hardware at
+ * once instead of waiting for the reader. A frame is only copied while
+ * the receive queue is empty, which keeps every frame in the ring older
+ * than every queued buffer; the reader drains the ring first. Frames
+ * which are part of a continued frame, received into a user region or
+ * which do not fit in the ring are queued as usual. Called by the card
+ * layer with the device maskLock held.
+ *
+ * Return: 1 if the frame was copied and the buffer must be returned to
+ *         the hardware, 0 if it is to be queued.
+ */
+uint32_t dmaRxSmall(struct DmaDesc *desc, struct DmaBuffer *buff) {
+   struct DmaPackedHdr hdr;
+   uint32_t head;
+   uint32_t len;
+
+   if ((desc->rxSmall == NULL) || (buff->size > desc->rxSmallMax) || (buff->zcRegion != NULL)) return 0;
+   if ((buff->flags & 0x10000) || (desc->destQ != NULL) || dmaQueueNotEmpty(&(desc->q))) return 0;
+   if ((desc->rxChain != NULL) && (desc->rxChain[buff->dest] != NULL)) return 0;
+
+   head = desc->rxSmallHead;
+   len  = sizeof(struct DmaPackedHdr) + DMA_PACKED_ALIGN(buff->size);
+
+   // Ring full, the buffer is queued and later frames follow it
+   if ((head - READ_ONCE(desc->rxSmallTail) + len) > desc->rxSmallSize) return 0;
+
+   dmaBufferFromHw(buff);
+
+   hdr.size  = buff->size;
+   hdr.dest  = buff->dest;
+   hdr.flags = buff->flags;
+   hdr.error = buff->error;
+
+   dmaRxSmallPut(desc, head, &hdr, sizeof(struct DmaPackedHdr));
+   dmaRxSmallPut(desc, head + sizeof(struct DmaPackedHdr), buff->buffAddr, buff->size);
+
+   // Publish the record after its data
+   smp_wmb();
+   WRITE_ONCE(desc->rxSmallHead, head + len);
+
+   wake_up_interruptible(&(desc->q.wait));
+
+   if (desc->rxEvent != NULL)
+      dmaRxEvent(desc);
    if (desc->async_queue)
       kill_fasync(&desc->async_queue, SIGIO, POLL_IN);
+   return 1;
 }
 
 /**
@@ -570,6 +914,93 @@ void dmaSortBuffers(struct DmaBufferList *list) {
       sort(list->sorted, list->count, sizeof(struct DmaBuffer *), dmaSortComp, NULL);//NOLINT
 }
 
+/**
+ * dmaBufferSyncSize - Number of buffer bytes in use
+ * @buff: pointer to the DMA buffer
+ * @toDevice: non-zero when the buffer is handed to the device
+ *
+ * For a transmit buffer this is the frame being sent, bytes past it are
+ * never read by the device. For a receive buffer this is the frame the
+ * hardware completed, the driver only touches those bytes when it copies
+ * or drops the frame. A receive buffer user space held by index is
+ * synced in full when it goes back to the device, the mapping is writable
+ * and any cache line of it may have been dirtied.
+ *
+ * Return: Size in bytes to sync, 0 for a buffer which was never used.
+ */
+uint32_t dmaBufferSyncSize(struct DmaBuffer *buff, uint32_t toDevice) {
+   if (toDevice && buff->userDirty && (buff->buffList->direction != DMA_TO_DEVICE))
+      return buff->buffList->dev->cfgSize;
+
+   if (buff->size == 0) return 0;
+
+   return min_t(uint32_t, buff->size, buff->buffList->dev->cfgSize);
+}
+
+/**
+ * dmaBufferCounts - Buffer state counters of the statistics page
+ * @buff: pointer to the DMA buffer
+ *
+ * The user, in hardware, queued for hardware and queued counts of a
+ * buffer list follow each other in struct DmaStatsPage, starting at
+ * rxUser for receive and txUser for transmit buffers.
+ *
+ * Return: Pointer to the user count of the buffer's list, NULL without a page.
+ */
+uint32_t *dmaBufferCounts(struct DmaBuffer *buff) {
+   struct DmaDevice *dev;
+
+   dev = buff->buffList->dev;
+   if (dev->statsPage == NULL) return NULL;
+
+   return (buff->buffList == &(dev->txBuffers)) ? &(dev->statsPage->txUser) : &(dev->statsPage->rxUser);
+}
+
+/**
+ * dmaBufferSetState - Update the hardware and queue flags of a buffer
+ * @buff: pointer to the DMA buffer
+ * @inHw: new in hardware flag
+ * @inQ: new queued flag
+ *
+ * Moves the buffer between the running state counts of the statistics
+ * page, so the page never needs to scan the buffers. The counts use the
+ * states of the proc file: in hardware, queued for hardware and queued.
+ */
+void dmaBufferSetState(struct DmaBuffer *buff, uint8_t inHw, uint8_t inQ) {
+   uint32_t *cnt;
+   uint32_t from;
+   uint32_t to;
+
+   // Index after the user count, 0 for a buffer in none of the states
+   from = buff->inHw ? (buff->inQ ? 2 : 1) : (buff->inQ ? 3 : 0);
+   to   = inHw ? (inQ ? 2 : 1) : (inQ ? 3 : 0);
+
+   buff->inHw = inHw;
+   buff->inQ  = inQ;
+
+   if ((from == to) || ((cnt = dmaBufferCounts(buff)) == NULL)) return;
+
+   if (from != 0) atomic_dec((atomic_t *)&(cnt[from]));
+   if (to != 0) atomic_inc((atomic_t *)&(cnt[to]));
+}
+
+/**
+ * dmaBufferSetUser - Update the user space holder of a buffer
+ * @buff: pointer to the DMA buffer
+ * @desc: descriptor now holding the buffer, NULL when it is returned
+ *
+ * Keeps the user count of the statistics page current.
+ */
+void dmaBufferSetUser(struct DmaBuffer *buff, struct DmaDesc *desc) {
+   uint32_t *cnt;
+
+   if (((buff->userHas == NULL) != (desc == NULL)) && ((cnt = dmaBufferCounts(buff)) != NULL)) {
+      if (desc != NULL) atomic_inc((atomic_t *)cnt);
+      else atomic_dec((atomic_t *)cnt);
+   }
+   buff->userHas = desc;
+}
+
 /**
  * dmaBufferToHw - Prepare and pass a DMA buffer to hardware
  * @buff: pointer to the DMA buffer to be passed to hardware
@@ -577,20 +1008,24 @@ void dmaSortBuffers(struct DmaBufferList *list) {
  * Prepares a DMA buffer for hardware access by synchronizing it for device use.
  * This function is called when a buffer is about to be passed to the hardware,
  * typically for DMA operations. It handles stream mode buffers by performing
- * necessary DMA sync operations.
+ * necessary DMA sync operations, limited to the bytes in use.
  *
  * Returns 0 on success, or -1 on error.
  */
 int32_t dmaBufferToHw(struct DmaBuffer *buff) {
-   // Check if buffer is in stream mode and sync
-   if (buff->buffList->dev->cfgMode & BUFF_STREAM) {
+   uint32_t size;
+
+   // Check if buffer is in stream mode and sync, zero-copy data is synced when posted
+   if ((buff->buffList->dev->cfgMode & BUFF_STREAM) && (buff->zcRegion == NULL) &&
+       ((size = dmaBufferSyncSize(buff, 1)) > 0)) {
       dma_sync_single_for_device(buff->buffList->dev->device,
                                  buff->buffHandle,
-                                 buff->buffList->dev->cfgSize,
+                                 size,
                                  buff->buffList->direction);
+      buff->userDirty = 0;
    }
 
-   buff->inHw = 1;
+   dmaBufferSetState(buff, 1, buff->inQ);
    return 0;
 }
 
@@ -601,16 +1036,21 @@ int32_t dmaBufferToHw(struct DmaBuffer *buff) {
  * Marks a DMA buffer as no longer being in hardware use and performs necessary
  * synchronization for CPU access. This function is called when a buffer is
  * returned from the hardware, typically after DMA operations are completed.
- * It handles stream mode buffers by performing necessary DMA sync operations.
+ * It handles stream mode buffers by performing necessary DMA sync operations,
+ * limited to the bytes in use. The card sets the size of a received buffer
+ * before it is returned.
  */
 void dmaBufferFromHw(struct DmaBuffer *buff) {
-   buff->inHw = 0;
+   uint32_t size;
 
-   // Check if buffer is in stream mode and sync
-   if (buff->buffList->dev->cfgMode & BUFF_STREAM) {
+   dmaBufferSetState(buff, 0, buff->inQ);
+
+   // Check if buffer is in stream mode and sync, the buffer is unused by zero-copy
+   if ((buff->buffList->dev->cfgMode & BUFF_STREAM) && (buff->zcRegion == NULL) &&
+       ((size = dmaBufferSyncSize(buff, 0)) > 0)) {
       dma_sync_single_for_cpu(buff->buffList->dev->device,
                               buff->buffHandle,
-                              buff->buffList->dev->cfgSize,
+                              size,
                               buff->buffList->direction);
    }
 }
@@ -705,6 +1145,19 @@ uint32_t dmaQueueNotEmpty(struct DmaQueue *queue) {
       return 1;
 }
 
+/**
+ * dmaQueueCount - Number of entries currently in the DMA queue.
+ * @queue: pointer to the DmaQueue structure to be checked.
+ *
+ * The count is taken without the queue lock and is only a snapshot,
+ * suitable for load balancing decisions.
+ *
+ * Return: Number of queued entries.
+ */
+uint32_t dmaQueueCount(struct DmaQueue *queue) {
+   return ((queue->write + queue->count - queue->read) % queue->count);
+}
+
 /**
  * dmaQueuePush - Push a queue entry.
  * @queue: pointer to the DMA queue structure.
@@ -738,7 +1191,7 @@ uint32_t dmaQueuePush(struct DmaQueue *queue, struct DmaBuffer *entry) {
       // Add the entry to the queue and update the write index
       queue->queue[queue->write / BUFFERS_PER_LIST][queue->write % BUFFERS_PER_LIST] = entry;
       queue->write = next;
-      entry->inQ = 1;  // Mark the buffer as queued
+      dmaBufferSetState(entry, entry->inHw, 1);  // Mark the buffer as queued
    }
 
    // Release the spinlock and restore interrupts
@@ -780,7 +1233,7 @@ uint32_t dmaQueuePushIrq(struct DmaQueue *queue, struct DmaBuffer *entry) {
       // Safely add the entry to the queue and mark it as in the queue.
       queue->queue[queue->write / BUFFERS_PER_LIST][queue->write % BUFFERS_PER_LIST] = entry;
       queue->write = next;
-      entry->inQ = 1;
+      dmaBufferSetState(entry, entry->inHw, 1);
    }
 
    spin_unlock(&(queue->lock));
@@ -830,7 +1283,7 @@ uint32_t dmaQueuePushList(struct DmaQueue *queue, struct DmaBuffer **buff, size_
          // Enqueue the buffer into the queue and mark it as in the queue
          queue->queue[queue->write / BUFFERS_PER_LIST][queue->write % BUFFERS_PER_LIST] = buff[x];
          queue->write = next;
-         buff[x]->inQ = 1;
+         dmaBufferSetState(buff[x], buff[x]->inHw, 1);
       }
    }
 
@@ -880,7 +1333,7 @@ uint32_t dmaQueuePushListIrq(struct DmaQueue *queue, struct DmaBuffer **buff, si
          // Properly place buffer in queue and mark it as in queue.
          queue->queue[queue->write / BUFFERS_PER_LIST][queue->write % BUFFERS_PER_LIST] = buff[x];
          queue->write = next;
-         buff[x]->inQ = 1;  // Mark buffer as enqueued.
+         dmaBufferSetState(buff[x], buff[x]->inHw, 1);  // Mark buffer as enqueued.
       }
    }
    spin_unlock(&(queue->lock));
@@ -918,7 +1371,7 @@ struct DmaBuffer * dmaQueuePop(struct DmaQueue *queue ) {
       queue->read = (queue->read + 1) % (queue->count);
 
       // Mark the buffer as not in queue
-      ret->inQ = 0;
+      dmaBufferSetState(ret, ret->inHw, 0);
    }
    spin_unlock_irqrestore(&(queue->lock), iflags);
    return ret;
@@ -952,7 +1405,7 @@ struct DmaBuffer *dmaQueuePopIrq(struct DmaQueue *queue) {
       queue->read = (queue->read + 1) % (queue->count);
 
       // Mark the buffer as not in queue
-      ret->inQ = 0;
+      dmaBufferSetState(ret, ret->inHw, 0);
    }
 
    spin_unlock(&(queue->lock));
@@ -990,7 +1443,7 @@ ssize_t dmaQueuePopList(struct DmaQueue *queue, struct DmaBuffer **buff, size_t
       queue->read = (queue->read + 1) % (queue->count);
 
       // Mark the buffer as no longer in the queue
-      buff[ret]->inQ = 0;
+      dmaBufferSetState(buff[ret], buff[ret]->inHw, 0);
       ret++;
    }
 
@@ -1000,6 +1453,46 @@ ssize_t dmaQueuePopList(struct DmaQueue *queue, struct DmaBuffer **buff, size_t
    return ret;
 }
 
+/**
+ * dmaQueuePopFit - Retrieve buffers from a queue while their frames fit
+ * @queue: pointer to the DmaQueue to pop from
+ * @buff: array receiving the first buffer of each frame
+ * @cnt: maximum number of frames
+ * @space: bytes available for packed records, reduced by the records taken
+ *
+ * Each frame needs a DmaPackedHdr and its padded data. The first frame
+ * which does not fit stays at the head of the queue.
+ *
+ * Return: The number of frames popped.
+ */
+ssize_t dmaQueuePopFit(struct DmaQueue *queue, struct DmaBuffer **buff, size_t cnt, uint32_t *space) {
+   struct DmaBuffer *next;
+   unsigned long iflags;
+   uint32_t size;
+   uint32_t len;
+   ssize_t ret;
+
+   ret = 0;
+   spin_lock_irqsave(&(queue->lock), iflags);
+
+   while ( (ret < cnt) && (queue->read != queue->write) ) {
+      buff[ret] = queue->queue[queue->read / BUFFERS_PER_LIST][queue->read % BUFFERS_PER_LIST];
+
+      for (size = 0, next = buff[ret]; next != NULL; next = next->chainNext) size += next->size;
+      len = sizeof(struct DmaPackedHdr) + DMA_PACKED_ALIGN(size);
+
+      if (len > *space) break;
+      *space -= len;
+
+      queue->read = (queue->read + 1) % (queue->count);
+      dmaBufferSetState(buff[ret], buff[ret]->inHw, 0);
+      ret++;
+   }
+
+   spin_unlock_irqrestore(&(queue->lock), iflags);
+   return ret;
+}
+
 /**
  * dmaQueuePopListIrq - Retrieve a block of buffers from a queue within an IRQ handler context.
  *
@@ -1032,7 +1525,7 @@ ssize_t dmaQueuePopListIrq(struct DmaQueue *queue, struct DmaBuffer **buff, size
       queue->read = (queue->read + 1) % (queue->count);
 
       // Mark the buffer as no longer in the queue
-      buff[ret]->inQ = 0;
+      dmaBufferSetState(buff[ret], buff[ret]->inHw, 0);
       ret++;
    }
 
@@ -1066,3 +1559,622 @@ void dmaQueuePoll(struct DmaQueue *queue, struct file *filp, poll_table *wait) {
 void dmaQueueWait(struct DmaQueue *queue) {
    wait_event_interruptible(queue->wait, (queue->read != queue->write));
 }
+
+/**
+ * dmaDestQueuePush - Push buffer to a descriptor's per-destination queue
+ * @desc: pointer to the DmaDesc structure
+ * @buff: pointer to the DmaBuffer to be pushed, buff->dest must be valid
+ *
+ * Appends the buffer to the queue of its destination and marks the
+ * destination ready. The per-destination queues share the lock and wait
+ * queue of the descriptor's receive queue.
+ *
+ * Return: 0 on success, 1 if per-destination queues are not enabled.
+ */
+uint32_t dmaDestQueuePush(struct DmaDesc *desc, struct DmaBuffer *buff) {
+   unsigned long iflags;
+   uint32_t ret;
+
+   spin_lock_irqsave(&(desc->q.lock), iflags);
+
+   if (desc->destQ == NULL) {
+      ret = 1;
+   } else {
+      list_add_tail(&(buff->destLink), &(desc->destQ[buff->dest]));
+      __set_bit(buff->dest, desc->destReady);
+      desc->destCount++;
+      dmaBufferSetState(buff, buff->inHw, 1);
+      ret = 0;
+   }
+
+   spin_unlock_irqrestore(&(desc->q.lock), iflags);
+
+   if (ret == 0)
+      wake_up_interruptible(&(desc->q.wait));
+
+   return ret;
+}
+
+/**
+ * dmaDestQueueTake - Remove the oldest buffer of a destination
+ * @desc: pointer to the DmaDesc structure
+ * @dest: destination to take from, must have a non-empty queue
+ *
+ * The caller must hold the descriptor receive queue lock.
+ *
+ * Return: Pointer to the removed DmaBuffer.
+ */
+struct DmaBuffer *dmaDestQueueTake(struct DmaDesc *desc, uint32_t dest) {
+   struct DmaBuffer *buff;
+
+   buff = list_first_entry(&(desc->destQ[dest]), struct DmaBuffer, destLink);
+   list_del(&(buff->destLink));
+   dmaBufferSetState(buff, buff->inHw, 0);
+   desc->destCount--;
+
+   if (list_empty(&(desc->destQ[dest])))
+      __clear_bit(dest, desc->destReady);
+
+   return buff;
+}
+
+/**
+ * dmaDestQueuePopList - Dequeue buffers from per-destination queues
+ * @desc: pointer to the DmaDesc structure
+ * @dests: destinations in priority order, or NULL for all destinations
+ * @destCnt: number of entries in @dests
+ * @buff: array to receive the dequeued buffers
+ * @cnt: maximum number of buffers to dequeue
+ *
+ * With a destination list, each listed destination is drained in order
+ * before moving to the next one. Without a list, ready destinations are
+ * visited in rotation one buffer at a time so that no destination is
+ * starved by another.
+ *
+ * Return: The number of buffers dequeued, 0 if none are available or
+ *         per-destination queues are not enabled.
+ */
+ssize_t dmaDestQueuePopList(struct DmaDesc *desc, uint32_t *dests, uint32_t destCnt, struct DmaBuffer **buff, size_t cnt) {
+   unsigned long iflags;
+   ssize_t ret;
+   uint32_t dest;
+   uint32_t x;
+
+   ret = 0;
+   spin_lock_irqsave(&(desc->q.lock), iflags);
+
+   if (desc->destQ != NULL) {
+      // Drain destinations in the requested order
+      if (dests != NULL) {
+         for (x = 0; (x < destCnt) && (ret < cnt); x++) {
+            if (dests[x] >= DMA_MAX_DEST) continue;
+
+            while ((ret < cnt) && !list_empty(&(desc->destQ[dests[x]])))
+               buff[ret++] = dmaDestQueueTake(desc, dests[x]);
+         }
+
+      // Rotate over the ready destinations
+      } else {
+         while ((ret < cnt) && (desc->destCount > 0)) {
+            dest = find_next_bit(desc->destReady, DMA_MAX_DEST, desc->destNext);
+            if (dest >= DMA_MAX_DEST) dest = find_first_bit(desc->destReady, DMA_MAX_DEST);
+
+            buff[ret++] = dmaDestQueueTake(desc, dest);
+            desc->destNext = (dest + 1) % DMA_MAX_DEST;
+         }
+      }
+   }
+
+   spin_unlock_irqrestore(&(desc->q.lock), iflags);
+   return ret;
+}
+
+/**
+ * dmaTxBufferGrant - Hand free transmit buffers to waiting writers
+ * @dev: pointer to the DmaDevice structure
+ *
+ * Waiting writers below their reservation are woken first, their buffers
+ * are already held back from the shared pool. The remaining shared buffers
+ * are granted in deficit round-robin order: the writer at the head of the
+ * wait list receives up to its quantum of buffers and then leaves the list,
+ * rejoining at the tail if it runs out again. A writer is only woken once
+ * it holds its low-watermark of buffers or leaves the list, so each
+ * returned buffer wakes at most one writer. Grants not taken within
+ * DMA_TX_GRANT_MS, such as those of a poller which never writes, return
+ * to the shared pool first. The caller must hold dev->txLock.
+ */
+void dmaTxBufferGrant(struct DmaDevice *dev) {
+   struct DmaDesc *desc;
+   struct DmaDesc *next;
+   uint32_t free;
+
+   // Expire stale grants, writers still on the wait list keep collecting
+   list_for_each_entry_safe(desc, next, &(dev->txGranted), txGrantLink) {
+      if (list_empty(&(desc->txWaitLink)) &&
+          time_after(jiffies, desc->txGrantTime + msecs_to_jiffies(DMA_TX_GRANT_MS))) {
+         dev->txHeld -= desc->txGrant;
+         desc->txGrant = 0;
+         list_del_init(&(desc->txGrantLink));
+      }
+   }
+
+   if ((free = dmaQueueCount(&(dev->tq))) == 0) {
+      dmaTxEventCheck(dev);
+      return;
+   }
+
+   // Writers waiting on their reservation
+   list_for_each_entry_safe(desc, next, &(dev->txWaiters), txWaitLink) {
+      if ((desc->txInUse < desc->txReserve) && (free >= desc->txLowat)) {
+         list_del_init(&(desc->txWaitLink));
+         dmaTxWake(desc);
+      }
+   }
+
+   // Deficit round-robin over the shared buffers
+   while ((free > dev->txHeld) && !list_empty(&(dev->txWaiters))) {
+      desc = list_first_entry(&(dev->txWaiters), struct DmaDesc, txWaitLink);
+
+      // Writer is woken by its own completions once below its cap
+      if ((desc->txLimit != 0) && ((desc->txInUse + desc->txGrant) >= desc->txLimit)) {
+         list_del_init(&(desc->txWaitLink));
+         continue;
+      }
+
+      desc->txGrant++;
+      dev->txHeld++;
+
+      desc->txGrantTime = jiffies;
+      if (list_empty(&(desc->txGrantLink)))
+         list_add_tail(&(desc->txGrantLink), &(dev->txGranted));
+
+      if (--desc->txDeficit == 0)
+         list_del_init(&(desc->txWaitLink));
+
+      if ((desc->txGrant >= desc->txLowat) || list_empty(&(desc->txWaitLink)))
+         dmaTxWake(desc);
+   }
+
+   dmaTxEventCheck(dev);
+}
+
+/**
+ * dmaTxBufferRoom - Number of transmit buffers a writer may take now
+ * @dev: pointer to the DmaDevice structure
+ * @desc: pointer to the writing descriptor
+ *
+ * Counts the writer's grants and unused reservation, plus the unheld
+ * buffers when no writer is waiting. The caller must hold dev->txLock.
+ *
+ * Return: Number of buffers, limited to the free buffer count.
+ */
+uint32_t dmaTxBufferRoom(struct DmaDevice *dev, struct DmaDesc *desc) {
+   uint32_t free;
+   uint32_t room;
+
+   free = dmaQueueCount(&(dev->tq));
+   room = desc->txGrant;
+
+   if (desc->txInUse < desc->txReserve)
+      room += (desc->txReserve - desc->txInUse);
+
+   if ((free > dev->txHeld) && list_empty(&(dev->txWaiters)))
+      room += (free - dev->txHeld);
+
+   return (room < free) ? room : free;
+}
+
+/**
+ * dmaTxBufferAvail - Check whether a writer may take transmit buffers
+ * @dev: pointer to the DmaDevice structure
+ * @desc: pointer to the writing descriptor
+ * @need: number of buffers required
+ *
+ * A writer below its reservation or holding a grant may take any free
+ * buffer. Otherwise it may only take an unheld buffer when no other
+ * writer is waiting. A writer which can not take @need buffers joins the
+ * tail of the wait list, unless it would exceed its cap. The caller must
+ * hold dev->txLock.
+ *
+ * Return: Non-zero if @need buffers may be taken, 0 otherwise.
+ */
+uint32_t dmaTxBufferAvail(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t need) {
+   if ((desc->txLimit != 0) && ((desc->txInUse + need) > desc->txLimit)) return 0;
+
+   if (dmaTxBufferRoom(dev, desc) >= need) return 1;
+
+   // Wait for grants
+   if (list_empty(&(desc->txWaitLink))) {
+      list_add_tail(&(desc->txWaitLink), &(dev->txWaiters));
+      desc->txDeficit = (desc->txQuantum > need) ? desc->txQuantum : need;
+   }
+   dmaTxBufferGrant(dev);
+
+   return (dmaTxBufferRoom(dev, desc) >= need);
+}
+
+/**
+ * dmaTxBufferReady - Check whether a write would get a transmit buffer
+ * @dev: pointer to the DmaDevice structure
+ * @desc: pointer to the writing descriptor
+ *
+ * Locked wrapper of dmaTxBufferAvail for the poll path, requiring the
+ * descriptor's low-watermark number of buffers.
+ *
+ * Return: Non-zero if the buffers may be taken, 0 otherwise.
+ */
+uint32_t dmaTxBufferReady(struct DmaDevice *dev, struct DmaDesc *desc) {
+   unsigned long iflags;
+   uint32_t ret;
+
+   spin_lock_irqsave(&(dev->txLock), iflags);
+   ret = dmaTxBufferAvail(dev, desc, desc->txLowat);
+   spin_unlock_irqrestore(&(dev->txLock), iflags);
+   return ret;
+}
+
+/**
+ * dmaTxBufferPop - Take a transmit buffer for a writer
+ * @dev: pointer to the DmaDevice structure
+ * @desc: pointer to the writing descriptor
+ *
+ * Takes a buffer from the transmit queue if the writer's reservation, cap
+ * and the fair share policy allow it, and charges the buffer to the writer
+ * until it is returned with dmaTxBufferPush.
+ *
+ * Return: Pointer to the buffer, or NULL if none may be taken.
+ */
+struct DmaBuffer *dmaTxBufferPop(struct DmaDevice *dev, struct DmaDesc *desc) {
+   struct DmaBuffer *buff;
+   unsigned long iflags;
+
+   buff = NULL;
+   spin_lock_irqsave(&(dev->txLock), iflags);
+
+   if (dmaTxBufferAvail(dev, desc, 1)) {
+      // Consume the reservation or grant the buffer was held for
+      if (desc->txInUse < desc->txReserve) {
+         dev->txHeld--;
+      } else if (desc->txGrant > 0) {
+         desc->txGrant--;
+         dev->txHeld--;
+
+         desc->txGrantTime = jiffies;
+         if (desc->txGrant == 0) list_del_init(&(desc->txGrantLink));
+      }
+
+      if ((buff = dmaQueuePop(&(dev->tq))) != NULL) {
+         buff->txOwner = desc;
+         desc->txInUse++;
+      }
+      dmaTxEventCheck(dev);
+   }
+
+   spin_unlock_irqrestore(&(dev->txLock), iflags);
+   return buff;
+}
+
+/**
+ * dmaTxBufferPush - Return a transmit buffer to the free pool
+ * @dev: pointer to the DmaDevice structure
+ * @buff: pointer to the returned DmaBuffer
+ *
+ * Releases the charge against the owning writer and grants the buffer to
+ * the next waiting writer. May be called from interrupt context.
+ */
+void dmaTxBufferPush(struct DmaDevice *dev, struct DmaBuffer *buff) {
+   struct DmaDesc *desc;
+   unsigned long iflags;
+
+   spin_lock_irqsave(&(dev->txLock), iflags);
+
+   if (buff->zcRegion != NULL)
+      dmaTxZcDone(dev, buff);
+
+   if ((desc = buff->txOwner) != NULL) {
+      buff->txOwner = NULL;
+      desc->txInUse--;
+
+      // Buffer returns to the owner's reservation
+      if (desc->txInUse < desc->txReserve) dev->txHeld++;
+
+      // Owner was held at its cap
+      if ((desc->txLimit != 0) && ((desc->txInUse + desc->txLowat) == desc->txLimit))
+         dmaTxWake(desc);
+   }
+
+   dmaQueuePush(&(dev->tq), buff);
+   dmaTxBufferGrant(dev);
+
+   spin_unlock_irqrestore(&(dev->txLock), iflags);
+}
+
+/**
+ * dmaTxBufferDetach - Remove a closing writer from transmit accounting
+ * @dev: pointer to the DmaDevice structure
+ * @desc: pointer to the closing descriptor
+ *
+ * Releases the writer's reservation and grants and clears its charge on
+ * buffers still owned by the hardware.
+ */
+void dmaTxBufferDetach(struct DmaDevice *dev, struct DmaDesc *desc) {
+   struct DmaBuffer *buff;
+   unsigned long iflags;
+   uint32_t x;
+
+   spin_lock_irqsave(&(dev->txLock), iflags);
+
+   list_del_init(&(desc->txWaitLink));
+   list_del_init(&(desc->txGrantLink));
+   list_del_init(&(desc->txEventLink));
+
+   dev->txHeld -= desc->txGrant;
+   if (desc->txInUse < desc->txReserve)
+      dev->txHeld -= (desc->txReserve - desc->txInUse);
+   dev->txReserved -= desc->txReserve;
+
+   desc->txGrant = 0;
+   desc->txReserve = 0;
+
+   for (x = dev->txBuffers.baseIdx; x < (dev->txBuffers.baseIdx + dev->txBuffers.count); x++) {
+      buff = dmaGetBufferList(&(dev->txBuffers), x);
+      if (buff->txOwner == desc) buff->txOwner = NULL;
+   }
+
+   dmaTxBufferGrant(dev);
+   spin_unlock_irqrestore(&(dev->txLock), iflags);
+}
+
+/**
+ * dmaEventSignal - Signal an eventfd context
+ * @ctx: eventfd context to signal
+ *
+ * Adds one to the eventfd counter, hiding the change of the
+ * eventfd_signal() arguments in newer kernels.
+ */
+void dmaEventSignal(struct eventfd_ctx *ctx) {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0)
+   eventfd_signal(ctx);
+#else
+   eventfd_signal(ctx, 1);
+#endif
+}
+
+/**
+ * dmaRxEvent - Signal receive readiness to a bound eventfd
+ * @desc: pointer to the DmaDesc structure which received a buffer
+ *
+ * Signals when the frame arrives at an empty queue, or once per
+ * rxCoalesce frames while the reader is behind. A reader must drain
+ * the queue after each notification. Called with the device maskLock
+ * held, which also protects the binding.
+ */
+void dmaRxEvent(struct DmaDesc *desc) {
+   desc->rxEventPend++;
+
+   if ((desc->rxEventPend >= desc->rxCoalesce) || ((dmaQueueCount(&(desc->q)) + desc->destCount) <= 1)) {
+      desc->rxEventPend = 0;
+      dmaEventSignal(desc->rxEvent);
+   }
+}
+
+/**
+ * dmaTxWake - Notify a writer that transmit buffers are available
+ * @desc: pointer to the DmaDesc structure of the writer
+ *
+ * Wakes pollers of the descriptor and signals a bound eventfd. Called
+ * with dev->txLock held, which also protects the binding.
+ */
+void dmaTxWake(struct DmaDesc *desc) {
+   wake_up_interruptible(&(desc->txWait));
+
+   if (desc->txEvent != NULL)
+      dmaEventSignal(desc->txEvent);
+}
+
+/**
+ * dmaTxEventCheck - Signal transmit eventfds on buffer availability
+ * @dev: pointer to the DmaDevice structure
+ *
+ * Signals each bound transmit eventfd once when the writer goes from no
+ * buffers to at least one buffer it may take, whether or not the writer
+ * is waiting for a grant. The writer is signalled again after its room
+ * drops back to zero. The caller must hold dev->txLock.
+ */
+void dmaTxEventCheck(struct DmaDevice *dev) {
+   struct DmaDesc *desc;
+   uint32_t room;
+
+   list_for_each_entry(desc, &(dev->txEvents), txEventLink) {
+      if ((desc->txLimit != 0) && (desc->txInUse >= desc->txLimit)) room = 0;
+      else room = dmaTxBufferRoom(dev, desc);
+
+      if (room == 0) {
+         desc->txEventReady = 0;
+      } else if (!desc->txEventReady) {
+         desc->txEventReady = 1;
+         dmaEventSignal(desc->txEvent);
+      }
+   }
+}
+
+/**
+ * dmaTxZcDone - Complete a zero-copy transmit buffer
+ * @dev: pointer to the DmaDevice structure
+ * @buff: pointer to the returned DmaBuffer
+ *
+ * Releases the buffer's hold on its user region. The last buffer of a
+ * frame adds the frame tag to the owner's completion ring and wakes the
+ * owner. A closed owner no longer collects completions, its released
+ * region is freed once its last buffer returns. The caller must hold
+ * dev->txLock.
+ */
+void dmaTxZcDone(struct DmaDevice *dev, struct DmaBuffer *buff) {
+   struct DmaDesc *desc;
+
+   // Last buffer of a released region, free it outside of interrupt context
+   if ((--buff->zcRegion->inFlight == 0) && buff->zcRegion->closing)
+      schedule_work(&(dev->zcWork));
+
+   if ((desc = buff->txOwner) != NULL) {
+      desc->zcInFlight--;
+
+      if (buff->zcLast) {
+         desc->zcDone[(desc->zcDoneRead + desc->zcDoneCount) % dev->cfgTxCount] = buff->zcTag;
+         desc->zcDoneCount++;
+         dmaTxWake(desc);
+      }
+   }
+
+   buff->zcRegion = NULL;
+   buff->zcLast = 0;
+}
+
+/**
+ * dmaZcSync - Synchronize part of a zero-copy region
+ * @dev: pointer to the DmaDevice structure
+ * @rg: region holding the data
+ * @off: offset of the data in the region
+ * @size: size of the data in bytes
+ * @toDevice: non-zero to hand the data to the device, zero to hand it to the CPU
+ *
+ * Each page of the region is a separate DMA mapping, the range is synced
+ * page by page in the direction of the region.
+ */
+void dmaZcSync(struct DmaDevice *dev, struct DmaZcRegion *rg, uint64_t off, uint64_t size, uint32_t toDevice) {
+   uint64_t pos;
+   uint32_t len;
+
+   for (pos = (rg->addr & ~PAGE_MASK) + off; size > 0; pos += len, size -= len) {
+      len = min_t(uint64_t, size, PAGE_SIZE - (pos & ~PAGE_MASK));
+
+      if (toDevice)
+         dma_sync_single_range_for_device(dev->device, rg->handle[pos >> PAGE_SHIFT], pos & ~PAGE_MASK, len, rg->dir);
+      else
+         dma_sync_single_range_for_cpu(dev->device, rg->handle[pos >> PAGE_SHIFT], pos & ~PAGE_MASK, len, rg->dir);
+   }
+}
+
+/**
+ * dmaZcCopy - Copy data out of a zero-copy region into kernel memory
+ * @rg: region holding the data
+ * @off: offset of the data in the region
+ * @dst: kernel destination
+ * @size: size of the data in bytes
+ *
+ * Reads the pinned pages through a temporary kernel mapping, may be
+ * called in interrupt context.
+ */
+void dmaZcCopy(struct DmaZcRegion *rg, uint64_t off, void *dst, uint32_t size) {
+   uint64_t pos;
+   uint32_t len;
+   void *src;
+
+   for (pos = (rg->addr & ~PAGE_MASK) + off; size > 0; pos += len, size -= len, dst += len) {
+      len = min_t(uint64_t, size, PAGE_SIZE - (pos & ~PAGE_MASK));
+
+      src = kmap_atomic(rg->pages[pos >> PAGE_SHIFT]);
+      memcpy(dst, src + (pos & ~PAGE_MASK), len);
+      kunmap_atomic(src);
+   }
+}
+
+/**
+ * dmaRxZcAttach - Select the memory a receive buffer is posted with
+ * @buff: pointer to the receive DmaBuffer being handed to the hardware
+ *
+ * A buffer keeps the user region slot it carries, unless the region has
+ * been released, in which case the slot is given back. A buffer without
+ * a slot takes the next free slot of any receive region. Called by the
+ * card layer when it posts a free receive buffer, may be called in
+ * interrupt context.
+ *
+ * Return: The DMA address to post, the slot address or the buffer's own.
+ */
+dma_addr_t dmaRxZcAttach(struct DmaBuffer *buff) {
+   struct DmaDevice *dev;
+   struct DmaZcRegion *rg;
+   unsigned long iflags;
+   uint32_t detach;
+   uint32_t size;
+   uint64_t pos;
+
+   dev = buff->buffList->dev;
+   detach = 0;
+   size = dmaBufferSyncSize(buff, 1);
+
+   // No receive regions registered
+   if ((buff->zcRegion == NULL) && list_empty(&(dev->zcRxList)))
+      return buff->buffHandle;
+
+   spin_lock_irqsave(&(dev->zcRxLock), iflags);
+
+   // Give back the slot of a released region
+   if (((rg = buff->zcRegion) != NULL) && rg->closing) {
+      rg->attached--;
+      detach = 1;
+      buff->zcRegion = NULL;
+      buff->zcUser = 0;
+
+      // Last slot is back, free the region outside of interrupt context
+      if (rg->attached == 0) schedule_work(&(dev->zcWork));
+   }
+
+   // Take a free slot
+   if (buff->zcRegion == NULL) {
+      list_for_each_entry(rg, &(dev->zcRxList), link) {
+         if ((!rg->closing) && (rg->slotNext < rg->slotCount)) {
+            pos = (rg->addr & ~PAGE_MASK) + rg->slot[rg->slotNext];
+
+            buff->zcRegion = rg;
+            buff->zcTag    = rg->slot[rg->slotNext++];
+            buff->zcHandle = rg->handle[pos >> PAGE_SHIFT] + (pos & ~PAGE_MASK);
+            rg->attached++;
+
+            // The user may have written anywhere in a new slot
+            size = dev->cfgSize;
+            break;
+         }
+      }
+   }
+
+   rg = buff->zcRegion;
+   spin_unlock_irqrestore(&(dev->zcRxLock), iflags);
+
+   // Own memory was not synced while it carried a slot, frames may have been copied into any part of it
+   if (rg == NULL) {
+      if (detach) {
+         buff->userDirty = 1;
+         dmaBufferToHw(buff);
+      }
+      return buff->buffHandle;
+   }
+
+   if (size > 0) dmaZcSync(dev, rg, buff->zcTag, size, 1);
+   buff->userDirty = 0;
+   return buff->zcHandle;
+}
+
+/**
+ * dmaRxZcReceive - Complete a receive buffer which carries a user slot
+ * @desc: pointer to the DmaDesc structure receiving the buffer
+ * @buff: pointer to the received DmaBuffer
+ *
+ * The data stays in place when the reader owns the region, otherwise it
+ * is copied into the buffer's own memory so that the frame reaches its
+ * reader as a normal buffer. The region can not be freed while the
+ * buffer carries its slot.
+ */
+void dmaRxZcReceive(struct DmaDesc *desc, struct DmaBuffer *buff) {
+   struct DmaZcRegion *rg;
+
+   rg = buff->zcRegion;
+   dmaZcSync(desc->dev, rg, buff->zcTag, dmaBufferSyncSize(buff, 0), 0);
+
+   if ((rg->owner == desc) && (!rg->closing)) {
+      buff->zcUser = 1;
+   } else {
+      dmaZcCopy(rg, buff->zcTag, buff->buffAddr, buff->size);
+      buff->zcUser = 0;
+   }
+}
@@ -27,6 +27,8 @@
 #include <linux/poll.h>
 #include <linux/wait.h>
 #include <linux/types.h>
+#include <linux/list.h>
+#include <linux/rbtree.h>
 #include <linux/dma-mapping.h>
 
 /**
@@ -47,6 +49,8 @@
 struct DmaDevice;
 struct DmaDesc;
 struct DmaBufferList;
+struct DmaZcRegion;
+struct eventfd_ctx;
 
 /**
  * struct DmaBuffer - TX/RX Buffer
@@ -64,6 +68,24 @@ struct DmaBufferList;
  * @buffList: Pointer to the buffer list containing this buffer.
  * @buffAddr: Virtual address of the buffer.
  * @buffHandle: DMA handle for the buffer.
+ * @destLink: Link in a per-destination receive queue.
+ * @txOwner: Descriptor charged for a transmit buffer while it is in use.
+ * @txTime: Time in ns the buffer entered a transmit hold queue.
+ * @launch: Requested launch time in ns of a scheduled transmit buffer.
+ * @launchNode: Node in the device queue of scheduled transmit buffers.
+ * @chainNext: Next buffer of a reassembled receive frame.
+ * @chainTail: Last buffer of a frame being reassembled, valid in the first buffer.
+ * @chainCount: Number of buffers in a frame being reassembled, valid in the first buffer.
+ * @zcRegion: User region a zero-copy transmit buffer is sent from, or NULL.
+ * @zcHandle: DMA address of the zero-copy data.
+ * @zcTag: User tag reported when the frame completes.
+ * @zcLast: Set on the last buffer of a zero-copy frame.
+ * @zcUser: Set when received data was left in the user region of the reader.
+ * @userDirty: Set when user space held the buffer by index since its last device sync.
+ * @harvestNs: Time in ns the receive completion was harvested, 0 when not stamped.
+ * @pushNs: Time in ns the frame was pushed to the receive queue, 0 when not stamped.
+ * @seq: Per destination receive sequence number of the frame.
+ * @lcTime: Time in ns of the last lifecycle transition, with DMA_LIFECYCLE.
  *
  * Represents a buffer for transmitting or receiving data, including metadata
  * for management and tracking.
@@ -83,6 +105,26 @@ struct DmaBuffer {
    struct DmaBufferList * buffList;
    void      * buffAddr;
    dma_addr_t  buffHandle;
+   struct list_head destLink;
+   struct DmaDesc * txOwner;
+   uint64_t         txTime;
+   uint64_t         launch;
+   struct rb_node   launchNode;
+   struct DmaBuffer * chainNext;
+   struct DmaBuffer * chainTail;
+   uint32_t         chainCount;
+   struct DmaZcRegion * zcRegion;
+   dma_addr_t       zcHandle;
+   uint64_t         zcTag;
+   uint8_t          zcLast;
+   uint8_t          zcUser;
+   uint8_t          userDirty;
+   uint64_t         harvestNs;
+   uint64_t         pushNs;
+   uint32_t         seq;
+#ifdef DMA_LIFECYCLE
+   uint64_t         lcTime;
+#endif
 };
 
 /**
@@ -147,12 +189,41 @@ struct DmaBuffer *dmaRetBufferIdx(struct DmaDevice *device, uint32_t index);
 struct DmaBuffer *dmaRetBufferIdxIrq(struct DmaDevice *device, uint32_t index);
 void dmaRxBuffer(struct DmaDesc *desc, struct DmaBuffer *buff);
 void dmaRxBufferIrq(struct DmaDesc *desc, struct DmaBuffer *buff);
+void dmaRxStamp(struct DmaDevice *dev, struct DmaBuffer *buff, uint64_t now);
+
+struct DmaDestStats __percpu *dmaStatsGet(struct DmaDevice *dev, uint32_t dest);
+void dmaStatsRx(struct DmaDevice *dev, struct DmaBuffer *buff);
+void dmaStatsDrop(struct DmaDevice *dev, struct DmaBuffer *buff);
+void dmaStatsOverflow(struct DmaDevice *dev, struct DmaBuffer *buff);
+void dmaStatsTx(struct DmaDevice *dev, struct DmaBuffer *buff);
+
+// Buffer lifecycle histograms, compiled out unless built with DMA_LIFECYCLE=1
+#ifdef DMA_LIFECYCLE
+void dmaLcAdd(struct DmaDevice *dev, uint32_t stage, uint64_t ns);
+void dmaLcMark(struct DmaDevice *dev, struct DmaBuffer *buff, uint32_t stage);
+void dmaLcMarkFrame(struct DmaDevice *dev, struct DmaBuffer *buff, uint32_t stage);
+void dmaLcSkip(struct DmaBuffer *buff);
+#else
+#define dmaLcAdd(dev, stage, ns) do { } while (0)
+#define dmaLcMark(dev, buff, stage) do { } while (0)
+#define dmaLcMarkFrame(dev, buff, stage) do { } while (0)
+#define dmaLcSkip(buff) do { } while (0)
+#endif
+void dmaRxSmallPut(struct DmaDesc *desc, uint32_t pos, void *src, uint32_t size);
+void dmaRxSmallGet(struct DmaDesc *desc, uint32_t pos, void *dst, uint32_t size);
+uint32_t dmaRxSmall(struct DmaDesc *desc, struct DmaBuffer *buff);
+struct DmaBuffer *dmaRxChain(struct DmaDesc *desc, struct DmaBuffer *buff);
 void dmaSortBuffers(struct DmaBufferList *list);
+uint32_t dmaBufferSyncSize(struct DmaBuffer *buff, uint32_t toDevice);
+uint32_t *dmaBufferCounts(struct DmaBuffer *buff);
+void dmaBufferSetState(struct DmaBuffer *buff, uint8_t inHw, uint8_t inQ);
+void dmaBufferSetUser(struct DmaBuffer *buff, struct DmaDesc *desc);
 int32_t dmaBufferToHw(struct DmaBuffer *buff);
 void dmaBufferFromHw(struct DmaBuffer *buff);
 size_t dmaQueueInit(struct DmaQueue *queue, uint32_t count);
 void dmaQueueFree(struct DmaQueue *queue);
 uint32_t dmaQueueNotEmpty(struct DmaQueue *queue);
+uint32_t dmaQueueCount(struct DmaQueue *queue);
 uint32_t dmaQueuePush(struct DmaQueue *queue, struct DmaBuffer *entry);
 uint32_t dmaQueuePushIrq(struct DmaQueue *queue, struct DmaBuffer *entry);
 uint32_t dmaQueuePushList(struct DmaQueue *queue, struct DmaBuffer **buff, size_t cnt);
@@ -160,8 +231,28 @@ uint32_t dmaQueuePushListIrq(struct DmaQueue *queue, struct DmaBuffer **buff, si
 struct DmaBuffer *dmaQueuePop(struct DmaQueue *queue);
 struct DmaBuffer *dmaQueuePopIrq(struct DmaQueue *queue);
 ssize_t dmaQueuePopList(struct DmaQueue *queue, struct DmaBuffer **buff, size_t cnt);
+ssize_t dmaQueuePopFit(struct DmaQueue *queue, struct DmaBuffer **buff, size_t cnt, uint32_t *space);
 ssize_t dmaQueuePopListIrq(struct DmaQueue *queue, struct DmaBuffer **buff, size_t cnt);
 void dmaQueuePoll(struct DmaQueue *queue, struct file *filp, poll_table *wait);
 void dmaQueueWait(struct DmaQueue *queue);
+uint32_t dmaDestQueuePush(struct DmaDesc *desc, struct DmaBuffer *buff);
+struct DmaBuffer *dmaDestQueueTake(struct DmaDesc *desc, uint32_t dest);
+void dmaTxBufferGrant(struct DmaDevice *dev);
+uint32_t dmaTxBufferRoom(struct DmaDevice *dev, struct DmaDesc *desc);
+uint32_t dmaTxBufferAvail(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t need);
+uint32_t dmaTxBufferReady(struct DmaDevice *dev, struct DmaDesc *desc);
+struct DmaBuffer *dmaTxBufferPop(struct DmaDevice *dev, struct DmaDesc *desc);
+void dmaTxBufferPush(struct DmaDevice *dev, struct DmaBuffer *buff);
+void dmaTxBufferDetach(struct DmaDevice *dev, struct DmaDesc *desc);
+void dmaEventSignal(struct eventfd_ctx *ctx);
+void dmaRxEvent(struct DmaDesc *desc);
+void dmaTxWake(struct DmaDesc *desc);
+void dmaTxEventCheck(struct DmaDevice *dev);
+void dmaTxZcDone(struct DmaDevice *dev, struct DmaBuffer *buff);
+void dmaZcSync(struct DmaDevice *dev, struct DmaZcRegion *rg, uint64_t off, uint64_t size, uint32_t toDevice);
+void dmaZcCopy(struct DmaZcRegion *rg, uint64_t off, void *dst, uint32_t size);
+dma_addr_t dmaRxZcAttach(struct DmaBuffer *buff);
+void dmaRxZcReceive(struct DmaDesc *desc, struct DmaBuffer *buff);
+ssize_t dmaDestQueuePopList(struct DmaDesc *desc, uint32_t *dests, uint32_t destCnt, struct DmaBuffer **buff, size_t cnt);
 
 #endif  // __DMA_BUFFER_H__
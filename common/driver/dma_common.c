@@ -22,12 +22,27 @@
 #include <DmaDriver.h>
 #include <dma_common.h>
 #include <dma_buffer.h>
+
+// Tracepoints are created here, the other sources only use them
+#define CREATE_TRACE_POINTS
+#include <dma_trace.h>
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
 #include <linux/interrupt.h>
 #include <linux/sched.h>
 #include <linux/version.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 11, 0)
+#include <linux/sched/signal.h>
+#endif
 #include <linux/slab.h>
+#include <linux/bitmap.h>
+#include <linux/vmalloc.h>
+#include <linux/eventfd.h>
+#include <linux/mm.h>
+#include <linux/log2.h>
+#include <linux/debugfs.h>
+#include <linux/percpu.h>
+#include <linux/delay.h>
 
 /**
  * struct DmaFunctions - Define interface routines for DMA operations
@@ -122,6 +137,35 @@ static struct seq_operations DmaSeqOps = {
    .show  = Dma_SeqShow     ///< Display the current element
 };
 
+/**
+ * struct DmaStatsOps - debugfs file operations for the destination counters
+ */
+static const struct file_operations DmaStatsOps = {
+   .owner   = THIS_MODULE,
+   .open    = Dma_StatsOpen,
+   .read    = seq_read,
+   .llseek  = seq_lseek,
+   .release = single_release
+};
+
+#ifdef DMA_LIFECYCLE
+
+/**
+ * struct DmaLcOps - debugfs file operations for the lifecycle histograms
+ *
+ * Reading shows the histograms, any write resets them.
+ */
+static const struct file_operations DmaLcOps = {
+   .owner   = THIS_MODULE,
+   .open    = Dma_LcOpen,
+   .read    = seq_read,
+   .write   = Dma_LcWrite,
+   .llseek  = seq_lseek,
+   .release = single_release
+};
+
+#endif
+
 /**
  * gDmaDevCount - Number of active DMA devices.
  */
@@ -132,6 +176,18 @@ uint32_t gDmaDevCount;
  */
 struct class *gCl;
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 3, 0)
+/**
+ * gDmaDebugKey - Enabled while any device has debug output set.
+ */
+DEFINE_STATIC_KEY_FALSE(gDmaDebugKey);
+#endif
+
+/**
+ * gDmaDebugLock - Serializes debug level changes with the static key count.
+ */
+DEFINE_MUTEX(gDmaDebugLock);
+
 /**
  * Dma_DevNode - Devnode callback to set permissions of created devices.
  * @dev: Pointer to the device structure.
@@ -269,6 +325,26 @@ int Dma_Init(struct DmaDevice *dev) {
       goto cleanup_device_create;
    }
 
+   // Per destination counters of the first block, the others are allocated when claimed
+   spin_lock_init(&(dev->statsLock));
+   if (Dma_StatsAlloc(dev, 0) < 0) {
+      dev_err(dev->device, "Init: Failed to allocate destination counters.\n");
+      goto cleanup_proc_create_data;
+   }
+
+   // Statistics page shared with user space
+   if (Dma_StatsPageInit(dev) < 0) {
+      dev_err(dev->device, "Init: Failed to allocate statistics page.\n");
+      goto cleanup_proc_create_data;
+   }
+
+   // Setup debugfs, not fatal if debugfs is unavailable
+   dev->debugDir = debugfs_create_dir(dev->devName, NULL);
+   debugfs_create_file("dest_stats", 0444, dev->debugDir, dev, &DmaStatsOps);
+#ifdef DMA_LIFECYCLE
+   debugfs_create_file("lifecycle", 0644, dev->debugDir, dev, &DmaLcOps);
+#endif
+
    // Remap the I/O register block for safe access
    if ( Dma_MapReg(dev) < 0 ) {
       dev_err(dev->device, "Init: Failed to map register block.\n");
@@ -276,12 +352,43 @@ int Dma_Init(struct DmaDevice *dev) {
    }
 
    // Initialize descriptors
-   for (x=0; x < DMA_MAX_DEST; x++) dev->desc[x] = NULL;
+   for (x=0; x < DMA_MAX_DEST; x++) {
+      dev->desc[x]  = NULL;
+      dev->group[x] = NULL;
+   }
+   bitmap_zero(dev->destBusy, DMA_MAX_DEST);
 
    // Initialize locks
    spin_lock_init(&(dev->writeHwLock));
    spin_lock_init(&(dev->commandLock));
    spin_lock_init(&(dev->maskLock));
+   spin_lock_init(&(dev->txLock));
+   INIT_LIST_HEAD(&(dev->txWaiters));
+   INIT_LIST_HEAD(&(dev->txGranted));
+   INIT_LIST_HEAD(&(dev->txEvents));
+   dev->txHeld = 0;
+   dev->txReserved = 0;
+
+   // Zero-copy regions
+   spin_lock_init(&(dev->zcRxLock));
+   INIT_LIST_HEAD(&(dev->zcRxList));
+   INIT_LIST_HEAD(&(dev->zcTxList));
+   INIT_WORK(&(dev->zcWork), Dma_ZcWork);
+
+   // Receive sequence numbers and timestamps
+   memset(dev->rxSeq, 0, sizeof(dev->rxSeq));
+   dev->rxStamp = 0;
+
+   // Scheduled transmit queue
+   spin_lock_init(&(dev->launchLock));
+   dev->launchQ = RB_ROOT;
+   dev->launchCount = 0;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+   hrtimer_setup(&(dev->launchTimer), Dma_LaunchTimer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+#else
+   hrtimer_init(&(dev->launchTimer), CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+   dev->launchTimer.function = Dma_LaunchTimer;
+#endif
 
    // Create TX buffers
    dev_info(dev->device, "Init: Creating %i TX Buffers. Size=%i Bytes. Mode=%i.\n",
@@ -358,6 +465,8 @@ cleanup_dma_mapreg:
    Dma_UnmapReg(dev);
 
 cleanup_proc_create_data:
+   debugfs_remove_recursive(dev->debugDir);
+   Dma_StatsFree(dev);
    remove_proc_entry(dev->devName, NULL);
 
 cleanup_device_create:
@@ -390,16 +499,49 @@ cleanup_alloc_chrdev_region:
  * driver registration and class destruction if this is the last device.
  */
 void Dma_Clean(struct DmaDevice *dev) {
+   struct DmaZcRegion *rg;
+   struct DmaBuffer *buff;
    uint32_t x;
 
+   // Stop scheduled transmit and pacing, held frames are freed with the buffers.
+   hrtimer_cancel(&(dev->launchTimer));
+   for (x = 0; x < DMA_MAX_DEST; x++) {
+      if (dev->pacer[x] != NULL) {
+         hrtimer_cancel(&(dev->pacer[x]->timer));
+         kfree(dev->pacer[x]);
+         dev->pacer[x] = NULL;
+      }
+   }
+
    // Call card-specific clear function.
    dev->hwFunc->clear(dev);
 
+   // Drop the device from the debug key count
+   Dma_SetDebug(dev, 0);
+
    // Release IRQ if allocated.
    if (dev->irq != 0) {
       free_irq(dev->irq, dev);
    }
 
+   // Take back the slots of zero-copy receive regions, the hardware is stopped
+   cancel_work_sync(&(dev->zcWork));
+   list_for_each_entry(rg, &(dev->zcRxList), link) rg->closing = 1;
+
+   for (x = dev->rxBuffers.baseIdx; x < (dev->rxBuffers.baseIdx + dev->rxBuffers.count); x++) {
+      buff = dmaGetBufferList(&(dev->rxBuffers), x);
+
+      if (buff->zcRegion != NULL) {
+         buff->zcRegion->attached--;
+         buff->zcRegion = NULL;
+      }
+   }
+   Dma_RxZcReap(dev);
+
+   // Transmit buffers still held by released regions will not return
+   list_for_each_entry(rg, &(dev->zcTxList), link) rg->inFlight = 0;
+   Dma_TxZcReap(dev);
+
    // Free RX and TX buffers.
    dmaFreeBuffers(&(dev->rxBuffers));
    dmaFreeBuffers(&(dev->txBuffers));
@@ -407,15 +549,19 @@ void Dma_Clean(struct DmaDevice *dev) {
    // Clear the transmission queue.
    dmaQueueFree(&(dev->tq));
 
-   // Clear descriptors if they exist.
+   // Clear descriptors and shared groups if they exist.
    for (x = 0; x < DMA_MAX_DEST; x++) {
       dev->desc[x] = NULL;
+      kfree(dev->group[x]);
+      dev->group[x] = NULL;
    }
 
    // Unmap device registers.
    Dma_UnmapReg(dev);
 
-   // Remove proc entry and delete character device.
+   // Remove debugfs and proc entries and delete character device.
+   debugfs_remove_recursive(dev->debugDir);
+   Dma_StatsFree(dev);
    remove_proc_entry(dev->devName, NULL);
    cdev_del(&(dev->charDev));
 
@@ -471,6 +617,13 @@ int Dma_Open(struct inode *inode, struct file *filp) {
    dmaQueueInit(&(desc->q), dev->cfgRxCount);
    desc->async_queue = NULL;
    desc->dev = dev;
+   desc->txQuantum = 1;
+   desc->txLowat = 1;
+   INIT_LIST_HEAD(&(desc->txWaitLink));
+   INIT_LIST_HEAD(&(desc->txGrantLink));
+   INIT_LIST_HEAD(&(desc->txEventLink));
+   init_waitqueue_head(&(desc->txWait));
+   mutex_init(&(desc->rxSmallLock));
 
    // Store the descriptor in the file's private data for later use
    filp->private_data = desc;
@@ -498,8 +651,6 @@ int Dma_Release(struct inode *inode, struct file *filp) {
    unsigned long iflags;
    uint32_t x;
    uint32_t cnt;
-   uint32_t destByte;
-   uint32_t destBit;
 
    // Obtain device and descriptor from file's private data
    desc = (struct DmaDesc *)filp->private_data;
@@ -509,27 +660,43 @@ int Dma_Release(struct inode *inode, struct file *filp) {
    spin_lock_irqsave(&dev->maskLock, iflags);
 
    // Clear device descriptor pointers based on destMask
-   for (x = 0; x < DMA_MAX_DEST; x++) {
-      destByte = x / 8;
-      destBit = 1 << (x % 8);
-      if ((destBit & desc->destMask[destByte]) != 0) {
-         dev->desc[x] = NULL;
-      }
-   }
+   for_each_set_bit(x, desc->destMask, DMA_MAX_DEST)
+      dev->desc[x] = NULL;
+
+   bitmap_andnot(dev->destBusy, dev->destBusy, desc->destMask, DMA_MAX_DEST);
+   bitmap_zero(desc->destMask, DMA_MAX_DEST);
+
+   // Stop timestamping if this was the last extended reader
+   if (desc->readExt) dev->rxStamp--;
+   desc->readExt = 0;
 
    // Restore interrupts
    spin_unlock_irqrestore(&dev->maskLock, iflags);
 
+   // Leave any shared destination groups
+   for_each_set_bit(x, desc->groupMask, DMA_MAX_DEST)
+      Dma_LeaveGroup(dev, desc, x);
+
    // Detach from asynchronous notification structures if necessary
    if (desc->async_queue) {
       Dma_Fasync(-1, filp, 0);
    }
 
+   // Release partially received frames and copied out small frames
+   Dma_SetRxChain(dev, desc, 0);
+   vfree(desc->rxSmall);
+
    // Release DMA buffers from the descriptor's queue
    cnt = 0;
-   while ((buff = dmaQueuePop(&(desc->q))) != NULL) {
-      dev->hwFunc->retRxBuffer(dev, &buff, 1);
-      cnt++;
+   while ((buff = dmaQueuePop(&(desc->q))) != NULL)
+      cnt += Dma_RetChain(dev, buff);
+
+   // Release DMA buffers from the per destination queues
+   if (desc->destQ != NULL) {
+      while (dmaDestQueuePopList(desc, NULL, 0, &buff, 1) == 1)
+         cnt += Dma_RetChain(dev, buff);
+      vfree(desc->destQ);
+      desc->destQ = NULL;
    }
    if (cnt > 0) {
       dev_info(dev->device, "Release: Removed %i buffers from closed device.\n", cnt);
@@ -541,7 +708,7 @@ int Dma_Release(struct inode *inode, struct file *filp) {
       buff = dmaGetBufferList(&(dev->rxBuffers), x);
 
       if (buff->userHas == desc) {
-         buff->userHas = NULL;
+         dmaBufferSetUser(buff, NULL);
          dev->hwFunc->retRxBuffer(dev, &buff, 1);
          cnt++;
       }
@@ -550,14 +717,23 @@ int Dma_Release(struct inode *inode, struct file *filp) {
       dev_info(dev->device, "Release: Removed %i rx buffers held by user.\n", cnt);
    }
 
+   // Wait for zero-copy frames still read by the hardware
+   if (desc->zcInFlight > 0)
+      wait_event_timeout(desc->txWait, READ_ONCE(desc->zcInFlight) == 0, msecs_to_jiffies(1000));
+
+   // Drop frames still waiting for their launch time
+   if ((cnt = Dma_LaunchCancel(dev, desc)) > 0) {
+      dev_info(dev->device, "Release: Removed %i scheduled tx buffers.\n", cnt);
+   }
+
    // Release tx buffers still owned by the descriptor
    cnt = 0;
    for (x = dev->txBuffers.baseIdx; x < (dev->txBuffers.baseIdx + dev->txBuffers.count); x++) {
       buff = dmaGetBufferList(&(dev->txBuffers), x);
 
       if (buff->userHas == desc) {
-         buff->userHas = NULL;
-         dmaQueuePush(&(dev->tq), buff);
+         dmaBufferSetUser(buff, NULL);
+         dmaTxBufferPush(dev, buff);
          cnt++;
       }
    }
@@ -565,6 +741,41 @@ int Dma_Release(struct inode *inode, struct file *filp) {
       dev_info(dev->device, "Release: Removed %i tx buffers held by user.\n", cnt);
    }
 
+   // Give up transmit reservations and grants
+   dmaTxBufferDetach(dev, desc);
+
+   // Release zero-copy regions, a transmit region still in use by the hardware is freed by its last completion
+   for (x = 0; x < DMA_MAX_ZC_REGION; x++) {
+      if (desc->zcRegion[x] == NULL) continue;
+
+      // Receive regions are freed once the hardware returns their slots, the owner goes away now
+      if (desc->zcRegion[x]->dir == DMA_FROM_DEVICE) {
+         Dma_RxZcClose(dev, desc->zcRegion[x]);
+         spin_lock_irqsave(&(dev->zcRxLock), iflags);
+         desc->zcRegion[x]->owner = NULL;
+         spin_unlock_irqrestore(&(dev->zcRxLock), iflags);
+         continue;
+      }
+
+      spin_lock_irqsave(&(dev->txLock), iflags);
+      if ((cnt = desc->zcRegion[x]->inFlight) > 0) {
+         desc->zcRegion[x]->closing = 1;
+         list_add_tail(&(desc->zcRegion[x]->link), &(dev->zcTxList));
+      }
+      spin_unlock_irqrestore(&(dev->txLock), iflags);
+
+      if (cnt == 0)
+         Dma_ZcFree(dev, desc->zcRegion[x]);
+      else if (dmaDebug(dev))
+         dev_info(dev->device, "Release: Zero-copy region %i freed after %i buffers return.\n", x, cnt);
+   }
+   kfree(desc->zcDone);
+   Dma_RxZcReap(dev);
+
+   // Release event notification, no further receive or transmit events
+   if (desc->rxEvent != NULL) eventfd_ctx_put(desc->rxEvent);
+   if (desc->txEvent != NULL) eventfd_ctx_put(desc->txEvent);
+
    // Clear the tx queue and free the descriptor
    dmaQueueFree(&(desc->q));
    kfree(desc);
@@ -581,55 +792,156 @@ int Dma_Release(struct inode *inode, struct file *filp) {
  * This function is called when the device is read from. It reads data from a DMA buffer
  * into a user space buffer. It verifies the size of the passed structure, allocates
  * necessary buffers, copies data from kernel space to user space, and handles errors.
+ * After DMA_Set_ReadExt the records are DmaReadDataExt and also carry the receive
+ * timestamps and sequence number of each frame.
  *
  * Return: The number of read structures on success or an error code on failure.
  */
 ssize_t Dma_Read(struct file *filp, char *buffer, size_t count, loff_t *f_pos) {
    struct DmaBuffer **buff;
    struct DmaReadData *rd;
-   void *dp;
+   struct DmaReadDataExt *re;
    ssize_t ret;
+   size_t rSize;
    size_t rCnt;
    ssize_t bCnt;
    ssize_t x;
+   uint8_t ext;
    struct DmaDesc *desc;
    struct DmaDevice *dev;
 
    desc = (struct DmaDesc *)filp->private_data;
    dev = desc->dev;
+   re = NULL;
+
+   // Record format selected by DMA_Set_ReadExt
+   ext = READ_ONCE(desc->readExt);
+   rSize = ext ? sizeof(struct DmaReadDataExt) : sizeof(struct DmaReadData);
 
    // Verify the size of the passed structure
-   if ((count % sizeof(struct DmaReadData)) != 0) {
+   if ((count % rSize) != 0) {
       dev_warn(dev->device, "Read: Called with incorrect size. Got=%li, Exp=%li\n",
-               count, sizeof(struct DmaReadData));
+               count, rSize);
       return -1;
    }
 
-   rCnt = count / sizeof(struct DmaReadData);
+   rCnt = count / rSize;
    rd = (struct DmaReadData *)kzalloc(rCnt * sizeof(struct DmaReadData), GFP_KERNEL);
    buff = (struct DmaBuffer **)kzalloc(rCnt * sizeof(struct DmaBuffer *), GFP_KERNEL);
+   if (ext) re = (struct DmaReadDataExt *)kzalloc(rCnt * sizeof(struct DmaReadDataExt), GFP_KERNEL);
+
+   if ((rd == NULL) || (buff == NULL) || (ext && (re == NULL))) {
+      dev_warn(dev->device, "Read: failed to allocate %li read records.\n", rCnt);
+      kfree(re);
+      kfree(rd);
+      kfree(buff);
+      return -ENOMEM;
+   }
 
    // Copy the read structure from user space
-   if ((ret = copy_from_user(rd, buffer, rCnt * sizeof(struct DmaReadData)))) {
+   if (ext) {
+      if ((ret = copy_from_user(re, buffer, rCnt * sizeof(struct DmaReadDataExt)))) {
+         dev_warn(dev->device, "Read: failed to copy struct from user space ret=%li, user=%p kern=%p\n",
+                  ret, (void *)buffer, (void *)re);
+         kfree(re);
+         kfree(rd);
+         kfree(buff);
+         return -1;
+      }
+
+      for (x = 0; x < rCnt; x++) {
+         rd[x].data = re[x].data;
+         rd[x].size = re[x].size;
+         rd[x].is32 = re[x].is32;
+      }
+
+   } else if ((ret = copy_from_user(rd, buffer, rCnt * sizeof(struct DmaReadData)))) {
       dev_warn(dev->device, "Read: failed to copy struct from user space ret=%li, user=%p kern=%p\n",
                ret, (void *)buffer, (void *)rd);
+      kfree(rd);
+      kfree(buff);
       return -1;
    }
 
    // Get buffers from the DMA queue
-   bCnt = dmaQueuePopList(&(desc->q), buff, rCnt);
+   if (desc->destQ != NULL)
+      bCnt = dmaDestQueuePopList(desc, NULL, 0, buff, rCnt);
+   else
+      bCnt = dmaQueuePopList(&(desc->q), buff, rCnt);
+
+   // Take the stamps before buffers read by copy return to the hardware
+   if (re != NULL) {
+      for (x = 0; x < bCnt; x++) {
+         re[x].harvest = buff[x]->harvestNs;
+         re[x].push = buff[x]->pushNs;
+         re[x].seq = buff[x]->seq;
+      }
+   }
+
+   Dma_ReadBuffers(desc, rd, buff, bCnt);
+   kfree(buff);
+
+   // Copy the read structure back to user space
+   if (re != NULL) {
+      for (x = 0; x < rCnt; x++) {
+         re[x].data = rd[x].data;
+         re[x].dest = rd[x].dest;
+         re[x].flags = rd[x].flags;
+         re[x].index = rd[x].index;
+         re[x].error = rd[x].error;
+         re[x].ret = rd[x].ret;
+      }
+
+      if ((ret = copy_to_user(buffer, re, rCnt * sizeof(struct DmaReadDataExt)))) {
+         dev_warn(dev->device, "Read: failed to copy struct to user space ret=%li, user=%p kern=%p\n",
+                  ret, (void *)buffer, (void *)re);
+      }
+      kfree(re);
+
+   } else if ((ret = copy_to_user(buffer, rd, rCnt * sizeof(struct DmaReadData)))) {
+      dev_warn(dev->device, "Read: failed to copy struct to user space ret=%li, user=%p kern=%p\n",
+               ret, (void *)buffer, (void *)&rd);
+      x = -1;
+   }
+   kfree(rd);
+   return bCnt;
+}
+
+/**
+ * Dma_ReadBuffers - Complete read records for dequeued buffers
+ * @desc: pointer to the DMA descriptor
+ * @rd: read records supplied by the user, updated in place
+ * @buff: buffers dequeued for the descriptor
+ * @bCnt: number of entries in @buff
+ *
+ * Fills each read record from the matching buffer. Records with a data
+ * pointer receive a copy of the frame and the buffer is returned to the
+ * hardware, records without one pass ownership of the buffer index to the
+ * descriptor. A reassembled frame is gathered into the data pointer, it
+ * can not be passed by a single index and is dropped with an error
+ * instead; DMA_Read_Frame returns all of its indexes.
+ */
+void Dma_ReadBuffers(struct DmaDesc *desc, struct DmaReadData *rd, struct DmaBuffer **buff, ssize_t bCnt) {
+   struct DmaDevice *dev;
+   uint32_t size;
+   void *dp;
+   ssize_t x;
+
+   dev = desc->dev;
 
    for (x = 0; x < bCnt; x++) {
+      dmaLcMarkFrame(dev, buff[x], DMA_LC_QUEUE);
+      trace_dma_queue_pop(desc, buff[x]);
+      size = Dma_FrameInfo(buff[x], &(rd[x].flags), &(rd[x].error));
+
       // Report frame error
-      if (buff[x]->error)
-         dev_warn(dev->device, "Read: error encountered 0x%x.\n", buff[x]->error);
+      if (rd[x].error)
+         dev_warn(dev->device, "Read: error encountered 0x%x.\n", rd[x].error);
 
       // Copy associated data to the read structure
       rd[x].dest = buff[x]->dest;
-      rd[x].flags = buff[x]->flags;
       rd[x].index = buff[x]->index;
-      rd[x].error = buff[x]->error;
-      rd[x].ret = buff[x]->size;
+      rd[x].ret = size;
 
       // Convert pointer based on architecture
       if (sizeof(void *) == 4 || rd[x].is32)
@@ -637,44 +949,42 @@ ssize_t Dma_Read(struct file *filp, char *buffer, size_t count, loff_t *f_pos) {
       else
          dp = (void *)rd[x].data;
 
-      // Use index if pointer is zero
-      if (dp == 0) {
-          buff[x]->userHas = desc;
+      // Use index if pointer is zero, data received into a user region is reported by address
+      if ((dp == 0) && (buff[x]->chainNext == NULL)) {
+          dmaBufferSetUser(buff[x], desc);
+          buff[x]->userDirty = 1;
+          if (buff[x]->zcUser) rd[x].data = buff[x]->zcRegion->addr + buff[x]->zcTag;
+
+      // Reassembled frame without a pointer
+      } else if (dp == 0) {
+         dev_warn(dev->device, "Read: reassembled frame of %i bytes can not be read by index.\n", size);
+         rd[x].error |= DMA_ERR_MAX;
+         rd[x].ret = -1;
+         Dma_RetChain(dev, buff[x]);
+
       } else {
          // Warn if user buffer is too small
-         if (rd[x].size < buff[x]->size) {
+         if (rd[x].size < size) {
             dev_warn(dev->device, "Read: user buffer is too small. Rx=%i, User=%i.\n",
-                     buff[x]->size, (int32_t)rd[x].size);
+                     size, (int32_t)rd[x].size);
             rd[x].error |= DMA_ERR_MAX;
             rd[x].ret = -1;
 
          // Copy data to user space
-         } else if ((ret = copy_to_user(dp, buff[x]->buffAddr, buff[x]->size))) {
-            dev_warn(dev->device, "Read: failed to copy data to user space ret=%li, user=%p kern=%p size=%u.\n",
-                     ret, dp, buff[x]->buffAddr, buff[x]->size);
+         } else if (Dma_CopyChain(dev, buff[x], dp) < 0) {
             rd[x].ret = -1;
          }
 
-         // Return entry to RX queue
-         dev->hwFunc->retRxBuffer(dev, &(buff[x]), 1);
+         // Return entries to RX queue
+         Dma_RetChain(dev, buff[x]);
       }
 
       // Debug information
-      if (dev->debug > 0) {
+      if (dmaDebug(dev)) {
          dev_info(dev->device, "Read: Ret=%i, Dest=%i, Flags=0x%.8x, Error=%i.\n",
                   rd[x].ret, rd[x].dest, rd[x].flags, rd[x].error);
       }
    }
-   kfree(buff);
-
-   // Copy the read structure back to user space
-   if ((ret = copy_to_user(buffer, rd, rCnt * sizeof(struct DmaReadData)))) {
-      dev_warn(dev->device, "Read: failed to copy struct to user space ret=%li, user=%p kern=%p\n",
-               ret, (void *)buffer, (void *)&rd);
-      x = -1;
-   }
-   kfree(rd);
-   return bCnt;
 }
 
 /**
@@ -697,40 +1007,35 @@ ssize_t Dma_Write(struct file *filp, const char *buffer, size_t count, loff_t *f
    void *dp;
    struct DmaWriteData wr;
    struct DmaBuffer *buff;
+   struct DmaPacer *pacer;
+   struct DmaWriteSeg seg;
    struct DmaDesc *desc;
    struct DmaDevice *dev;
-   uint32_t destByte;
-   uint32_t destBit;
 
    desc = (struct DmaDesc *)filp->private_data;
    dev = desc->dev;
 
-   // Verify the size of the passed structure
-   if (count != sizeof(struct DmaWriteData)) {
+   // Verify the size of the passed structure, accepting the layout without launch time
+   if ((count != sizeof(struct DmaWriteData)) && (count != offsetof(struct DmaWriteData, launch))) {
       dev_warn(dev->device, "Write: Called with incorrect size. Got=%li, Exp=%li.\n",
                count, sizeof(struct DmaWriteData));
       return -1;
    }
 
    // Copy data structure from user space
-   if ((ret = copy_from_user(&wr, buffer, sizeof(struct DmaWriteData)))) {
+   wr.launch = 0;
+   if ((ret = copy_from_user(&wr, buffer, count))) {
       dev_warn(dev->device, "Write: failed to copy struct from user space ret=%li, user=%p kern=%p.\n",
                ret, (void *)buffer, (void *)&wr);
       return -1;
    }
 
-   // Validate passed size against configuration
-   if (wr.size > dev->cfgSize) {
-      dev_warn(dev->device, "Write: passed size is too large for TX buffer.\n");
-      return -1;
-   }
-
    // Validate destination
-   destByte = wr.dest / 8;
-   destBit = 1 << (wr.dest % 8);
-   if ((wr.dest > DMA_MAX_DEST) || ((destBit & dev->destMask[destByte]) == 0)) {
-      dev_warn(dev->device, "Write: Invalid destination. Byte %i, Got=0x%x. Mask=0x%x.\n",
-               destByte, destBit, dev->destMask[destByte]);
+   if (Dma_TxDestValid(dev, wr.dest) < 0) return -1;
+
+   // Scheduled frames hold a buffer until launch, limit how far ahead
+   if ((wr.launch != 0) && (wr.launch > (ktime_get_ns() + DMA_LAUNCH_MAX_NS))) {
+      dev_warn(dev->device, "Write: launch time more than %llu ns ahead.\n", DMA_LAUNCH_MAX_NS);
       return -1;
    }
 
@@ -741,21 +1046,32 @@ ssize_t Dma_Write(struct file *filp, const char *buffer, size_t count, loff_t *f
        dp = (void *)wr.data;
    }
 
+   // Validate passed size against configuration, larger frames are chained over multiple buffers
+   if (wr.size > dev->cfgSize) {
+      if ((dp == 0) || (wr.launch != 0)) {
+         dev_warn(dev->device, "Write: passed size is too large for TX buffer.\n");
+         return -1;
+      }
+      seg.data = wr.data;
+      seg.size = wr.size;
+      return Dma_WriteChain(dev, desc, &seg, 1, &wr);
+   }
+
    // Use index if pointer is null
    if (dp == 0) {
       if ((buff = dmaGetBuffer(dev, wr.index)) == NULL) {
          dev_warn(dev->device, "Write: Invalid index posted: %i.\n", wr.index);
          return -1;
       }
-      buff->userHas = NULL;
+      dmaBufferSetUser(buff, NULL);
    } else {
       // Retrieve a transmit buffer and copy data from user space
-      if ((buff = dmaQueuePop(&(dev->tq))) == NULL) return 0;
+      if ((buff = dmaTxBufferPop(dev, desc)) == NULL) return 0;
 
       if ((ret = copy_from_user(buff->buffAddr, dp, wr.size))) {
          dev_warn(dev->device, "Write: failed to copy data from user space ret=%li, user=%p kern=%p size=%i.\n",
                   ret, dp, buff->buffAddr, wr.size);
-         dmaQueuePush(&(dev->tq), buff);
+         dmaTxBufferPush(dev, buff);
          return -1;
       }
    }
@@ -766,11 +1082,16 @@ ssize_t Dma_Write(struct file *filp, const char *buffer, size_t count, loff_t *f
    buff->flags = wr.flags;
    buff->size = wr.size;
 
-   // Board-specific buffer handling
-   res = dev->hwFunc->sendBuffer(dev, &buff, 1);
+   // Board-specific buffer handling, scheduled frames and paced destinations are held
+   if (wr.launch != 0)
+      res = Dma_LaunchSend(dev, buff, wr.launch);
+   else if ((pacer = dev->pacer[buff->dest]) != NULL)
+      res = Dma_PacerSend(dev, pacer, &buff, 1);
+   else
+      res = dev->hwFunc->sendBuffer(dev, &buff, 1);
 
    // Log for debugging
-   if (dev->debug > 0) {
+   if (dmaDebug(dev)) {
       dev_info(dev->device, "Write: Size=%i, Dest=%i, Flags=0x%.8x, res=%li\n",
                buff->size, buff->dest, buff->flags, res);
    }
@@ -943,12 +1264,13 @@ ssize_t Dma_Ioctl(struct file *filp, uint32_t cmd, unsigned long arg) {
 
       // Check if read is ready
       case DMA_Read_Ready:
-         return dmaQueueNotEmpty(&(desc->q));
+         return (dmaQueueNotEmpty(&(desc->q)) || (desc->destCount > 0) ||
+                 (READ_ONCE(desc->rxSmallHead) != READ_ONCE(desc->rxSmallTail)));
          break;
 
       // Set debug level
       case DMA_Set_Debug:
-         dev->debug = arg;
+         Dma_SetDebug(dev, arg);
          dev_info(dev->device, "debug set to %u.\n", (uint32_t)arg);
          return 0;
          break;
@@ -966,6 +1288,18 @@ ssize_t Dma_Ioctl(struct file *filp, uint32_t cmd, unsigned long arg) {
          return Dma_SetMaskBytes(dev, desc, newMask);
          break;
 
+      // Attempt to reserve additional destinations
+      case DMA_Add_MaskBytes:
+         if ( copy_from_user(newMask, (void *)arg, DMA_MASK_SIZE) ) return -1;
+         return Dma_AddMaskBytes(dev, desc, newMask);
+         break;
+
+      // Release destinations
+      case DMA_Del_MaskBytes:
+         if ( copy_from_user(newMask, (void *)arg, DMA_MASK_SIZE) ) return -1;
+         return Dma_DelMaskBytes(dev, desc, newMask);
+         break;
+
       // Return buffer index
       case DMA_Ret_Index:
          cnt = (cmd >> 16) & 0xFFFF;
@@ -982,7 +1316,7 @@ ssize_t Dma_Ioctl(struct file *filp, uint32_t cmd, unsigned long arg) {
             if ( (buff = dmaGetBufferList(&(dev->rxBuffers), indexes[x])) != NULL ) {
                // Only return if owned by current desc
                if ( buff->userHas == desc ) {
-                  buff->userHas = NULL;
+                  dmaBufferSetUser(buff, NULL);
                   buffList[bCnt++] = buff;
                }
 
@@ -990,10 +1324,10 @@ ssize_t Dma_Ioctl(struct file *filp, uint32_t cmd, unsigned long arg) {
             } else if ( (buff = dmaGetBufferList(&(dev->txBuffers), indexes[x])) != NULL ) {
                // Only return if owned by current desc
                if ( buff->userHas == desc ) {
-                  buff->userHas = NULL;
+                  dmaBufferSetUser(buff, NULL);
 
                   // Return entry to TX queue
-                  dmaQueuePush(&(dev->tq), buff);
+                  dmaTxBufferPush(dev, buff);
                }
             } else {
                dev_warn(dev->device, "Command: Invalid index posted: %i.\n", indexes[x]);
@@ -1014,15 +1348,15 @@ ssize_t Dma_Ioctl(struct file *filp, uint32_t cmd, unsigned long arg) {
       case DMA_Get_Index:
 
          // Read transmit buffer queue
-         buff = dmaQueuePop(&(dev->tq));
+         buff = dmaTxBufferPop(dev, desc);
 
          // No buffers are available
          if ( buff == NULL ) {
              return -1;
          } else {
-            buff->userHas = desc;
+            dmaBufferSetUser(buff, desc);
 
-            if ( dev->debug > 0 )
+            if ( dmaDebug(dev) )
                dev_info(dev->device, "Command: Returning buffer %i to user\n", buff->index);
             return buff->index;
          }
@@ -1051,6 +1385,136 @@ ssize_t Dma_Ioctl(struct file *filp, uint32_t cmd, unsigned long arg) {
          return Dma_ReadRegister(dev, arg);
          break;
 
+      // List of register operations
+      case DMA_Reg_Batch:
+         return Dma_RegBatch(dev, arg);
+         break;
+
+      // Register range read
+      case DMA_Read_Block:
+         return Dma_RegBlock(dev, arg, 0);
+         break;
+
+      // Register range write
+      case DMA_Write_Block:
+         return Dma_RegBlock(dev, arg, 1);
+         break;
+
+      // Join shared destination group
+      case DMA_Join_Group:
+         return Dma_JoinGroup(dev, desc, arg);
+         break;
+
+      // Leave shared destination group
+      case DMA_Leave_Group:
+         return Dma_LeaveGroup(dev, desc, arg);
+         break;
+
+      // Set transmit buffer reservation and cap
+      case DMA_Set_TxQuota:
+         return Dma_SetTxQuota(dev, desc, arg);
+         break;
+
+      // Set transmit pacing of a destination
+      case DMA_Set_TxPace:
+         return Dma_SetTxPace(dev, arg);
+         break;
+
+      // Write a frame gathered from multiple user buffers
+      case DMA_Write_Gather:
+         return Dma_WriteGather(dev, desc, arg);
+         break;
+
+      // Bind eventfd notification
+      case DMA_Set_EventFd:
+         return Dma_SetEventFd(dev, desc, arg);
+         break;
+
+      // Set transmit buffer count required for POLLOUT
+      case DMA_Set_TxLowat:
+         return Dma_SetTxLowat(dev, desc, arg);
+         break;
+
+      // Enable or disable per destination receive queues
+      case DMA_Set_DestQueue:
+         return Dma_SetDestQueue(dev, desc, arg);
+         break;
+
+      // Get destinations with frames waiting
+      case DMA_Get_DestReady:
+         return Dma_GetDestReady(dev, desc, arg);
+         break;
+
+      // Read from a list of destinations
+      case DMA_Read_Select:
+         return Dma_ReadSelect(dev, desc, arg);
+         break;
+
+      // Set receive frame reassembly
+      case DMA_Set_RxChain:
+         return Dma_SetRxChain(dev, desc, arg);
+         break;
+
+      // Read one reassembled frame
+      case DMA_Read_Frame:
+         return Dma_ReadFrame(dev, desc, arg);
+         break;
+
+      // Register a zero-copy transmit region
+      case DMA_Reg_TxRegion:
+         return Dma_RegTxRegion(dev, desc, arg);
+         break;
+
+      // Release a zero-copy transmit region
+      case DMA_Unreg_TxRegion:
+         return Dma_UnregTxRegion(dev, desc, arg);
+         break;
+
+      // Zero-copy write from a registered region
+      case DMA_Write_Zc:
+         return Dma_WriteZc(dev, desc, arg);
+         break;
+
+      // Get completed zero-copy frames
+      case DMA_Get_TxDone:
+         return Dma_GetTxDone(dev, desc, arg);
+         break;
+
+      // Set small frame copy-out
+      case DMA_Set_RxSmall:
+         return Dma_SetRxSmall(dev, desc, arg);
+         break;
+
+      // Read copied out small frames
+      case DMA_Read_Small:
+         return Dma_ReadSmall(dev, desc, arg);
+         break;
+
+      // Read queued frames packed into one buffer
+      case DMA_Read_Packed:
+         return Dma_ReadPacked(dev, desc, arg);
+         break;
+
+      // Select extended read records
+      case DMA_Set_ReadExt:
+         return Dma_SetReadExt(dev, desc, arg);
+         break;
+
+      // Get per destination counters
+      case DMA_Get_DestStats:
+         return Dma_GetDestStats(dev, arg);
+         break;
+
+      // Register a zero-copy receive region
+      case DMA_Reg_RxRegion:
+         return Dma_RegRxRegion(dev, desc, arg);
+         break;
+
+      // Release a zero-copy receive region
+      case DMA_Unreg_RxRegion:
+         return Dma_UnregRxRegion(dev, desc, arg);
+         break;
+
       // All other commands handled by card specific functions
       default:
          return dev->hwFunc->command(dev, cmd, arg);
@@ -1066,34 +1530,43 @@ ssize_t Dma_Ioctl(struct file *filp, uint32_t cmd, unsigned long arg) {
  *
  * This function polls DMA queues associated with a DMA descriptor
  * and its device to determine if they are readable or writable.
- * It checks both the device's transmit queue and the descriptor's
- * queue for any pending data.
+ * The descriptor only waits on the queues for the events requested,
+ * so a pure reader is not woken by transmit buffer returns and does
+ * not compete for transmit buffers.
  *
  * Return: A mask indicating the poll condition. The mask is set
  * to indicate readability (POLLIN | POLLRDNORM) if the descriptor's
- * queue is not empty, and writability (POLLOUT | POLLWRNORM) if the
- * device's transmit queue is not empty.
+ * queue is not empty, and writability (POLLOUT | POLLWRNORM) if at
+ * least the low-watermark number of transmit buffers may be taken.
  */
 uint32_t Dma_Poll(struct file *filp, poll_table *wait) {
    struct DmaDesc *desc;
    struct DmaDevice *dev;
 
+   __u32 events;
    __u32 mask = 0;
 
    desc = (struct DmaDesc *)filp->private_data;
    dev = desc->dev;
 
-   // Polling the device's transmit queue
-   dmaQueuePoll(&(dev->tq), filp, wait);
+   events = poll_requested_events(wait);
+
    // Polling the descriptor's queue
-   dmaQueuePoll(&(desc->q), filp, wait);
+   if (events & (POLLIN | POLLRDNORM))
+      dmaQueuePoll(&(desc->q), filp, wait);
 
-   // Check if the descriptor's queue is not empty (readable)
-   if (dmaQueueNotEmpty(&(desc->q)))
+   // Check if the descriptor's queue or small frame ring is not empty (readable)
+   if (dmaQueueNotEmpty(&(desc->q)) || (desc->destCount > 0) ||
+       (READ_ONCE(desc->rxSmallHead) != READ_ONCE(desc->rxSmallTail)))
       mask |= POLLIN | POLLRDNORM;
-   // Check if the device's transmit queue is not empty (writable)
-   if (dmaQueueNotEmpty(&(dev->tq)))
-      mask |= POLLOUT | POLLWRNORM;
+
+   // Polling for transmit buffers granted to this descriptor
+   if (events & (POLLOUT | POLLWRNORM)) {
+      poll_wait(filp, &(desc->txWait), wait);
+
+      if (dmaTxBufferReady(dev, desc))
+         mask |= POLLOUT | POLLWRNORM;
+   }
 
    return mask;
 }
@@ -1106,7 +1579,8 @@ uint32_t Dma_Poll(struct file *filp, poll_table *wait) {
  * This function maps DMA buffers to user space to eliminate a copy if user
  * chooses. It handles both coherent and streaming buffer types as well as
  * ARM ACP, and performs necessary checks on index range, map size, and
- * offset alignment.
+ * offset alignment. Offsets past the buffers map the register space, except
+ * DMA_STATS_OFFSET which maps the read-only statistics page.
  *
  * Return: 0 on success, negative error code on failure.
  */
@@ -1175,6 +1649,9 @@ int Dma_Mmap(struct file *filp, struct vm_area_struct *vma) {
       relMap = offset - base;
       physical = dev->baseAddr + relMap;
 
+      // Statistics page at a reserved offset from the register space
+      if (relMap == DMA_STATS_OFFSET) return Dma_StatsMmap(dev, vma);
+
       // Validate mapping range
       if ((dev->base + relMap) < dev->rwBase) {
          dev_warn(dev->device, "map: Bad map range. start 0x%.8lx, end 0x%.8lx, offset %li, size %li, relMap %li\n",
@@ -1319,6 +1796,10 @@ int Dma_SeqShow(struct seq_file *s, void *v) {
    uint32_t qCnt;
    uint32_t x;
 
+   struct DmaPacer *pacer;
+   unsigned long iflags;
+   uint64_t elapsed;
+
    dev = (struct DmaDevice *)s->private;
 
    // Call applications specific show function first
@@ -1421,144 +1902,3526 @@ int Dma_SeqShow(struct seq_file *s, void *v) {
 // seq_printf(s, "       Tot Buffer Use : %u\n", sum);
    seq_printf(s, "\n");
 
+   // Scheduled transmit
+   spin_lock_irqsave(&(dev->launchLock), iflags);
+   if ((dev->launchFrames != 0) || (dev->launchCount != 0)) {
+      seq_printf(s, "---- Scheduled Transmit ----\n");
+      seq_printf(s, "        Frames Queued : %u\n", dev->launchCount);
+      seq_printf(s, "        Frames Sent   : %llu\n", dev->launchFrames);
+      seq_printf(s, "   Late On Submission : %llu\n", dev->launchLate);
+      seq_printf(s, "Avg Launch Err (nsec) : %llu\n", (dev->launchFrames == 0) ? 0 : div64_u64(dev->launchErrTot, dev->launchFrames));
+      seq_printf(s, "Max Launch Err (nsec) : %llu\n", dev->launchErrMax);
+      seq_printf(s, "\n");
+   }
+   spin_unlock_irqrestore(&(dev->launchLock), iflags);
+
+   // Transmit pacing
+   for (x = 0; x < DMA_MAX_DEST; x++) {
+      if ((pacer = dev->pacer[x]) == NULL) continue;
+
+      spin_lock_irqsave(&(pacer->lock), iflags);
+      if ((pacer->frameRate != 0) || (pacer->byteRate != 0)) {
+         elapsed = ktime_get_ns() - pacer->start;
+         if (elapsed == 0) elapsed = 1;
+
+         seq_printf(s, "---- Transmit Pacing Dest %u ----\n", x);
+         seq_printf(s, "     Frame Rate Limit : %llu\n", pacer->frameRate);
+         seq_printf(s, "      Byte Rate Limit : %llu\n", pacer->byteRate);
+         seq_printf(s, "  Achieved Frame Rate : %llu\n", Dma_PacerRate(pacer->frames, elapsed));
+         seq_printf(s, "   Achieved Byte Rate : %llu\n", Dma_PacerRate(pacer->bytes, elapsed));
+         seq_printf(s, "        Frames Queued : %u\n", pacer->queued);
+         seq_printf(s, "     Avg Wait (nsec) : %llu\n", (pacer->frames == 0) ? 0 : div64_u64(pacer->waitTot, pacer->frames));
+         seq_printf(s, "     Max Wait (nsec) : %llu\n", pacer->waitMax);
+         seq_printf(s, "\n");
+      }
+      spin_unlock_irqrestore(&(pacer->lock), iflags);
+   }
+
    return 0;
 }
 
 /**
- * Dma_SetMaskBytes - Set the DMA destination mask
- * @dev: pointer to the DMA device structure
- * @desc: pointer to the DMA descriptor
- * @mask: pointer to the mask array
+ * Dma_StatsAlloc - Allocate the counter block of a destination
+ * @dev: pointer to the DMA device
+ * @dest: destination to be counted
  *
- * This function sets the DMA destination mask for a specific device. It ensures
- * that each destination can only be locked once and that no data is received while
- * the mask flags are being adjusted. If any part of the mask is already set or if
- * the function is called more than once without resetting, it will fail.
+ * Each block holds per CPU counters for DMA_STATS_BLOCK destinations and
+ * is kept until the device is removed. Called from process context, the
+ * block is published with cmpxchg so that concurrent callers are safe.
  *
- * Return: 0 on success, -1 if the mask is already set or if called more than once.
+ * Return: 0 on success, -1 on allocation failure.
  */
-int Dma_SetMaskBytes(struct DmaDevice *dev, struct DmaDesc *desc, uint8_t *mask) {
-   unsigned long iflags;
-   uint32_t idx;
-   uint32_t destByte;
-   uint32_t destBit;
+int Dma_StatsAlloc(struct DmaDevice *dev, uint32_t dest) {
+   struct DmaDestStats __percpu *st;
+   uint32_t blk;
 
-   // Ensure the function is called only once
-   static const uint8_t zero[DMA_MASK_SIZE] = {0};
-   if (memcmp(desc->destMask, zero, DMA_MASK_SIZE)) return -1;
+   blk = dest / DMA_STATS_BLOCK;
+   if (READ_ONCE(dev->destStats[blk]) != NULL) return 0;
 
-   // Prevent data reception while adjusting the mask
-   spin_lock_irqsave(&dev->maskLock, iflags);
+   st = (struct DmaDestStats __percpu *)__alloc_percpu(DMA_STATS_BLOCK * sizeof(struct DmaDestStats),
+                                                       __alignof__(struct DmaDestStats));
+   if (st == NULL) {
+      dev_warn(dev->device, "Dma_StatsAlloc: Failed to allocate counters for dest %i.\n", dest);
+      return -1;
+   }
 
-   // Check if all destinations can be locked
-   for (idx = 0; idx < DMA_MAX_DEST; idx++) {
-      destByte = idx / 8;
-      destBit = 1 << (idx % 8);
-
-      // Attempt to lock this destination
-      if ((mask[destByte] & destBit) != 0) {
-         if (dev->desc[idx] != NULL) {
-            spin_unlock_irqrestore(&dev->maskLock, iflags);
-            if (dev->debug > 0)
-               dev_info(dev->device, "Dma_SetMask: Dest %i already mapped\n", idx);
-            return -1;
-         }
-      }
+   if (cmpxchg(&(dev->destStats[blk]), NULL, st) != NULL)
+      free_percpu(st);
+   return 0;
+}
+
+/**
+ * Dma_StatsFree - Free the destination counter blocks and the statistics page
+ * @dev: pointer to the DMA device
+ */
+void Dma_StatsFree(struct DmaDevice *dev) {
+   struct DmaStatsPage *page;
+   uint32_t x;
+
+   // No refresh can be scheduled once the page is detached
+   spin_lock(&(dev->statsLock));
+   page = dev->statsPage;
+   dev->statsPage = NULL;
+   spin_unlock(&(dev->statsLock));
+
+   // Mappings keep their own reference to the page
+   if (page != NULL) {
+      cancel_delayed_work_sync(&(dev->statsWork));
+      free_page((unsigned long)page);
    }
 
-   // Lock the requested destinations
-   for (idx = 0; idx < DMA_MAX_DEST; idx++) {
-      destByte = idx / 8;
-      destBit = 1 << (idx % 8);
-
-      if ((mask[destByte] & destBit) != 0) {
-         dev->desc[idx] = desc;
-         if (dev->debug > 0)
-            dev_info(dev->device, "Dma_SetMask: Register dest for %i.\n", idx);
-      }
+   for (x = 0; x < (DMA_MAX_DEST / DMA_STATS_BLOCK); x++) {
+      free_percpu(dev->destStats[x]);
+      dev->destStats[x] = NULL;
    }
+}
 
-   // Update the descriptor's mask
-   memcpy(desc->destMask, mask, DMA_MASK_SIZE);
+/**
+ * Dma_StatsSum - Sum the per CPU counters of a destination
+ * @dev: pointer to the DMA device
+ * @dest: destination
+ * @sum: counters returned, zero if the destination is not counted
+ *
+ * Return: 1 if the destination is counted, 0 otherwise.
+ */
+int Dma_StatsSum(struct DmaDevice *dev, uint32_t dest, struct DmaDestStats *sum) {
+   struct DmaDestStats __percpu *st;
+   struct DmaDestStats *c;
+   int cpu;
+
+   memset(sum, 0, sizeof(struct DmaDestStats));
+   if ((st = dmaStatsGet(dev, dest)) == NULL) return 0;
+
+   for_each_possible_cpu(cpu) {
+      c = per_cpu_ptr(st, cpu);
+      sum->rxFrames   += READ_ONCE(c->rxFrames);
+      sum->rxBytes    += READ_ONCE(c->rxBytes);
+      sum->rxErrFifo  += READ_ONCE(c->rxErrFifo);
+      sum->rxErrLen   += READ_ONCE(c->rxErrLen);
+      sum->rxErrMax   += READ_ONCE(c->rxErrMax);
+      sum->rxErrBus   += READ_ONCE(c->rxErrBus);
+      sum->rxDrop     += READ_ONCE(c->rxDrop);
+      sum->rxOverflow += READ_ONCE(c->rxOverflow);
+      sum->txFrames   += READ_ONCE(c->txFrames);
+      sum->txBytes    += READ_ONCE(c->txBytes);
+   }
+   return 1;
+}
 
-   // Restore interrupts
-   spin_unlock_irqrestore(&dev->maskLock, iflags);
+/**
+ * struct DmaStatsVmOps - Tracks the user space mappings of the statistics page
+ */
+static const struct vm_operations_struct DmaStatsVmOps = {
+   .open  = Dma_StatsVmOpen,
+   .close = Dma_StatsVmClose,
+};
+
+/**
+ * Dma_StatsPageInit - Allocate the statistics page
+ * @dev: pointer to the DMA device
+ *
+ * The page is only refreshed while user space has it mapped.
+ *
+ * Return: 0 on success, -ENOMEM on failure.
+ */
+int Dma_StatsPageInit(struct DmaDevice *dev) {
+   if ((dev->statsPage = (struct DmaStatsPage *)get_zeroed_page(GFP_KERNEL)) == NULL)
+      return -ENOMEM;
 
+   dev->statsPage->version = DMA_STATS_VERSION;
+   dev->statsPage->period  = DMA_STATS_PERIOD;
+
+   atomic_set(&(dev->statsMaps), 0);
+   INIT_DELAYED_WORK(&(dev->statsWork), Dma_StatsPageWork);
    return 0;
 }
 
 /**
- * Dma_WriteRegister - Write to a register of the DMA device.
- * @dev: Pointer to the DMA device structure.
- * @arg: User space pointer to data for writing to the register.
- *
- * This function copies a register value from user space and writes it to
- * the specified register within the DMA device. It checks for valid address
- * ranges and reports errors if copy_from_user fails or if the address is out
- * of range.
+ * Dma_StatsPageWork - Refresh the statistics page
+ * @work: statsWork of the device
  *
- * Return: 0 on success, or -1 on failure.
+ * Runs every DMA_STATS_PERIOD ms while the page is mapped to take the
+ * register snapshot and the destination counters, summed from their per
+ * CPU blocks. Buffer state counts and service pass statistics are kept
+ * current in the page by the paths which change them. The sequence count
+ * is odd during the update so readers retry a torn copy.
+ */
+void Dma_StatsPageWork(struct work_struct *work) {
+   struct DmaDevice *dev;
+   struct DmaStatsPage *page;
+   uint32_t x;
+
+   dev  = container_of(to_delayed_work(work), struct DmaDevice, statsWork);
+
+   // Page detached by Dma_StatsFree, which waits for this work to finish
+   if ((page = READ_ONCE(dev->statsPage)) == NULL) return;
+
+   WRITE_ONCE(page->seq, page->seq + 1);
+   smp_wmb();
+
+   page->stamp   = ktime_get_ns();
+   page->rxCount = dev->rxBuffers.count;
+   page->txCount = dev->txBuffers.count;
+
+   page->regCount = (dev->hwFunc->statsRegs != NULL) ? dev->hwFunc->statsRegs(dev, page->regs, DMA_STATS_REGS) : 0;
+
+   for (x = 0; x < DMA_STATS_DESTS; x++)
+      Dma_StatsSum(dev, x, &(page->dest[x]));
+
+   smp_wmb();
+   WRITE_ONCE(page->seq, page->seq + 1);
+
+   if (atomic_read(&(dev->statsMaps)) > 0)
+      schedule_delayed_work(&(dev->statsWork), msecs_to_jiffies(DMA_STATS_PERIOD));
+}
+
+/**
+ * Dma_StatsVmOpen - Count a new mapping of the statistics page
+ * @vma: VM area of the mapping
+ *
+ * Called for copies of the mapping, the refresh starts with the first one.
+ * A mapping copied after the device was removed, for example by fork, no
+ * longer matches the live page of the device and is not counted.
+ */
+void Dma_StatsVmOpen(struct vm_area_struct *vma) {
+   struct DmaDevice *dev;
+
+   dev = ((struct DmaDesc *)vma->vm_file->private_data)->dev;
+
+   spin_lock(&(dev->statsLock));
+   if ((dev->statsPage != NULL) && (dev->statsPage == vma->vm_private_data) &&
+       (atomic_inc_return(&(dev->statsMaps)) == 1))
+      schedule_delayed_work(&(dev->statsWork), 0);
+   spin_unlock(&(dev->statsLock));
+}
+
+/**
+ * Dma_StatsVmClose - Count the removal of a mapping of the statistics page
+ * @vma: VM area of the mapping
+ *
+ * The refresh stops by itself once no mapping is left. Mappings of a
+ * removed device were not counted by the device now in its place.
+ */
+void Dma_StatsVmClose(struct vm_area_struct *vma) {
+   struct DmaDevice *dev;
+
+   dev = ((struct DmaDesc *)vma->vm_file->private_data)->dev;
+
+   spin_lock(&(dev->statsLock));
+   if ((dev->statsPage != NULL) && (dev->statsPage == vma->vm_private_data))
+      atomic_dec(&(dev->statsMaps));
+   spin_unlock(&(dev->statsLock));
+}
+
+/**
+ * Dma_StatsMmap - Map the statistics page read-only to user space
+ * @dev: pointer to the DMA device
+ * @vma: VM area of the mapping
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
+int Dma_StatsMmap(struct DmaDevice *dev, struct vm_area_struct *vma) {
+   int ret;
+
+   if (dev->statsPage == NULL) return -ENODEV;
+
+   if ((vma->vm_end - vma->vm_start) > PAGE_SIZE) {
+      dev_warn(dev->device, "map: Statistics page map size too large (%li).\n",
+               vma->vm_end - vma->vm_start);
+      return -EINVAL;
+   }
+
+   if (vma->vm_flags & VM_WRITE) {
+      dev_warn(dev->device, "map: Statistics page is read-only.\n");
+      return -EPERM;
+   }
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+   vm_flags_clear(vma, VM_MAYWRITE);
+#else
+   vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+
+   if ((ret = vm_insert_page(vma, vma->vm_start, virt_to_page(dev->statsPage))) < 0) {
+      dev_warn(dev->device, "map: Failed to map statistics page. Ret=%i.\n", ret);
+      return ret;
+   }
+
+   // The page identifies the mapping, the device is found through the file
+   vma->vm_ops = &DmaStatsVmOps;
+   vma->vm_private_data = dev->statsPage;
+   Dma_StatsVmOpen(vma);
+   return 0;
+}
+
+/**
+ * Dma_ServiceStats - Account a service pass of the card
+ * @dev: pointer to the DMA device
+ * @handleCount: descriptors handled by the pass
+ *
+ * Called at the end of each service pass of the card. The counters are
+ * updated without locking and are informational only.
+ */
+void Dma_ServiceStats(struct DmaDevice *dev, uint32_t handleCount) {
+   struct DmaStatsPage *page;
+
+   dev->svcPass++;
+   dev->svcHandled += handleCount;
+   if (handleCount == 0) dev->svcEmpty++;
+   if (handleCount > dev->svcMax) dev->svcMax = handleCount;
+
+   // Published at once, the service routine is the only writer
+   if ((page = dev->statsPage) != NULL) {
+      WRITE_ONCE(page->svcPass, dev->svcPass);
+      WRITE_ONCE(page->svcHandled, dev->svcHandled);
+      WRITE_ONCE(page->svcEmpty, dev->svcEmpty);
+      WRITE_ONCE(page->svcMax, dev->svcMax);
+   }
+}
+
+/**
+ * Dma_GetDestStats - Return the counters of a range of destinations
+ * @dev: pointer to the DMA device
+ * @arg: user space pointer to a DmaDestStatsReq structure
+ *
+ * Return: Number of entries copied on success, -1 on failure.
+ */
+int32_t Dma_GetDestStats(struct DmaDevice *dev, uint64_t arg) {
+   struct DmaDestStatsReq req;
+   struct DmaDestStats *sum;
+   uint64_t data;
+   uint32_t x;
+   int32_t ret;
+
+   if ((ret = copy_from_user(&req, (void *)arg, sizeof(struct DmaDestStatsReq)))) {
+      dev_warn(dev->device, "Dma_GetDestStats: copy_from_user failed. ret=%i, user=%p kern=%p\n",
+               ret, (void *)arg, &req);
+      return -1;
+   }
+
+   if ((req.dest >= DMA_MAX_DEST) || (req.count == 0) || (req.count > (DMA_MAX_DEST - req.dest))) return -1;
+
+   // Convert pointer based on architecture
+   data = (sizeof(void *) == 4 || req.is32) ? (req.data & 0xFFFFFFFF) : req.data;
+
+   if ((sum = (struct DmaDestStats *)kmalloc(req.count * sizeof(struct DmaDestStats), GFP_KERNEL)) == NULL)
+      return -ENOMEM;
+
+   for (x = 0; x < req.count; x++)
+      Dma_StatsSum(dev, req.dest + x, &(sum[x]));
+
+   if (copy_to_user((void *)data, sum, req.count * sizeof(struct DmaDestStats))) {
+      dev_warn(dev->device, "Dma_GetDestStats: copy_to_user failed.\n");
+      kfree(sum);
+      return -1;
+   }
+
+   kfree(sum);
+   return req.count;
+}
+
+/**
+ * Dma_StatsOpen - Open the debugfs destination counter file
+ * @inode: Inode of the debugfs file
+ * @file: File pointer to the debugfs file
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
+int Dma_StatsOpen(struct inode *inode, struct file *file) {
+   return single_open(file, Dma_StatsShow, inode->i_private);
+}
+
+/**
+ * Dma_StatsShow - Display the counters of all active destinations
+ * @s: The seq_file pointer
+ * @v: Unused
+ *
+ * Return: 0.
+ */
+int Dma_StatsShow(struct seq_file *s, void *v) {
+   struct DmaDevice *dev;
+   struct DmaDestStats st;
+   uint32_t x;
+
+   dev = (struct DmaDevice *)s->private;
+
+   seq_printf(s, " Dest     RxFrames        RxBytes  ErrFifo   ErrLen   ErrMax   ErrBus     Drop Overflow");
+   seq_printf(s, "     TxFrames        TxBytes\n");
+
+   for (x = 0; x < DMA_MAX_DEST; x++) {
+      if (Dma_StatsSum(dev, x, &st) == 0) {
+         x += DMA_STATS_BLOCK - 1 - (x % DMA_STATS_BLOCK);
+         continue;
+      }
+      if ((st.rxFrames | st.rxBytes | st.rxErrFifo | st.rxErrLen | st.rxErrMax | st.rxErrBus |
+           st.rxDrop | st.rxOverflow | st.txFrames | st.txBytes) == 0) continue;
+
+      seq_printf(s, "%5u %12llu %14llu %8llu %8llu %8llu %8llu %8llu %8llu %12llu %14llu\n", x,
+                 st.rxFrames, st.rxBytes, st.rxErrFifo, st.rxErrLen, st.rxErrMax, st.rxErrBus,
+                 st.rxDrop, st.rxOverflow, st.txFrames, st.txBytes);
+   }
+   return 0;
+}
+
+#ifdef DMA_LIFECYCLE
+
+/**
+ * Dma_LcOpen - Open the debugfs lifecycle histogram file
+ * @inode: Inode of the debugfs file
+ * @file: File pointer to the debugfs file
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
+int Dma_LcOpen(struct inode *inode, struct file *file) {
+   return single_open(file, Dma_LcShow, inode->i_private);
+}
+
+/**
+ * Dma_LcShow - Display the buffer lifecycle histograms
+ * @s: The seq_file pointer
+ * @v: Unused
+ *
+ * Shows count, mean and maximum of each receive buffer lifecycle stage,
+ * followed by the non-empty log2 bins. Bin N counts times from 2^N ns up
+ * to 2^(N+1) ns.
+ *
+ * Return: 0.
+ */
+int Dma_LcShow(struct seq_file *s, void *v) {
+   static const char * const name[DMA_LC_COUNT] = {
+      "Irq To Service", "In Hardware", "Harvest To Queue", "In Queue", "In User", "Return To Hardware"
+   };
+   struct DmaDevice *dev;
+   struct DmaLcHist *h;
+   uint64_t count;
+   uint64_t cnt;
+   uint32_t x;
+   uint32_t y;
+
+   dev = (struct DmaDevice *)s->private;
+
+   for (x = 0; x < DMA_LC_COUNT; x++) {
+      h = &(dev->lc[x]);
+      count = atomic64_read(&(h->count));
+
+      seq_printf(s, "%-18s : Count %llu", name[x], count);
+      if (count > 0) {
+         seq_printf(s, ", Mean %llu ns, Max %llu ns",
+                    div64_u64(atomic64_read(&(h->total)), count), (uint64_t)atomic64_read(&(h->max)));
+      }
+      seq_printf(s, "\n");
+
+      for (y = 0; y < DMA_LC_BINS; y++) {
+         cnt = atomic64_read(&(h->bin[y]));
+         if (cnt > 0) seq_printf(s, "   >= 2^%-2i ns : %llu\n", y, cnt);
+      }
+   }
+   return 0;
+}
+
+/**
+ * Dma_LcWrite - Reset the buffer lifecycle histograms
+ * @file: File pointer to the debugfs file
+ * @buffer: Written data, ignored
+ * @count: Number of bytes written
+ * @pos: File position, unused
+ *
+ * Return: @count.
+ */
+ssize_t Dma_LcWrite(struct file *file, const char __user *buffer, size_t count, loff_t *pos) {
+   struct DmaDevice *dev;
+   struct DmaLcHist *h;
+   uint32_t x;
+   uint32_t y;
+
+   dev = (struct DmaDevice *)((struct seq_file *)file->private_data)->private;
+
+   for (x = 0; x < DMA_LC_COUNT; x++) {
+      h = &(dev->lc[x]);
+      atomic64_set(&(h->count), 0);
+      atomic64_set(&(h->total), 0);
+      atomic64_set(&(h->max), 0);
+      for (y = 0; y < DMA_LC_BINS; y++) atomic64_set(&(h->bin[y]), 0);
+   }
+   return count;
+}
+
+#endif
+
+/**
+ * Dma_SetDebug - Set the debug level of a device
+ * @dev: pointer to the DMA device
+ * @level: new debug level, 0 disables debug output, clamped to 255
+ *
+ * Counts the device in gDmaDebugKey while its level is non-zero, so that
+ * the debug tests in the data path are patched out while no device has
+ * debug output enabled.
+ */
+void Dma_SetDebug(struct DmaDevice *dev, uint32_t level) {
+   // Stored in 8 bits, a larger level must not wrap to 0
+   level = min_t(uint32_t, level, 0xFF);
+
+   mutex_lock(&gDmaDebugLock);
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 3, 0)
+   if ((dev->debug == 0) && (level != 0))
+      static_branch_inc(&gDmaDebugKey);
+   else if ((dev->debug != 0) && (level == 0))
+      static_branch_dec(&gDmaDebugKey);
+#endif
+
+   dev->debug = level;
+   mutex_unlock(&gDmaDebugLock);
+}
+
+/**
+ * Dma_MaskToBitmap - Convert a user destination mask to a bitmap
+ * @mask: pointer to the DMA_MASK_SIZE byte mask, bit (dest % 8) of byte (dest / 8)
+ * @bits: bitmap of DMA_MAX_DEST bits to be filled
+ *
+ * The byte layout of the user mask is independent of the host word size
+ * and endianness, so it is converted one non-zero byte at a time.
+ */
+void Dma_MaskToBitmap(const uint8_t *mask, unsigned long *bits) {
+   uint32_t byte;
+   uint32_t bit;
+
+   bitmap_zero(bits, DMA_MAX_DEST);
+
+   for (byte = 0; byte < DMA_MASK_SIZE; byte++) {
+      if (mask[byte] == 0) continue;
+
+      for (bit = 0; bit < 8; bit++) {
+         if ((mask[byte] & (1 << bit)) != 0)
+            __set_bit((byte * 8) + bit, bits);
+      }
+   }
+}
+
+/**
+ * Dma_BitmapToMask - Convert a destination bitmap to a user mask
+ * @bits: bitmap of DMA_MAX_DEST bits
+ * @mask: pointer to the DMA_MASK_SIZE byte mask to be filled
+ *
+ * Inverse of Dma_MaskToBitmap.
+ */
+void Dma_BitmapToMask(const unsigned long *bits, uint8_t *mask) {
+   uint32_t x;
+
+   memset(mask, 0, DMA_MASK_SIZE);
+
+   for_each_set_bit(x, bits, DMA_MAX_DEST)
+      mask[x / 8] |= (1 << (x % 8));
+}
+
+/**
+ * Dma_SetMaskBytes - Set the DMA destination mask
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @mask: pointer to the mask array
+ *
+ * This function sets the DMA destination mask for a specific device. It ensures
+ * that each destination can only be locked once and that no data is received while
+ * the mask flags are being adjusted. If any part of the mask is already set or if
+ * the function is called more than once without resetting, it will fail. Use
+ * Dma_AddMaskBytes and Dma_DelMaskBytes to change the mask of an open descriptor.
+ *
+ * Return: 0 on success, -1 if the mask is already set or if called more than once.
+ */
+int Dma_SetMaskBytes(struct DmaDevice *dev, struct DmaDesc *desc, uint8_t *mask) {
+   return Dma_ClaimMaskBytes(dev, desc, mask, 1, __func__);
+}
+
+/**
+ * Dma_AddMaskBytes - Add destinations to the DMA destination mask
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @mask: pointer to the mask array of destinations to add
+ *
+ * Reserves the requested destinations for the descriptor. The update is
+ * atomic: if any requested destination is held by another descriptor or
+ * shared group, no destination is added. Destinations already held by
+ * this descriptor are left unchanged. No destination can be added while
+ * another descriptor has a zero-copy receive region registered.
+ *
+ * Return: 0 on success, -1 if a destination is already in use.
+ */
+int Dma_AddMaskBytes(struct DmaDevice *dev, struct DmaDesc *desc, uint8_t *mask) {
+   return Dma_ClaimMaskBytes(dev, desc, mask, 0, __func__);
+}
+
+/**
+ * Dma_ClaimMaskBytes - Reserve destinations for a descriptor
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @mask: pointer to the mask array of destinations to reserve
+ * @first: non-zero to fail if the descriptor already holds a destination
+ * @name: name of the calling function for debug messages
+ *
+ * Common part of Dma_SetMaskBytes and Dma_AddMaskBytes. The check of the
+ * existing mask is made under maskLock, so two concurrent first calls on
+ * the same descriptor can not both succeed.
+ *
+ * Return: 0 on success, -1 if a destination is already in use.
+ */
+int Dma_ClaimMaskBytes(struct DmaDevice *dev, struct DmaDesc *desc, uint8_t *mask, uint32_t first, const char *name) {
+   DECLARE_BITMAP(req, DMA_MAX_DEST);
+   unsigned long iflags;
+   uint32_t idx;
+
+   Dma_MaskToBitmap(mask, req);
+
+   // Counters for the claimed destinations, allocated before taking the lock
+   for_each_set_bit(idx, req, DMA_MAX_DEST) {
+      if (Dma_StatsAlloc(dev, idx) < 0) return -ENOMEM;
+   }
+
+   // Free receive regions released earlier
+   Dma_RxZcReap(dev);
+
+   // Prevent data reception while adjusting the mask
+   spin_lock_irqsave(&dev->maskLock, iflags);
+
+   // Ensure the mask is only set once
+   if (first && !bitmap_empty(desc->destMask, DMA_MAX_DEST)) {
+      spin_unlock_irqrestore(&dev->maskLock, iflags);
+      return -1;
+   }
+
+   // Only destinations not yet held by this descriptor must be free
+   bitmap_andnot(req, req, desc->destMask, DMA_MAX_DEST);
+
+   // Frames of another reader's receive region could land in this reader's slots
+   if ((!bitmap_empty(req, DMA_MAX_DEST)) && Dma_RxZcOther(dev, desc)) {
+      if (dmaDebug(dev))
+         dev_info(dev->device, "%s: Receive region of another reader is registered\n", name);
+      spin_unlock_irqrestore(&dev->maskLock, iflags);
+      return -1;
+   }
+
+   if (bitmap_intersects(req, dev->destBusy, DMA_MAX_DEST)) {
+      if (dmaDebug(dev)) {
+         bitmap_and(req, req, dev->destBusy, DMA_MAX_DEST);
+         dev_info(dev->device, "%s: Dest %lu already mapped\n", name, find_first_bit(req, DMA_MAX_DEST));
+      }
+      spin_unlock_irqrestore(&dev->maskLock, iflags);
+      return -1;
+   }
+
+   // Lock the requested destinations
+   for_each_set_bit(idx, req, DMA_MAX_DEST) {
+      dev->desc[idx] = desc;
+      if (dmaDebug(dev))
+         dev_info(dev->device, "%s: Register dest for %i.\n", name, idx);
+   }
+
+   bitmap_or(desc->destMask, desc->destMask, req, DMA_MAX_DEST);
+   bitmap_or(dev->destBusy, dev->destBusy, req, DMA_MAX_DEST);
+
+   // Restore interrupts
+   spin_unlock_irqrestore(&dev->maskLock, iflags);
+
+   return 0;
+}
+
+/**
+ * Dma_DelMaskBytes - Remove destinations from the DMA destination mask
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @mask: pointer to the mask array of destinations to remove
+ *
+ * Releases the requested destinations held by the descriptor. Requested
+ * destinations not held by the descriptor are ignored. Frames already in
+ * the descriptor receive queue are not affected, frames still being
+ * reassembled for a released destination are dropped.
+ *
+ * Return: 0 on success.
+ */
+int Dma_DelMaskBytes(struct DmaDevice *dev, struct DmaDesc *desc, uint8_t *mask) {
+   DECLARE_BITMAP(req, DMA_MAX_DEST);
+   struct DmaBuffer *open;
+   struct DmaBuffer *part;
+   unsigned long iflags;
+   uint32_t idx;
+
+   Dma_MaskToBitmap(mask, req);
+   open = NULL;
+
+   // Prevent data reception while adjusting the mask
+   spin_lock_irqsave(&dev->maskLock, iflags);
+
+   bitmap_and(req, req, desc->destMask, DMA_MAX_DEST);
+
+   for_each_set_bit(idx, req, DMA_MAX_DEST) {
+      dev->desc[idx] = NULL;
+
+      // Detach the partial frame, the open chains are joined into one list
+      if ((desc->rxChain != NULL) && ((part = desc->rxChain[idx]) != NULL)) {
+         desc->rxChain[idx] = NULL;
+         part->chainTail->chainNext = open;
+         open = part;
+      }
+
+      if (dmaDebug(dev))
+         dev_info(dev->device, "Dma_DelMaskBytes: Release dest for %i.\n", idx);
+   }
+
+   bitmap_andnot(desc->destMask, desc->destMask, req, DMA_MAX_DEST);
+   bitmap_andnot(dev->destBusy, dev->destBusy, req, DMA_MAX_DEST);
+
+   // Restore interrupts
+   spin_unlock_irqrestore(&dev->maskLock, iflags);
+
+   if (open != NULL) Dma_RetChain(dev, open);
+
+   return 0;
+}
+
+/**
+ * Dma_JoinGroup - Join the group of readers sharing a destination
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @arg: user space pointer to a DmaGroupData structure
+ *
+ * Adds the descriptor to the shared group for the requested destination,
+ * creating the group on first use with the requested distribution mode.
+ * A destination which is exclusively reserved through Dma_SetMaskBytes
+ * can not be shared, and a descriptor may only join a group once. No
+ * group can be joined while a zero-copy receive region is registered.
+ *
+ * Return: 0 on success, -1 on failure.
+ */
+int32_t Dma_JoinGroup(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg) {
+   struct DmaGroupData gData;
+   struct DmaGroup *grp;
+   struct DmaGroup *newGrp;
+   unsigned long iflags;
+   int32_t ret;
+
+   // Copy request from user space
+   if ((ret = copy_from_user(&gData, (void *)arg, sizeof(struct DmaGroupData)))) {
+      dev_warn(dev->device, "Dma_JoinGroup: copy_from_user failed. ret=%i, user=%p kern=%p\n",
+               ret, (void *)arg, &gData);
+      return -1;
+   }
+
+   if ((gData.dest >= DMA_MAX_DEST) || (gData.mode > DMA_GROUP_LOAD)) return -1;
+   if (Dma_StatsAlloc(dev, gData.dest) < 0) return -ENOMEM;
+
+   // Allocate outside of the lock, freed below if the group already exists
+   if ((newGrp = (struct DmaGroup *)kzalloc(sizeof(struct DmaGroup), GFP_KERNEL)) == NULL)
+      return -ENOMEM;
+   newGrp->mode = gData.mode;
+
+   // Free receive regions released earlier
+   Dma_RxZcReap(dev);
+
+   // Prevent data reception while adjusting the group
+   spin_lock_irqsave(&dev->maskLock, iflags);
+
+   grp = dev->group[gData.dest];
+
+   // Destination reserved, already joined, group full or receive regions registered
+   if ((dev->desc[gData.dest] != NULL) || test_bit(gData.dest, desc->groupMask) ||
+       ((grp != NULL) && (grp->count >= DMA_MAX_GROUP)) || Dma_RxZcOther(dev, NULL)) {
+      spin_unlock_irqrestore(&dev->maskLock, iflags);
+      kfree(newGrp);
+      if (dmaDebug(dev))
+         dev_info(dev->device, "Dma_JoinGroup: Dest %i not available\n", gData.dest);
+      return -1;
+   }
+
+   // First member creates the group
+   if (grp == NULL) {
+      grp = newGrp;
+      newGrp = NULL;
+      dev->group[gData.dest] = grp;
+      __set_bit(gData.dest, dev->destBusy);
+   }
+
+   grp->member[grp->count++] = desc;
+   __set_bit(gData.dest, desc->groupMask);
+
+   spin_unlock_irqrestore(&dev->maskLock, iflags);
+   kfree(newGrp);
+
+   if (dmaDebug(dev))
+      dev_info(dev->device, "Dma_JoinGroup: Dest %i now has %i readers.\n", gData.dest, grp->count);
+
+   return 0;
+}
+
+/**
+ * Dma_LeaveGroup - Leave the group of readers sharing a destination
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @dest: destination previously joined
+ *
+ * Removes the descriptor from the shared group, releasing the group when
+ * its last member leaves. Frames already queued to the descriptor remain
+ * owned by it until read or the descriptor is closed. A frame the member
+ * was receiving is dropped, its remaining buffers are not handed to
+ * another member.
+ *
+ * Return: 0 on success, -1 if the descriptor is not a member of the group.
+ */
+int32_t Dma_LeaveGroup(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t dest) {
+   struct DmaBuffer *open;
+   struct DmaGroup *grp;
+   unsigned long iflags;
+   uint32_t x;
+
+   if (dest >= DMA_MAX_DEST) return -1;
+
+   // Prevent data reception while adjusting the group
+   spin_lock_irqsave(&dev->maskLock, iflags);
+
+   grp = dev->group[dest];
+
+   if ((grp == NULL) || !test_bit(dest, desc->groupMask)) {
+      spin_unlock_irqrestore(&dev->maskLock, iflags);
+      return -1;
+   }
+
+   // Remove member, keeping the remaining order
+   for (x = 0; x < grp->count; x++) {
+      if (grp->member[x] == desc) break;
+   }
+   for (; (x + 1) < grp->count; x++) grp->member[x] = grp->member[x+1];
+
+   grp->count--;
+   if (grp->next >= grp->count) grp->next = 0;
+   __clear_bit(dest, desc->groupMask);
+
+   // Drop the rest of a frame this member was receiving
+   if (grp->hold == desc) {
+      grp->hold = NULL;
+      grp->drop = 1;
+   }
+
+   // Drop the part of the frame already being reassembled
+   open = NULL;
+   if (desc->rxChain != NULL) {
+      open = desc->rxChain[dest];
+      desc->rxChain[dest] = NULL;
+   }
+
+   // Last member releases the group
+   if (grp->count == 0) {
+      dev->group[dest] = NULL;
+      __clear_bit(dest, dev->destBusy);
+   } else {
+      grp = NULL;
+   }
+
+   spin_unlock_irqrestore(&dev->maskLock, iflags);
+   kfree(grp);
+
+   if (open != NULL) Dma_RetChain(dev, open);
+
+   if (dmaDebug(dev))
+      dev_info(dev->device, "Dma_LeaveGroup: Left dest %i.\n", dest);
+
+   return 0;
+}
+
+/**
+ * Dma_DestOwner - Select the descriptor to receive a frame
+ * @dev: pointer to the DMA device structure
+ * @dest: destination of the received frame
+ *
+ * @cont: non-zero if the frame continues in the next buffer
+ *
+ * Returns the exclusive owner of the destination if one exists. For a
+ * shared destination the next group member is selected, either in
+ * round-robin order or as the member with the fewest queued frames.
+ * The buffers of a continued frame all go to the same member, they are
+ * dropped if that member leaves the group during the frame. Must be
+ * called with the device maskLock held.
+ *
+ * Return: Pointer to the owning descriptor, or NULL if the destination is not open.
+ */
+struct DmaDesc * Dma_DestOwner(struct DmaDevice *dev, uint32_t dest, uint32_t cont) {
+   struct DmaGroup *grp;
+   struct DmaDesc *desc;
+   uint32_t depth;
+   uint32_t min;
+   uint32_t sel;
+   uint32_t idx;
+   uint32_t x;
+
+   if (dest >= DMA_MAX_DEST) return NULL;
+
+   // Exclusive owner
+   if ((grp = dev->group[dest]) == NULL) return dev->desc[dest];
+   if (grp->count == 0) return NULL;
+
+   // Remainder of a continued frame
+   if (grp->hold != NULL) {
+      desc = grp->hold;
+      if (!cont) grp->hold = NULL;
+      return desc;
+   }
+
+   // Remainder of a frame whose member left the group
+   if (grp->drop) {
+      if (!cont) grp->drop = 0;
+      return NULL;
+   }
+
+   sel = grp->next;
+
+   // Shortest queue, ties resolved in round-robin order
+   if (grp->mode == DMA_GROUP_LOAD) {
+      min = 0xFFFFFFFF;
+      for (x = 0; x < grp->count; x++) {
+         idx = (grp->next + x) % grp->count;
+         depth = dmaQueueCount(&(grp->member[idx]->q)) + grp->member[idx]->destCount;
+         if (depth < min) {
+            min = depth;
+            sel = idx;
+         }
+      }
+   }
+
+   grp->next = (sel + 1) % grp->count;
+   if (cont) grp->hold = grp->member[sel];
+   return grp->member[sel];
+}
+
+/**
+ * Dma_WriteRegister - Write to a register of the DMA device.
+ * @dev: Pointer to the DMA device structure.
+ * @arg: User space pointer to data for writing to the register.
+ *
+ * This function copies a register value from user space and writes it to
+ * the specified register within the DMA device. It checks for valid address
+ * ranges and reports errors if copy_from_user fails or if the address is out
+ * of range.
+ *
+ * Return: 0 on success, or -1 on failure.
  */
 int32_t Dma_WriteRegister(struct DmaDevice *dev, uint64_t arg) {
    int32_t ret;
-   struct DmaRegisterData rData;
+   struct DmaRegisterData rData;
+
+   // Attempt to copy register data from user space
+   ret = copy_from_user(&rData, (void *)arg, sizeof(struct DmaRegisterData));
+   if (ret) {
+      dev_warn(dev->device, "Dma_WriteRegister: copy_from_user failed. ret=%i, user=%p kern=%p\n",
+               ret, (void *)arg, &rData);
+      return -1;
+   }
+
+   // Validate register address range
+   if (((dev->base + rData.address) < dev->rwBase) ||
+       ((dev->base + rData.address + 4) > (dev->rwBase + dev->rwSize))) {
+      return -1;
+   }
+
+   // Write data to the register
+   writel(rData.data, dev->base + rData.address);
+
+   return 0;
+}
+
+/**
+ * Dma_ReadRegister - Read a register from a DMA device.
+ * @dev: pointer to the DmaDevice structure.
+ * @arg: user space pointer to DmaRegisterData structure where the read data will be stored.
+ *
+ * This function reads a register from the DMA device specified by @dev,
+ * using the address specified in the @arg user space DmaRegisterData structure.
+ * The read value is then written back to the same structure in user space.
+ * If any step fails, the function returns an error.
+ *
+ * Return: 0 on success, -1 on failure.
+ */
+int32_t Dma_ReadRegister(struct DmaDevice *dev, uint64_t arg) {
+   int32_t ret;
+   struct DmaRegisterData rData;
+
+   // Attempt to copy DmaRegisterData structure from user space
+   if ((ret = copy_from_user(&rData, (void *)arg, sizeof(struct DmaRegisterData)))) {
+      dev_warn(dev->device, "Dma_ReadRegister: copy_from_user failed. ret=%i, user=%p kern=%p\n", ret, (void *)arg, &rData);
+      return -1;
+   }
+
+   // Validate register address within the allowed range
+   if (((dev->base + rData.address) < dev->rwBase) ||
+       ((dev->base + rData.address + 4) > (dev->rwBase + dev->rwSize))) {
+      return -1;
+   }
+
+   // Read register value
+   rData.data = readl(dev->base + rData.address);
+
+   // Attempt to copy the updated DmaRegisterData structure back to user space
+   if ((ret = copy_to_user((void *)arg, &rData, sizeof(struct DmaRegisterData)))) {
+      dev_warn(dev->device, "Dma_ReadRegister: copy_to_user failed. ret=%i, user=%p kern=%p\n", ret, (void *)arg, &rData);
+      return -1;
+   }
+
+   return 0;
+}
+
+/**
+ * Dma_RegOp - Execute one operation of a register batch
+ * @dev: pointer to the DMA device
+ * @op: operation, the value read is returned in op->data
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
+int32_t Dma_RegOp(struct DmaDevice *dev, struct DmaRegOp *op) {
+   uint8_t *addr;
+   uint64_t end;
+   uint32_t val;
+
+   // Validate register address range
+   if (((dev->base + op->address) < dev->rwBase) ||
+       ((dev->base + op->address + 4) > (dev->rwBase + dev->rwSize))) {
+      return -EFAULT;
+   }
+   addr = dev->base + op->address;
+
+   switch (op->op) {
+      case DMA_REG_READ:
+         op->data = readl(addr);
+         return 0;
+         break;
+
+      case DMA_REG_WRITE:
+         writel(op->data, addr);
+         return 0;
+         break;
+
+      case DMA_REG_RMW:
+         val = readl(addr);
+         writel((val & ~op->mask) | (op->data & op->mask), addr);
+         op->data = val;
+         return 0;
+         break;
+
+      case DMA_REG_POLL:
+         if (op->timeout > DMA_REG_POLL_MAX) return -EINVAL;
+         end = ktime_get_ns() + (uint64_t)op->timeout * NSEC_PER_USEC;
+
+         while (((val = readl(addr)) & op->mask) != (op->data & op->mask)) {
+            if (ktime_get_ns() >= end) {
+               op->data = val;
+               return -ETIMEDOUT;
+            }
+            if (fatal_signal_pending(current)) return -EINTR;
+            if (op->timeout > DMA_REG_SPIN) usleep_range(10, 20);
+            else udelay(1);
+         }
+         op->data = val;
+         return 0;
+         break;
+
+      default:
+         return -EINVAL;
+         break;
+   }
+}
+
+/**
+ * Dma_RegBatch - Execute a list of register operations
+ * @dev: pointer to the DMA device
+ * @arg: user space pointer to a DmaRegBatch structure
+ *
+ * The operations are copied in steps of DMA_REG_BATCH and executed in order.
+ * The status and read value of each operation are copied back in place.
+ * Operations after a failed one are not executed and return -ECANCELED.
+ * The batch stops between steps when the process is killed.
+ *
+ * Return: Number of operations completed, -EINVAL if the count does not
+ *         fit the return value, -EINTR if killed, -1 on failure.
+ */
+int32_t Dma_RegBatch(struct DmaDevice *dev, uint64_t arg) {
+   struct DmaRegBatch req;
+   struct DmaRegOp *ops;
+   uint64_t data;
+   uint32_t done;
+   uint32_t ok;
+   uint32_t cnt;
+   uint32_t x;
+   int32_t status;
+   int32_t ret;
+
+   if ((ret = copy_from_user(&req, (void *)arg, sizeof(struct DmaRegBatch)))) {
+      dev_warn(dev->device, "Dma_RegBatch: copy_from_user failed. ret=%i, user=%p kern=%p\n",
+               ret, (void *)arg, &req);
+      return -1;
+   }
+
+   if (req.count == 0) return 0;
+   if (req.count > INT_MAX) return -EINVAL;
+
+   // Convert pointer based on architecture
+   data = (sizeof(void *) == 4 || req.is32) ? (req.data & 0xFFFFFFFF) : req.data;
+
+   cnt = (req.count < DMA_REG_BATCH) ? req.count : DMA_REG_BATCH;
+   if ((ops = (struct DmaRegOp *)kmalloc(cnt * sizeof(struct DmaRegOp), GFP_KERNEL)) == NULL)
+      return -ENOMEM;
+
+   status = 0;
+   ok     = 0;
+
+   for (done = 0; done < req.count; done += cnt) {
+      cnt = ((req.count - done) < DMA_REG_BATCH) ? (req.count - done) : DMA_REG_BATCH;
+
+      // Results of the steps done so far are already in user space
+      if (fatal_signal_pending(current)) {
+         kfree(ops);
+         return -EINTR;
+      }
+
+      if (copy_from_user(ops, (void *)(data + done * sizeof(struct DmaRegOp)), cnt * sizeof(struct DmaRegOp))) {
+         dev_warn(dev->device, "Dma_RegBatch: copy_from_user failed.\n");
+         kfree(ops);
+         return -1;
+      }
+
+      for (x = 0; x < cnt; x++) {
+         if (status == 0) {
+            status = Dma_RegOp(dev, &(ops[x]));
+            ops[x].status = status;
+            if (status == 0) ok++;
+         } else {
+            ops[x].status = -ECANCELED;
+         }
+      }
+
+      if (copy_to_user((void *)(data + done * sizeof(struct DmaRegOp)), ops, cnt * sizeof(struct DmaRegOp))) {
+         dev_warn(dev->device, "Dma_RegBatch: copy_to_user failed.\n");
+         kfree(ops);
+         return -1;
+      }
+      cond_resched();
+   }
+
+   kfree(ops);
+   return ok;
+}
+
+/**
+ * Dma_RegBlock - Copy a contiguous register range to or from user space
+ * @dev: pointer to the DMA device
+ * @arg: user space pointer to a DmaBlockData structure
+ * @write: non-zero to write the range, zero to read it
+ *
+ * The range must be word aligned and lie within the read/write window. It is
+ * copied through a bounce buffer in steps of DMA_BLOCK_SIZE bytes using
+ * memcpy_fromio and memcpy_toio, letting the bus burst.
+ *
+ * Return: Number of bytes copied, negative on failure.
+ */
+int32_t Dma_RegBlock(struct DmaDevice *dev, uint64_t arg, uint8_t write) {
+   struct DmaBlockData req;
+   uint8_t *buff;
+   uint64_t data;
+   uint32_t done;
+   uint32_t cnt;
+   int32_t ret;
+
+   if ((ret = copy_from_user(&req, (void *)arg, sizeof(struct DmaBlockData)))) {
+      dev_warn(dev->device, "Dma_RegBlock: copy_from_user failed. ret=%i, user=%p kern=%p\n",
+               ret, (void *)arg, &req);
+      return -1;
+   }
+
+   // Validate alignment and range
+   if ((((req.address | req.size) & 0x3) != 0) || (req.size > INT_MAX) ||
+       (req.address > dev->baseSize) ||
+       ((dev->base + req.address) < dev->rwBase) ||
+       ((dev->base + req.address + req.size) > (dev->rwBase + dev->rwSize))) {
+      return -EINVAL;
+   }
+
+   if (req.size == 0) return 0;
+
+   // Convert pointer based on architecture
+   data = (sizeof(void *) == 4 || req.is32) ? (req.data & 0xFFFFFFFF) : req.data;
+
+   if ((buff = (uint8_t *)kmalloc(DMA_BLOCK_SIZE, GFP_KERNEL)) == NULL)
+      return -ENOMEM;
+
+   for (done = 0; done < req.size; done += cnt) {
+      cnt = ((req.size - done) < DMA_BLOCK_SIZE) ? (req.size - done) : DMA_BLOCK_SIZE;
+
+      if (write) {
+         if (copy_from_user(buff, (void *)(data + done), cnt)) break;
+         memcpy_toio(dev->base + req.address + done, buff, cnt);
+      } else {
+         memcpy_fromio(buff, dev->base + req.address + done, cnt);
+         if (copy_to_user((void *)(data + done), buff, cnt)) break;
+      }
+      cond_resched();
+   }
+
+   kfree(buff);
+
+   if (done < req.size) {
+      dev_warn(dev->device, "Dma_RegBlock: user copy failed.\n");
+      return -1;
+   }
+   return done;
+}
+
+/**
+ * Dma_SetDestQueue - Enable or disable per-destination receive queues
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @enable: non-zero to keep a separate queue for each destination
+ *
+ * When enabled, received frames are kept in a queue per destination so
+ * that a reader can select which destinations to service with
+ * DMA_Read_Select, while normal reads rotate over the ready destinations.
+ * Frames already queued are moved between the two modes, keeping their
+ * order within each destination.
+ *
+ * Return: 0 on success, -ENOMEM if the queues can not be allocated.
+ */
+int32_t Dma_SetDestQueue(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t enable) {
+   struct list_head *destQ;
+   struct DmaBuffer *buff;
+   unsigned long iflags;
+   uint32_t moved;
+   uint32_t x;
+
+   // Allocate outside of the lock, freed below if not used
+   destQ = NULL;
+   moved = 0;
+   if (enable) {
+      if ((destQ = vmalloc(DMA_MAX_DEST * sizeof(struct list_head))) == NULL)
+         return -ENOMEM;
+      for (x = 0; x < DMA_MAX_DEST; x++)
+         INIT_LIST_HEAD(&(destQ[x]));
+   }
+
+   // Prevent data reception while frames move between queues
+   spin_lock_irqsave(&dev->maskLock, iflags);
+   spin_lock(&(desc->q.lock));
+
+   // Move frames from the receive queue to the destination queues
+   if (enable && (desc->destQ == NULL)) {
+      desc->destQ = destQ;
+      destQ = NULL;
+
+      while (desc->q.read != desc->q.write) {
+         buff = desc->q.queue[desc->q.read / BUFFERS_PER_LIST][desc->q.read % BUFFERS_PER_LIST];
+         desc->q.read = (desc->q.read + 1) % desc->q.count;
+
+         list_add_tail(&(buff->destLink), &(desc->destQ[buff->dest]));
+         __set_bit(buff->dest, desc->destReady);
+         desc->destCount++;
+      }
+
+   // Move frames back to the receive queue
+   } else if ((!enable) && (desc->destQ != NULL)) {
+      moved = desc->destCount;
+      for_each_set_bit(x, desc->destReady, DMA_MAX_DEST) {
+         while (!list_empty(&(desc->destQ[x]))) {
+            buff = dmaDestQueueTake(desc, x);
+            dmaBufferSetState(buff, buff->inHw, 1);
+            desc->q.queue[desc->q.write / BUFFERS_PER_LIST][desc->q.write % BUFFERS_PER_LIST] = buff;
+            desc->q.write = (desc->q.write + 1) % desc->q.count;
+         }
+      }
+      destQ = desc->destQ;
+      desc->destQ = NULL;
+      desc->destNext = 0;
+   }
+
+   spin_unlock(&(desc->q.lock));
+   spin_unlock_irqrestore(&dev->maskLock, iflags);
+
+   // Wake readers waiting on the receive queue for the moved frames
+   if (moved > 0) wake_up_interruptible(&(desc->q.wait));
+
+   vfree(destQ);
+   return 0;
+}
+
+/**
+ * Dma_GetDestReady - Report destinations with queued frames
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @arg: user space pointer to a DMA_MASK_SIZE byte mask
+ *
+ * Copies the readiness bitmap of the per-destination queues to user space
+ * using the same byte layout as DMA_Set_MaskBytes.
+ *
+ * Return: 0 on success, -1 if per-destination queues are not enabled or the copy fails.
+ */
+int32_t Dma_GetDestReady(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg) {
+   uint8_t mask[DMA_MASK_SIZE];
+   unsigned long iflags;
+   uint32_t enabled;
+   int32_t ret;
+
+   spin_lock_irqsave(&(desc->q.lock), iflags);
+   enabled = (desc->destQ != NULL);
+   if (enabled) Dma_BitmapToMask(desc->destReady, mask);
+   spin_unlock_irqrestore(&(desc->q.lock), iflags);
+
+   if (!enabled) return -1;
+
+   if ((ret = copy_to_user((void *)arg, mask, DMA_MASK_SIZE))) {
+      dev_warn(dev->device, "Dma_GetDestReady: copy_to_user failed. ret=%i, user=%p kern=%p\n",
+               ret, (void *)arg, mask);
+      return -1;
+   }
+   return 0;
+}
+
+/**
+ * Dma_ReadSelect - Read frames from a list of destinations
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @arg: user space pointer to a DmaReadSelect structure
+ *
+ * Dequeues up to count frames from the per-destination queues, draining
+ * the listed destinations in priority order. Each frame completes one
+ * DmaReadData record in the same way as a normal read.
+ *
+ * Return: The number of frames read, or -1 on failure.
+ */
+int32_t Dma_ReadSelect(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg) {
+   struct DmaReadSelect sel;
+   struct DmaReadData *rd;
+   struct DmaBuffer **buff;
+   uint32_t *dests;
+   ssize_t bCnt;
+   ssize_t ret;
+
+   if ((ret = copy_from_user(&sel, (void *)arg, sizeof(struct DmaReadSelect)))) {
+      dev_warn(dev->device, "Dma_ReadSelect: copy_from_user failed. ret=%li, user=%p kern=%p\n",
+               ret, (void *)arg, &sel);
+      return -1;
+   }
+
+   if ((desc->destQ == NULL) || (sel.count == 0) || (sel.destCount == 0) ||
+       (sel.count > dev->cfgRxCount) || (sel.destCount > DMA_MAX_DEST)) return -1;
+
+   if (sel.is32) {
+      sel.dests &= 0xFFFFFFFF;
+      sel.read  &= 0xFFFFFFFF;
+   }
+
+   dests = (uint32_t *)kmalloc(sel.destCount * sizeof(uint32_t), GFP_KERNEL);
+   rd = (struct DmaReadData *)kmalloc(sel.count * sizeof(struct DmaReadData), GFP_KERNEL);
+   buff = (struct DmaBuffer **)kmalloc(sel.count * sizeof(struct DmaBuffer *), GFP_KERNEL);
+
+   if ((dests == NULL) || (rd == NULL) || (buff == NULL)) {
+      bCnt = -ENOMEM;
+      goto cleanup;
+   }
+
+   if (copy_from_user(dests, (void *)sel.dests, sel.destCount * sizeof(uint32_t)) ||
+       copy_from_user(rd, (void *)sel.read, sel.count * sizeof(struct DmaReadData))) {
+      dev_warn(dev->device, "Dma_ReadSelect: failed to copy request from user space\n");
+      bCnt = -1;
+      goto cleanup;
+   }
+
+   bCnt = dmaDestQueuePopList(desc, dests, sel.destCount, buff, sel.count);
+   Dma_ReadBuffers(desc, rd, buff, bCnt);
+
+   if ((bCnt > 0) && copy_to_user((void *)sel.read, rd, bCnt * sizeof(struct DmaReadData))) {
+      dev_warn(dev->device, "Dma_ReadSelect: failed to copy records to user space\n");
+      bCnt = -1;
+   }
+
+cleanup:
+   kfree(buff);
+   kfree(rd);
+   kfree(dests);
+   return bCnt;
+}
+
+/**
+ * Dma_SetTxQuota - Set the transmit buffer share of a descriptor
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @arg: user space pointer to a DmaTxQuota structure
+ *
+ * The reservation is held back from other writers so that the descriptor
+ * always finds a buffer while below it, bounding its latency while bulk
+ * writers run. The cap limits the buffers the descriptor may have in use
+ * and the weight sets its quantum when free buffers are shared between
+ * waiting writers. At least one buffer is always left unreserved.
+ *
+ * Return: 0 on success, -1 on invalid request.
+ */
+int32_t Dma_SetTxQuota(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg) {
+   struct DmaTxQuota quota;
+   unsigned long iflags;
+   int32_t ret;
+
+   if ((ret = copy_from_user(&quota, (void *)arg, sizeof(struct DmaTxQuota)))) {
+      dev_warn(dev->device, "Dma_SetTxQuota: copy_from_user failed. ret=%i, user=%p kern=%p\n",
+               ret, (void *)arg, &quota);
+      return -1;
+   }
+
+   if ((quota.limit != 0) && ((quota.limit < quota.reserve) || (quota.limit < desc->txLowat))) return -1;
+
+   spin_lock_irqsave(&(dev->txLock), iflags);
+
+   if ((quota.reserve > 0) && ((dev->txReserved - desc->txReserve + quota.reserve) >= dev->txBuffers.count)) {
+      spin_unlock_irqrestore(&(dev->txLock), iflags);
+      if (dmaDebug(dev))
+         dev_info(dev->device, "Dma_SetTxQuota: Reserve %i not available, %i reserved.\n",
+                  quota.reserve, dev->txReserved);
+      return -1;
+   }
+
+   // Move the unused part of the reservation
+   if (desc->txInUse < desc->txReserve)
+      dev->txHeld -= (desc->txReserve - desc->txInUse);
+   if (desc->txInUse < quota.reserve)
+      dev->txHeld += (quota.reserve - desc->txInUse);
+
+   dev->txReserved = dev->txReserved - desc->txReserve + quota.reserve;
+
+   desc->txReserve = quota.reserve;
+   desc->txLimit   = quota.limit;
+   desc->txQuantum = (quota.weight == 0) ? 1 : quota.weight;
+
+   dmaTxBufferGrant(dev);
+   spin_unlock_irqrestore(&(dev->txLock), iflags);
+
+   if (dmaDebug(dev))
+      dev_info(dev->device, "Dma_SetTxQuota: Reserve=%i, Limit=%i, Weight=%i.\n",
+               desc->txReserve, desc->txLimit, desc->txQuantum);
+   return 0;
+}
+
+/**
+ * Dma_SetTxLowat - Set the POLLOUT low-watermark of a descriptor
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @lowat: transmit buffers which must be available before POLLOUT, 0 for 1
+ *
+ * Lets a writer which sends in bursts sleep until it can take a full
+ * burst rather than being woken for every returned buffer.
+ *
+ * Return: 0 on success, -1 if the watermark exceeds the pool or the cap.
+ */
+int32_t Dma_SetTxLowat(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t lowat) {
+   unsigned long iflags;
+
+   if (lowat == 0) lowat = 1;
+
+   spin_lock_irqsave(&(dev->txLock), iflags);
+
+   if ((lowat > dev->txBuffers.count) || ((desc->txLimit != 0) && (lowat > desc->txLimit))) {
+      spin_unlock_irqrestore(&(dev->txLock), iflags);
+      return -1;
+   }
+
+   desc->txLowat = lowat;
+   spin_unlock_irqrestore(&(dev->txLock), iflags);
+   return 0;
+}
+
+/**
+ * Dma_SetEventFd - Bind eventfd notification to a descriptor
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @arg: user space pointer to a DmaEventFd structure
+ *
+ * Binds an eventfd signalled when frames are received and, optionally, one
+ * signalled when transmit buffers become available, replacing any previous
+ * binding. A file descriptor of -1 removes the binding. If frames are
+ * already waiting the receive eventfd is signalled immediately.
+ *
+ * Return: 0 on success, -1 on failure.
+ */
+int32_t Dma_SetEventFd(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg) {
+   struct DmaEventFd ev;
+   struct eventfd_ctx *rx;
+   struct eventfd_ctx *tx;
+   unsigned long iflags;
+   int32_t ret;
+
+   if ((ret = copy_from_user(&ev, (void *)arg, sizeof(struct DmaEventFd)))) {
+      dev_warn(dev->device, "Dma_SetEventFd: copy_from_user failed. ret=%i, user=%p kern=%p\n",
+               ret, (void *)arg, &ev);
+      return -1;
+   }
+
+   rx = NULL;
+   tx = NULL;
+
+   if ((ev.rxFd >= 0) && IS_ERR(rx = eventfd_ctx_fdget(ev.rxFd))) {
+      dev_warn(dev->device, "Dma_SetEventFd: Invalid receive eventfd %i.\n", ev.rxFd);
+      return -1;
+   }
+
+   if ((ev.txFd >= 0) && IS_ERR(tx = eventfd_ctx_fdget(ev.txFd))) {
+      dev_warn(dev->device, "Dma_SetEventFd: Invalid transmit eventfd %i.\n", ev.txFd);
+      if (rx != NULL) eventfd_ctx_put(rx);
+      return -1;
+   }
+
+   // Swap the receive binding, the receive path holds maskLock
+   spin_lock_irqsave(&dev->maskLock, iflags);
+   swap(desc->rxEvent, rx);
+   desc->rxCoalesce  = (ev.coalesce == 0) ? 1 : ev.coalesce;
+   desc->rxEventPend = 0;
+
+   if ((desc->rxEvent != NULL) && (dmaQueueNotEmpty(&(desc->q)) || (desc->destCount > 0)))
+      dmaEventSignal(desc->rxEvent);
+   spin_unlock_irqrestore(&dev->maskLock, iflags);
+
+   // Swap the transmit binding, signalled at once if buffers are available
+   spin_lock_irqsave(&(dev->txLock), iflags);
+   swap(desc->txEvent, tx);
+   list_del_init(&(desc->txEventLink));
+   desc->txEventReady = 0;
+
+   if (desc->txEvent != NULL) {
+      list_add_tail(&(desc->txEventLink), &(dev->txEvents));
+      dmaTxEventCheck(dev);
+   }
+   spin_unlock_irqrestore(&(dev->txLock), iflags);
+
+   // Release previous bindings
+   if (rx != NULL) eventfd_ctx_put(rx);
+   if (tx != NULL) eventfd_ctx_put(tx);
+
+   if (dmaDebug(dev))
+      dev_info(dev->device, "Dma_SetEventFd: Rx=%i, Tx=%i, Coalesce=%i.\n",
+               ev.rxFd, ev.txFd, desc->rxCoalesce);
+   return 0;
+}
+
+/**
+ * Dma_PacerRefill - Add the tokens earned since the last refill
+ * @pacer: pointer to the destination pacer
+ * @now: current time in ns
+ *
+ * Caller must hold the pacer lock.
+ */
+void Dma_PacerRefill(struct DmaPacer *pacer, uint64_t now) {
+   uint64_t elapsed;
+
+   elapsed = now - pacer->last;
+   pacer->last = now;
+
+   // Limited to the fill time, the product stays near the bucket depth and can not overflow
+   if (pacer->frameRate != 0)
+      pacer->frameTok = min(pacer->frameTok + (min(elapsed, pacer->frameFill) * pacer->frameRate), pacer->frameMax);
+
+   if (pacer->byteRate != 0)
+      pacer->byteTok = min(pacer->byteTok + (min(elapsed, pacer->byteFill) * pacer->byteRate), pacer->byteMax);
+}
+
+/**
+ * Dma_PacerWait - Time until buffers may be released
+ * @pacer: pointer to the destination pacer
+ * @frames: frames started by the buffers, 0 or 1
+ * @bytes: size of the buffers in bytes
+ *
+ * Caller must hold the pacer lock.
+ *
+ * Return: Time in ns until both buckets hold enough tokens, 0 if now.
+ */
+uint64_t Dma_PacerWait(struct DmaPacer *pacer, uint32_t frames, uint64_t bytes) {
+   uint64_t need;
+   uint64_t wait;
+   uint64_t ret;
+
+   ret = 0;
+
+   if ((pacer->frameRate != 0) && (frames != 0) && (pacer->frameTok < NSEC_PER_SEC))
+      ret = div64_u64(NSEC_PER_SEC - pacer->frameTok + pacer->frameRate - 1, pacer->frameRate);
+
+   need = bytes * NSEC_PER_SEC;
+   if ((pacer->byteRate != 0) && (pacer->byteTok < need)) {
+      wait = div64_u64(need - pacer->byteTok + pacer->byteRate - 1, pacer->byteRate);
+      if (wait > ret) ret = wait;
+   }
+   return ret;
+}
+
+/**
+ * Dma_PacerTake - Charge a released buffer to the buckets
+ * @pacer: pointer to the destination pacer
+ * @buff: buffer being released
+ * @now: current time in ns
+ *
+ * A frame token is charged by the first buffer of a frame only, the
+ * buffers following one with the continue bit set belong to the same
+ * frame. Caller must hold the pacer lock.
+ */
+void Dma_PacerTake(struct DmaPacer *pacer, struct DmaBuffer *buff, uint64_t now) {
+   uint64_t wait;
+
+   if (!pacer->cont) {
+      if (pacer->frameRate != 0) pacer->frameTok -= NSEC_PER_SEC;
+      pacer->frames++;
+   }
+   if (pacer->byteRate != 0) pacer->byteTok -= (uint64_t)buff->size * NSEC_PER_SEC;
+   pacer->cont = (buff->flags & 0x10000) ? 1 : 0;
+
+   wait = now - buff->txTime;
+   pacer->bytes += buff->size;
+   pacer->waitTot += wait;
+   if (wait > pacer->waitMax) pacer->waitMax = wait;
+}
+
+/**
+ * Dma_PacerRate - Convert a count over a time to a rate per second
+ * @count: frames or bytes counted
+ * @elapsed: time in ns, non-zero
+ *
+ * Return: Count per second.
+ */
+uint64_t Dma_PacerRate(uint64_t count, uint64_t elapsed) {
+   // Keep count * NSEC_PER_SEC within 64 bits
+   if (count < (1ULL << 33)) return div64_u64(count * NSEC_PER_SEC, elapsed);
+   return div64_u64(count, div64_u64(elapsed, NSEC_PER_SEC) + 1);
+}
+
+/**
+ * Dma_PacerSend - Send buffers to a paced destination
+ * @dev: pointer to the DMA device structure
+ * @pacer: pointer to the destination pacer
+ * @buff: buffers to send, in order
+ * @cnt: number of buffers, the buffers of a chained frame are passed together
+ *
+ * The buffers are passed to the hardware at once if no frames are waiting
+ * and the buckets hold enough tokens for all of them. Otherwise they join
+ * the pacer queue together and the pacing timer releases them in order.
+ *
+ * Return: Result of sendBuffer, or 1 if the buffers were queued.
+ */
+int32_t Dma_PacerSend(struct DmaDevice *dev, struct DmaPacer *pacer, struct DmaBuffer **buff, uint32_t cnt) {
+   unsigned long iflags;
+   uint64_t bytes;
+   uint64_t wait;
+   uint64_t now;
+   uint32_t x;
+
+   spin_lock_irqsave(&(pacer->lock), iflags);
+
+   now = ktime_get_ns();
+   bytes = 0;
+   for (x = 0; x < cnt; x++) {
+      buff[x]->txTime = now;
+      bytes += buff[x]->size;
+   }
+
+   Dma_PacerRefill(pacer, now);
+
+   // Tokens available, or pacing disabled, and nothing waiting ahead
+   if (list_empty(&(pacer->queue)) && ((wait = Dma_PacerWait(pacer, pacer->cont ? 0 : 1, bytes)) == 0)) {
+      for (x = 0; x < cnt; x++) Dma_PacerTake(pacer, buff[x], now);
+      spin_unlock_irqrestore(&(pacer->lock), iflags);
+      return dev->hwFunc->sendBuffer(dev, buff, cnt);
+   }
+
+   for (x = 0; x < cnt; x++) {
+      list_add_tail(&(buff[x]->destLink), &(pacer->queue));
+      pacer->queued++;
+   }
+
+   if (!pacer->armed) {
+      pacer->armed = 1;
+      wait = Dma_PacerWait(pacer, pacer->cont ? 0 : 1, list_first_entry(&(pacer->queue), struct DmaBuffer, destLink)->size);
+      hrtimer_start(&(pacer->timer), ns_to_ktime(wait), HRTIMER_MODE_REL);
+   }
+
+   spin_unlock_irqrestore(&(pacer->lock), iflags);
+   return 1;
+}
+
+/**
+ * Dma_PacerTimer - Release paced frames whose tokens are available
+ * @timer: pacing timer of the destination
+ *
+ * Releases up to DMA_TX_BATCH frames in order and passes them to the
+ * hardware as one batch, then rearms for the next waiting frame.
+ *
+ * Return: HRTIMER_RESTART while frames are waiting, HRTIMER_NORESTART otherwise.
+ */
+enum hrtimer_restart Dma_PacerTimer(struct hrtimer *timer) {
+   struct DmaBuffer *batch[DMA_TX_BATCH];
+   struct DmaBuffer *buff;
+   struct DmaPacer *pacer;
+   enum hrtimer_restart ret;
+   unsigned long iflags;
+   uint64_t wait;
+   uint64_t now;
+   uint32_t cnt;
+
+   pacer = container_of(timer, struct DmaPacer, timer);
+   cnt = 0;
+   wait = 0;
+
+   spin_lock_irqsave(&(pacer->lock), iflags);
+
+   now = ktime_get_ns();
+   Dma_PacerRefill(pacer, now);
+
+   while ((cnt < DMA_TX_BATCH) && !list_empty(&(pacer->queue))) {
+      buff = list_first_entry(&(pacer->queue), struct DmaBuffer, destLink);
+
+      if ((wait = Dma_PacerWait(pacer, pacer->cont ? 0 : 1, buff->size)) != 0) break;
+      Dma_PacerTake(pacer, buff, now);
+
+      list_del(&(buff->destLink));
+      pacer->queued--;
+      batch[cnt++] = buff;
+   }
+
+   if (list_empty(&(pacer->queue))) {
+      pacer->armed = 0;
+      ret = HRTIMER_NORESTART;
+   } else {
+      hrtimer_forward_now(timer, ns_to_ktime((wait == 0) ? NSEC_PER_USEC : wait));
+      ret = HRTIMER_RESTART;
+   }
+
+   spin_unlock_irqrestore(&(pacer->lock), iflags);
+
+   if (cnt > 0)
+      pacer->dev->hwFunc->sendBuffer(pacer->dev, batch, cnt);
+
+   return ret;
+}
+
+/**
+ * Dma_SetTxPace - Set the transmit rate limits of a destination
+ * @dev: pointer to the DMA device structure
+ * @arg: user space pointer to a DmaTxPace structure
+ *
+ * Frames written to the destination are released to the hardware at no
+ * more than the given frame and byte rates, after an initial burst. The
+ * rates are limited to DMA_PACE_FRAME_MAX and DMA_PACE_BYTE_MAX, which
+ * with the 32-bit bursts keeps the scaled token counts within 64 bits.
+ * The byte burst must hold at least one full buffer. Setting both rates to
+ * zero removes the limit, frames already waiting are released by the
+ * pacing timer. Statistics restart on each call.
+ *
+ * Return: 0 on success, -1 on invalid request, -ENOMEM on allocation failure.
+ */
+int32_t Dma_SetTxPace(struct DmaDevice *dev, uint64_t arg) {
+   struct DmaTxPace pace;
+   struct DmaPacer *pacer;
+   struct DmaPacer *newPacer;
+   unsigned long iflags;
+   int32_t ret;
+
+   if ((ret = copy_from_user(&pace, (void *)arg, sizeof(struct DmaTxPace)))) {
+      dev_warn(dev->device, "Dma_SetTxPace: copy_from_user failed. ret=%i, user=%p kern=%p\n",
+               ret, (void *)arg, &pace);
+      return -1;
+   }
+
+   if (pace.dest >= DMA_MAX_DEST) return -1;
+   if ((pace.frameRate > DMA_PACE_FRAME_MAX) || (pace.byteRate > DMA_PACE_BYTE_MAX)) return -1;
+   if (pace.frameBurst == 0) pace.frameBurst = 1;
+   if ((pace.byteRate != 0) && (pace.byteBurst < dev->cfgSize)) return -1;
+
+   // Allocate outside of the lock, freed below if another call won
+   if ((pacer = dev->pacer[pace.dest]) == NULL) {
+      if ((newPacer = (struct DmaPacer *)kzalloc(sizeof(struct DmaPacer), GFP_KERNEL)) == NULL)
+         return -ENOMEM;
+
+      newPacer->dev = dev;
+      spin_lock_init(&(newPacer->lock));
+      INIT_LIST_HEAD(&(newPacer->queue));
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 13, 0)
+      hrtimer_setup(&(newPacer->timer), Dma_PacerTimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+#else
+      hrtimer_init(&(newPacer->timer), CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+      newPacer->timer.function = Dma_PacerTimer;
+#endif
+
+      spin_lock_irqsave(&(dev->txLock), iflags);
+      if ((pacer = dev->pacer[pace.dest]) == NULL) {
+         pacer = newPacer;
+         newPacer = NULL;
+         dev->pacer[pace.dest] = pacer;
+      }
+      spin_unlock_irqrestore(&(dev->txLock), iflags);
+      kfree(newPacer);
+   }
+
+   spin_lock_irqsave(&(pacer->lock), iflags);
+
+   pacer->frameRate = pace.frameRate;
+   pacer->byteRate  = pace.byteRate;
+   pacer->frameMax  = (uint64_t)pace.frameBurst * NSEC_PER_SEC;
+   pacer->byteMax   = (uint64_t)pace.byteBurst * NSEC_PER_SEC;
+   pacer->frameFill = (pace.frameRate == 0) ? 0 : div64_u64(pacer->frameMax, pace.frameRate) + 1;
+   pacer->byteFill  = (pace.byteRate == 0) ? 0 : div64_u64(pacer->byteMax, pace.byteRate) + 1;
+
+   // Start with full buckets
+   pacer->frameTok = pacer->frameMax;
+   pacer->byteTok  = pacer->byteMax;
+   pacer->last     = ktime_get_ns();
+
+   pacer->start   = pacer->last;
+   pacer->frames  = 0;
+   pacer->bytes   = 0;
+   pacer->waitTot = 0;
+   pacer->waitMax = 0;
+
+   // Reschedule waiting frames against the new rates
+   if (!list_empty(&(pacer->queue)) && !pacer->armed) {
+      pacer->armed = 1;
+      hrtimer_start(&(pacer->timer), ns_to_ktime(0), HRTIMER_MODE_REL);
+   }
+
+   spin_unlock_irqrestore(&(pacer->lock), iflags);
+
+   if (dmaDebug(dev))
+      dev_info(dev->device, "Dma_SetTxPace: Dest=%i, FrameRate=%llu, ByteRate=%llu, FrameBurst=%i, ByteBurst=%i.\n",
+               pace.dest, pace.frameRate, pace.byteRate, pace.frameBurst, pace.byteBurst);
+   return 0;
+}
+
+/**
+ * Dma_LaunchStats - Record the launch error of a scheduled frame
+ * @dev: pointer to the DMA device structure
+ * @buff: frame being launched
+ * @now: current time in ns
+ *
+ * Caller must hold the device launchLock.
+ */
+void Dma_LaunchStats(struct DmaDevice *dev, struct DmaBuffer *buff, uint64_t now) {
+   uint64_t err;
+
+   err = now - buff->launch;
+   dev->launchFrames++;
+   dev->launchErrTot += err;
+   if (err > dev->launchErrMax) dev->launchErrMax = err;
+}
+
+/**
+ * Dma_LaunchSend - Send a frame at a requested time
+ * @dev: pointer to the DMA device structure
+ * @buff: frame to send
+ * @launch: launch time in ns on the CLOCK_MONOTONIC time base
+ *
+ * The frame is held in the launch queue, ordered by launch time, and
+ * passed to the hardware by the launch timer. A frame whose launch time
+ * has already passed is sent at once and counted as late. Scheduled
+ * frames are not subject to destination pacing.
+ *
+ * Return: Result of sendBuffer, or 1 if the frame was queued.
+ */
+int32_t Dma_LaunchSend(struct DmaDevice *dev, struct DmaBuffer *buff, uint64_t launch) {
+   struct rb_node **link;
+   struct rb_node *parent;
+   unsigned long iflags;
+   uint32_t first;
+   uint64_t now;
+
+   buff->launch = launch;
+
+   spin_lock_irqsave(&(dev->launchLock), iflags);
+   now = ktime_get_ns();
+
+   // Launch time already passed
+   if (launch <= now) {
+      dev->launchLate++;
+      Dma_LaunchStats(dev, buff, now);
+      spin_unlock_irqrestore(&(dev->launchLock), iflags);
+      return dev->hwFunc->sendBuffer(dev, &buff, 1);
+   }
+
+   // Insert after frames with the same launch time
+   link = &(dev->launchQ.rb_node);
+   parent = NULL;
+   first = 1;
+
+   while (*link != NULL) {
+      parent = *link;
+      if (launch < rb_entry(parent, struct DmaBuffer, launchNode)->launch) {
+         link = &(parent->rb_left);
+      } else {
+         link = &(parent->rb_right);
+         first = 0;
+      }
+   }
+
+   rb_link_node(&(buff->launchNode), parent, link);
+   rb_insert_color(&(buff->launchNode), &(dev->launchQ));
+   dev->launchCount++;
+
+   // New earliest frame
+   if (first)
+      hrtimer_start(&(dev->launchTimer), ns_to_ktime(launch), HRTIMER_MODE_ABS);
+
+   spin_unlock_irqrestore(&(dev->launchLock), iflags);
+   return 1;
+}
+
+/**
+ * Dma_LaunchCancel - Drop the scheduled frames of a closing writer
+ * @dev: pointer to the DMA device structure
+ * @desc: descriptor charged for the frames
+ *
+ * Frames are matched on the writer charged for their buffer and returned
+ * to the free pool. The launch timer skips ahead by itself if the
+ * earliest frame was removed.
+ *
+ * Return: Number of frames dropped.
+ */
+uint32_t Dma_LaunchCancel(struct DmaDevice *dev, struct DmaDesc *desc) {
+   struct DmaBuffer *buff;
+   struct DmaBuffer *tmp;
+   struct rb_node *node;
+   struct rb_node *next;
+   unsigned long iflags;
+   LIST_HEAD(drop);
+   uint32_t cnt;
+
+   spin_lock_irqsave(&(dev->launchLock), iflags);
+
+   for (node = rb_first(&(dev->launchQ)); node != NULL; node = next) {
+      next = rb_next(node);
+      buff = rb_entry(node, struct DmaBuffer, launchNode);
+
+      if (buff->txOwner == desc) {
+         rb_erase(node, &(dev->launchQ));
+         dev->launchCount--;
+         list_add_tail(&(buff->destLink), &drop);
+      }
+   }
+
+   spin_unlock_irqrestore(&(dev->launchLock), iflags);
+
+   cnt = 0;
+   list_for_each_entry_safe(buff, tmp, &drop, destLink) {
+      list_del(&(buff->destLink));
+      dmaTxBufferPush(dev, buff);
+      cnt++;
+   }
+   return cnt;
+}
+
+/**
+ * Dma_LaunchTimer - Send scheduled frames whose launch time has come
+ * @timer: launch timer of the device
+ *
+ * Passes up to DMA_TX_BATCH due frames to the hardware as one batch and
+ * restarts the timer for the next frame. The timer is only started with
+ * the launchLock held, so a new earliest frame queued while this runs is
+ * not lost.
+ *
+ * Return: HRTIMER_NORESTART, the timer is restarted explicitly.
+ */
+enum hrtimer_restart Dma_LaunchTimer(struct hrtimer *timer) {
+   struct DmaBuffer *batch[DMA_TX_BATCH];
+   struct DmaBuffer *buff;
+   struct DmaDevice *dev;
+   struct rb_node *node;
+   unsigned long iflags;
+   uint64_t now;
+   uint32_t cnt;
+
+   dev = container_of(timer, struct DmaDevice, launchTimer);
+   cnt = 0;
+
+   spin_lock_irqsave(&(dev->launchLock), iflags);
+   now = ktime_get_ns();
+
+   while ((cnt < DMA_TX_BATCH) && ((node = rb_first(&(dev->launchQ))) != NULL)) {
+      buff = rb_entry(node, struct DmaBuffer, launchNode);
+      if (buff->launch > now) break;
+
+      rb_erase(node, &(dev->launchQ));
+      dev->launchCount--;
+      Dma_LaunchStats(dev, buff, now);
+      batch[cnt++] = buff;
+   }
+
+   if ((node = rb_first(&(dev->launchQ))) != NULL)
+      hrtimer_start(timer, ns_to_ktime(rb_entry(node, struct DmaBuffer, launchNode)->launch), HRTIMER_MODE_ABS);
+
+   spin_unlock_irqrestore(&(dev->launchLock), iflags);
+
+   if (cnt > 0)
+      dev->hwFunc->sendBuffer(dev, batch, cnt);
+
+   return HRTIMER_NORESTART;
+}
+
+/**
+ * Dma_TxDestValid - Check a transmit destination
+ * @dev: pointer to the DMA device structure
+ * @dest: destination to check
+ *
+ * Return: 0 if the hardware accepts frames for @dest, -1 otherwise.
+ */
+int32_t Dma_TxDestValid(struct DmaDevice *dev, uint32_t dest) {
+   if ((dest >= DMA_MAX_DEST) || ((dev->destMask[dest / 8] & (1 << (dest % 8))) == 0)) {
+      dev_warn(dev->device, "Write: Invalid destination %i.\n", dest);
+      return -1;
+   }
+   return 0;
+}
+
+/**
+ * Dma_SendChain - Post the buffers of one frame to the hardware
+ * @dev: pointer to the DMA device structure
+ * @buff: buffers of the frame in order, continue bit set on all but the last
+ * @cnt: number of entries in @buff
+ * @dest: destination of the frame
+ *
+ * The buffers are passed to sendBuffer as one batch so no other frame can
+ * be posted between them. Paced destinations release them in order
+ * through the pacer queue instead.
+ *
+ * Return: Result of the last send, negative on failure.
+ */
+int32_t Dma_SendChain(struct DmaDevice *dev, struct DmaBuffer **buff, uint32_t cnt, uint32_t dest) {
+   struct DmaPacer *pacer;
+   int32_t ret;
+   uint32_t x;
+
+   ret = 0;
+   if ((pacer = dev->pacer[dest]) != NULL) {
+      ret = Dma_PacerSend(dev, pacer, buff, cnt);
+   } else {
+      ret = dev->hwFunc->sendBuffer(dev, buff, cnt);
+   }
+   return ret;
+}
+
+/**
+ * Dma_WriteChain - Send a frame chained over multiple transmit buffers
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the writing descriptor
+ * @seg: user space segments holding the frame, in order
+ * @segCnt: number of entries in @seg
+ * @wr: write request supplying the destination, flags, address width and total size
+ *
+ * Takes all buffers needed for the frame up front, copies the segments
+ * directly into them and sets the continue bit (flags bit 16) on all but
+ * the last buffer. The chain is passed to sendBuffer as one batch so no
+ * other frame can be posted between its buffers.
+ *
+ * Return: Frame size on success, 0 if not enough buffers are available,
+ *         -1 on failure.
+ */
+ssize_t Dma_WriteChain(struct DmaDevice *dev, struct DmaDesc *desc, struct DmaWriteSeg *seg, uint32_t segCnt, struct DmaWriteData *wr) {
+   struct DmaBuffer **buff;
+   ssize_t ret;
+   uint64_t left;
+   uint32_t got;
+   uint32_t cnt;
+   uint32_t off;
+   uint32_t len;
+   uint32_t b;
+   uint32_t x;
+   void *dp;
+
+   if ((wr->size == 0) || (dev->cfgSize == 0)) return -1;
+
+   cnt = (wr->size + dev->cfgSize - 1) / dev->cfgSize;
+
+   // Chain can never be satisfied
+   if ((cnt > dev->txBuffers.count) || ((desc->txLimit != 0) && (cnt > desc->txLimit))) {
+      dev_warn(dev->device, "Write: frame of %i bytes needs %i TX buffers.\n", wr->size, cnt);
+      return -1;
+   }
+
+   if ((buff = (struct DmaBuffer **)kmalloc(cnt * sizeof(struct DmaBuffer *), GFP_KERNEL)) == NULL)
+      return -ENOMEM;
+
+   // Take every buffer of the chain or none
+   for (got = 0; got < cnt; got++) {
+      if ((buff[got] = dmaTxBufferPop(dev, desc)) == NULL) {
+         ret = 0;
+         goto cleanup;
+      }
+   }
+
+   // Copy the segments into the chain
+   b = 0;
+   off = 0;
+   for (x = 0; x < segCnt; x++) {
+      dp = (sizeof(void *) == 4 || wr->is32) ? (void *)(seg[x].data & 0xFFFFFFFF) : (void *)seg[x].data;
+      left = seg[x].size;
+
+      while (left > 0) {
+         len = min_t(uint64_t, left, dev->cfgSize - off);
+
+         // Segments larger than the frame size
+         if (b >= cnt) {
+            dev_warn(dev->device, "Write: segments exceed frame size %i.\n", wr->size);
+            ret = -1;
+            goto cleanup;
+         }
+
+         if (copy_from_user(buff[b]->buffAddr + off, dp, len)) {
+            dev_warn(dev->device, "Write: failed to copy data from user space user=%p kern=%p size=%i.\n",
+                     dp, buff[b]->buffAddr + off, len);
+            ret = -1;
+            goto cleanup;
+         }
+
+         dp += len;
+         off += len;
+         left -= len;
+
+         if (off == dev->cfgSize) {
+            buff[b++]->size = off;
+            off = 0;
+         }
+      }
+   }
+   if (off != 0) buff[b]->size = off;
+
+   // Continue bit on all but the last buffer
+   for (x = 0; x < cnt; x++) {
+      buff[x]->count++;
+      buff[x]->dest = wr->dest;
+      buff[x]->flags = (x == (cnt - 1)) ? wr->flags : (wr->flags | 0x10000);
+   }
+
+   ret = Dma_SendChain(dev, buff, cnt, wr->dest);
+
+   if (dmaDebug(dev))
+      dev_info(dev->device, "Write: Size=%i, Dest=%i, Flags=0x%.8x, Buffers=%i, res=%li\n",
+               wr->size, wr->dest, wr->flags, cnt, ret);
+
+   kfree(buff);
+   return (ret < 0) ? ret : wr->size;
+
+cleanup:
+   while (got-- > 0) dmaTxBufferPush(dev, buff[got]);
+   kfree(buff);
+   return ret;
+}
+
+/**
+ * Dma_WriteGather - Send one frame gathered from multiple user buffers
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the writing descriptor
+ * @arg: user space pointer to a DmaWriteGather structure
+ *
+ * Return: Frame size on success, 0 if not enough buffers are available,
+ *         -1 on failure.
+ */
+ssize_t Dma_WriteGather(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg) {
+   struct DmaWriteGather gat;
+   struct DmaWriteData wr;
+   struct DmaWriteSeg *seg;
+   uint64_t total;
+   ssize_t ret;
+   uint32_t x;
+
+   if ((ret = copy_from_user(&gat, (void *)arg, sizeof(struct DmaWriteGather)))) {
+      dev_warn(dev->device, "Dma_WriteGather: copy_from_user failed. ret=%li, user=%p kern=%p\n",
+               ret, (void *)arg, &gat);
+      return -1;
+   }
+
+   if ((gat.segCount == 0) || (gat.segCount > DMA_MAX_SEGS)) return -1;
+   if (Dma_TxDestValid(dev, gat.dest) < 0) return -1;
+   if (sizeof(void *) == 4 || gat.is32) gat.segs &= 0xFFFFFFFF;
+
+   if ((seg = (struct DmaWriteSeg *)kmalloc(gat.segCount * sizeof(struct DmaWriteSeg), GFP_KERNEL)) == NULL)
+      return -ENOMEM;
+
+   if (copy_from_user(seg, (void *)gat.segs, gat.segCount * sizeof(struct DmaWriteSeg))) {
+      dev_warn(dev->device, "Dma_WriteGather: failed to copy segments from user space\n");
+      kfree(seg);
+      return -1;
+   }
+
+   // Total frame size, bounded by the 32-bit frame size and the transmit pool
+   total = 0;
+   for (x = 0; x < gat.segCount; x++) {
+      if (seg[x].size > U32_MAX) total = (uint64_t)U32_MAX + 1;
+      else total += seg[x].size;
+   }
+
+   if ((total == 0) || (total > U32_MAX) || (total > ((uint64_t)dev->txBuffers.count * dev->cfgSize))) {
+      kfree(seg);
+      return -1;
+   }
+
+   memset(&wr, 0, sizeof(struct DmaWriteData));
+   wr.dest  = gat.dest;
+   wr.flags = gat.flags;
+   wr.size  = total;
+   wr.is32  = gat.is32;
+
+   ret = Dma_WriteChain(dev, desc, seg, gat.segCount, &wr);
+   kfree(seg);
+   return ret;
+}
+
+/**
+ * Dma_FrameInfo - Get the size, flags and error of a received frame
+ * @buff: first buffer of the frame
+ * @flags: returns the frame flags
+ * @error: returns the frame error
+ *
+ * For a reassembled frame the first user field is taken from the first
+ * buffer and the last user and continue fields from the last buffer.
+ * The errors of all buffers are combined, a frame truncated at the
+ * reassembly limit also reports DMA_ERR_MAX.
+ *
+ * Return: The frame size in bytes.
+ */
+uint32_t Dma_FrameInfo(struct DmaBuffer *buff, uint32_t *flags, uint32_t *error) {
+   struct DmaBuffer *tail;
+   uint32_t size;
+
+   size = 0;
+   *error = 0;
+
+   for (tail = buff; tail->chainNext != NULL; tail = tail->chainNext) {
+      size += tail->size;
+      *error |= tail->error;
+   }
+   size += tail->size;
+   *error |= tail->error;
+
+   if (tail == buff) {
+      *flags = buff->flags;
+   } else {
+      *flags = (buff->flags & 0x000000FF) | (tail->flags & 0x0001FF00);
+      if (tail->flags & 0x10000) *error |= DMA_ERR_MAX;
+   }
+   return size;
+}
+
+/**
+ * Dma_CopyChain - Copy a received frame to user space
+ * @dev: pointer to the DMA device structure
+ * @buff: first buffer of the frame
+ * @dp: user space destination, large enough for the frame
+ *
+ * Return: The number of bytes copied, or -1 on failure.
+ */
+ssize_t Dma_CopyChain(struct DmaDevice *dev, struct DmaBuffer *buff, void *dp) {
+   ssize_t ret;
+   size_t off;
+
+   for (off = 0; buff != NULL; buff = buff->chainNext) {
+      if (buff->zcUser) {
+         if (Dma_ZcCopyUser(dev, buff, dp + off) < 0) return -1;
+      } else if ((ret = copy_to_user(dp + off, buff->buffAddr, buff->size))) {
+         dev_warn(dev->device, "Read: failed to copy data to user space ret=%li, user=%p kern=%p size=%u.\n",
+                  ret, dp + off, buff->buffAddr, buff->size);
+         return -1;
+      }
+      off += buff->size;
+   }
+   return off;
+}
+
+/**
+ * Dma_RetChain - Return the buffers of a received frame to the hardware
+ * @dev: pointer to the DMA device structure
+ * @buff: first buffer of the frame
+ *
+ * Return: The number of buffers returned.
+ */
+uint32_t Dma_RetChain(struct DmaDevice *dev, struct DmaBuffer *buff) {
+   struct DmaBuffer *next;
+   uint32_t cnt;
+
+   for (cnt = 0; buff != NULL; cnt++) {
+      next = buff->chainNext;
+      buff->chainNext = NULL;
+      dev->hwFunc->retRxBuffer(dev, &buff, 1);
+      buff = next;
+   }
+   return cnt;
+}
+
+/**
+ * Dma_SetRxChain - Enable or disable receive frame reassembly
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @max: maximum buffers per reassembled frame, 0 to disable, at most half the receive buffers
+ *
+ * When enabled, buffers received with the continue bit set are held
+ * until the frame completes and then queued as a single frame. Frames
+ * still open when reassembly is disabled are dropped.
+ *
+ * Return: 0 on success, -1 on invalid limit, -ENOMEM if the chain table
+ *         can not be allocated.
+ */
+int32_t Dma_SetRxChain(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t max) {
+   struct DmaBuffer **chain;
+   struct DmaBuffer **open;
+   unsigned long iflags;
+   uint32_t x;
+
+   // Half of the pool stays available to the hardware and other readers
+   if ((max == 1) || (max > (dev->cfgRxCount / 2))) return -1;
+
+   // Allocate outside of the lock, freed below if not used
+   chain = NULL;
+   if (max > 0) {
+      if ((chain = vzalloc(DMA_MAX_DEST * sizeof(struct DmaBuffer *))) == NULL)
+         return -ENOMEM;
+   }
+
+   // Prevent data reception while changing mode
+   spin_lock_irqsave(&dev->maskLock, iflags);
+
+   open = NULL;
+   if (max > 0) {
+      if (desc->rxChain == NULL) {
+         desc->rxChain = chain;
+         chain = NULL;
+      }
+      desc->rxChainMax = max;
+   } else {
+      open = desc->rxChain;
+      desc->rxChain = NULL;
+   }
+
+   spin_unlock_irqrestore(&dev->maskLock, iflags);
+
+   // Drop incomplete frames
+   if (open != NULL) {
+      for (x = 0; x < DMA_MAX_DEST; x++) {
+         if (open[x] != NULL) Dma_RetChain(dev, open[x]);
+      }
+      vfree(open);
+   }
+
+   vfree(chain);
+   return 0;
+}
+
+/**
+ * Dma_SetRxSmall - Enable or disable small frame copy-out
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @arg: user space pointer to a DmaRxSmall structure
+ *
+ * Frames up to the given size are copied into a ring of the descriptor
+ * on arrival and their buffers are returned to the hardware at once,
+ * see dmaRxSmall. Frames still in the ring are dropped when it is
+ * replaced or disabled.
+ *
+ * Return: 0 on success, -1 on invalid request, -ENOMEM if the ring can
+ *         not be allocated.
+ */
+int32_t Dma_SetRxSmall(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg) {
+   struct DmaRxSmall rs;
+   unsigned long iflags;
+   uint8_t *ring;
+   long ret;
+
+   if ((ret = copy_from_user(&rs, (void *)arg, sizeof(struct DmaRxSmall)))) {
+      dev_warn(dev->device, "Dma_SetRxSmall: copy_from_user failed. ret=%li, user=%p kern=%p\n",
+               ret, (void *)arg, &rs);
+      return -1;
+   }
+
+   ring = NULL;
+   if (rs.max > 0) {
+      if ((rs.max > dev->cfgSize) || (rs.size > 0x4000000) ||
+          (rs.size < (sizeof(struct DmaPackedHdr) + DMA_PACKED_ALIGN(rs.max)))) return -1;
+
+      rs.size = roundup_pow_of_two(rs.size);
+
+      if ((ring = vzalloc(rs.size)) == NULL) return -ENOMEM;
+   }
+
+   mutex_lock(&(desc->rxSmallLock));
+
+   // Prevent data reception while changing mode
+   spin_lock_irqsave(&dev->maskLock, iflags);
+   swap(ring, desc->rxSmall);
+   desc->rxSmallMax  = rs.max;
+   desc->rxSmallSize = rs.size;
+   desc->rxSmallHead = 0;
+   desc->rxSmallTail = 0;
+   spin_unlock_irqrestore(&dev->maskLock, iflags);
+
+   mutex_unlock(&(desc->rxSmallLock));
+
+   vfree(ring);
+   return 0;
+}
+
+/**
+ * Dma_SmallCopy - Copy records from the small frame ring to user space
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @data: user buffer receiving the records
+ * @size: size of the user buffer
+ * @count: maximum number of records, 0 for no limit
+ * @used: returns the number of bytes copied
+ *
+ * Whole records are copied from the ring to the user buffer as they are
+ * stored, in at most two copies when the records wrap around the end of
+ * the ring.
+ *
+ * Return: Number of frames copied, -1 on failure or if the user buffer
+ *         can not hold the next frame.
+ */
+int32_t Dma_SmallCopy(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t data, uint32_t size, uint32_t count, uint32_t *used) {
+   struct DmaPackedHdr hdr;
+   uint32_t head;
+   uint32_t tail;
+   uint32_t pos;
+   uint32_t off;
+   uint32_t len;
+   int32_t cnt;
+
+   *used = 0;
+   mutex_lock(&(desc->rxSmallLock));
+
+   if (desc->rxSmall == NULL) {
+      mutex_unlock(&(desc->rxSmallLock));
+      return 0;
+   }
+
+   // Records up to the head are complete
+   head = READ_ONCE(desc->rxSmallHead);
+   smp_rmb();
+   tail = desc->rxSmallTail;
+
+   // Whole records which fit the user buffer
+   for (cnt = 0, pos = tail; (pos != head) && ((count == 0) || (cnt < count)); cnt++) {
+      dmaRxSmallGet(desc, pos, &hdr, sizeof(struct DmaPackedHdr));
+      len = sizeof(struct DmaPackedHdr) + DMA_PACKED_ALIGN(hdr.size);
+
+      if ((pos - tail + len) > size) break;
+      pos += len;
+   }
+
+   if ((cnt == 0) && (pos != head)) {
+      dev_warn(dev->device, "Dma_SmallCopy: user buffer is too small. Rx=%i, User=%i.\n", hdr.size, size);
+      cnt = -1;
+   }
+
+   // Copy the records in one run, or two when they wrap
+   if (cnt > 0) {
+      off = tail & (desc->rxSmallSize - 1);
+      len = min_t(uint32_t, pos - tail, desc->rxSmallSize - off);
+
+      if (copy_to_user((void *)data, desc->rxSmall + off, len) ||
+          (((pos - tail) > len) && copy_to_user((void *)(data + len), desc->rxSmall, pos - tail - len))) {
+         dev_warn(dev->device, "Dma_SmallCopy: failed to copy frames to user space\n");
+         cnt = -1;
+      } else {
+         // Release the space after the copy completed
+         smp_mb();
+         WRITE_ONCE(desc->rxSmallTail, pos);
+         *used = pos - tail;
+      }
+   }
+
+   mutex_unlock(&(desc->rxSmallLock));
+   return cnt;
+}
+
+/**
+ * Dma_ReadSmall - Read copied out small frames
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @arg: user space pointer to a DmaReadPacked structure
+ *
+ * Return: Number of frames read, 0 if none are waiting, -1 on failure or
+ *         if the user buffer can not hold the next frame.
+ */
+int32_t Dma_ReadSmall(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg) {
+   struct DmaReadPacked rp;
+   uint32_t used;
+   int32_t cnt;
+   long ret;
+
+   if ((ret = copy_from_user(&rp, (void *)arg, sizeof(struct DmaReadPacked)))) {
+      dev_warn(dev->device, "Dma_ReadSmall: copy_from_user failed. ret=%li, user=%p kern=%p\n",
+               ret, (void *)arg, &rp);
+      return -1;
+   }
+
+   if (sizeof(void *) == 4 || rp.is32) rp.data &= 0xFFFFFFFF;
+
+   cnt = Dma_SmallCopy(dev, desc, rp.data, rp.size, rp.count, &used);
+
+   if (dmaDebug(dev))
+      dev_info(dev->device, "Dma_ReadSmall: Frames=%i, Bytes=%i.\n", cnt, used);
+
+   return cnt;
+}
+
+/**
+ * Dma_PackPut - Append to a packed read
+ * @pk: packed read state
+ * @src: kernel source, or NULL to take @size bytes from the user region of @buff
+ * @buff: buffer holding the data when @src is NULL
+ * @size: number of bytes
+ *
+ * Data is collected in the staging buffer and written to user space a
+ * full staging buffer at a time. Data larger than the staging buffer is
+ * copied directly.
+ *
+ * Return: 0 on success, -1 on failure.
+ */
+int32_t Dma_PackPut(struct DmaPackState *pk, void *src, struct DmaBuffer *buff, uint32_t size) {
+   if ((pk->fill + size) > pk->stageSize) {
+      if (Dma_PackFlush(pk) < 0) return -1;
+   }
+
+   // Direct copy of large data
+   if (size > pk->stageSize) {
+      if (src == NULL) {
+         if (Dma_ZcCopyUser(pk->dev, buff, (void *)(pk->data + pk->done)) < 0) return -1;
+      } else if (copy_to_user((void *)(pk->data + pk->done), src, size)) {
+         return -1;
+      }
+      pk->done += size;
+      return 0;
+   }
+
+   if (src == NULL)
+      dmaZcCopy(buff->zcRegion, buff->zcTag, pk->stage + pk->fill, size);
+   else
+      memcpy(pk->stage + pk->fill, src, size);
+
+   pk->fill += size;
+   return 0;
+}
+
+/**
+ * Dma_PackFlush - Write the staged part of a packed read to user space
+ * @pk: packed read state
+ *
+ * Return: 0 on success, -1 on failure.
+ */
+int32_t Dma_PackFlush(struct DmaPackState *pk) {
+   if (pk->fill == 0) return 0;
+
+   if (copy_to_user((void *)(pk->data + pk->done), pk->stage, pk->fill)) return -1;
+
+   pk->done += pk->fill;
+   pk->fill = 0;
+   return 0;
+}
+
+/**
+ * Dma_ReadPacked - Read many frames packed into one user buffer
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @arg: user space pointer to a DmaReadPacked structure
+ *
+ * Copied out small frames are returned first, then queued frames which
+ * fit the user buffer, each as a DmaPackedHdr followed by the frame data.
+ * Queued frames are gathered in a staging buffer so that a run of frames
+ * is written with one copy_to_user, and their buffers are returned to the
+ * hardware in one call. Not available with per-destination queues.
+ *
+ * Return: Number of frames read, 0 if none are waiting, -1 on failure or
+ *         if the user buffer can not hold the next frame.
+ */
+int32_t Dma_ReadPacked(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg) {
+   struct DmaReadPacked rp;
+   struct DmaPackedHdr hdr;
+   struct DmaPackState pk;
+   struct DmaBuffer **buff;
+   struct DmaBuffer **ret;
+   struct DmaBuffer *next;
+   uint64_t pad;
+   uint32_t space;
+   uint32_t used;
+   uint32_t rCnt;
+   uint32_t total;
+   ssize_t bCnt;
+   int32_t cnt;
+   ssize_t x;
+   long res;
+
+   if ((res = copy_from_user(&rp, (void *)arg, sizeof(struct DmaReadPacked)))) {
+      dev_warn(dev->device, "Dma_ReadPacked: copy_from_user failed. ret=%li, user=%p kern=%p\n",
+               res, (void *)arg, &rp);
+      return -1;
+   }
+
+   if (sizeof(void *) == 4 || rp.is32) rp.data &= 0xFFFFFFFF;
+
+   if (desc->destQ != NULL) {
+      dev_warn(dev->device, "Dma_ReadPacked: not available with per destination queues\n");
+      return -1;
+   }
+
+   // Copied out frames are older than any queued frame
+   if ((cnt = Dma_SmallCopy(dev, desc, rp.data, rp.size, rp.count, &used)) < 0) return -1;
+   if ((READ_ONCE(desc->rxSmallHead) != READ_ONCE(desc->rxSmallTail)) || ((rp.count != 0) && (cnt == rp.count)))
+      return cnt;
+
+   rCnt = ((rp.count == 0) || ((rp.count - cnt) > dev->cfgRxCount)) ? dev->cfgRxCount : (rp.count - cnt);
+   if ((buff = (struct DmaBuffer **)kmalloc(rCnt * sizeof(struct DmaBuffer *), GFP_KERNEL)) == NULL) return -ENOMEM;
+
+   // Take the queued frames which fit
+   space = rp.size - used;
+   bCnt = dmaQueuePopFit(&(desc->q), buff, rCnt, &space);
+
+   if ((bCnt == 0) && (cnt == 0) && dmaQueueNotEmpty(&(desc->q))) {
+      dev_warn(dev->device, "Dma_ReadPacked: user buffer is too small, User=%i.\n", rp.size);
+      kfree(buff);
+      return -1;
+   }
+
+   if (bCnt == 0) {
+      kfree(buff);
+      return cnt;
+   }
+
+   pad = 0;
+   memset(&pk, 0, sizeof(struct DmaPackState));
+   pk.dev  = dev;
+   pk.data = rp.data + used;
+   pk.stageSize = min_t(uint32_t, rp.size - used - space, DMA_PACK_STAGE);
+   pk.stage = kmalloc(pk.stageSize, GFP_KERNEL);
+
+   // Pack the frames, collecting all of their buffers for a single return
+   total = 0;
+   for (x = 0; x < bCnt; x++) {
+      dmaLcMarkFrame(dev, buff[x], DMA_LC_QUEUE);
+      trace_dma_queue_pop(desc, buff[x]);
+      for (next = buff[x]; next != NULL; next = next->chainNext) total++;
+   }
+   ret = (struct DmaBuffer **)kmalloc(total * sizeof(struct DmaBuffer *), GFP_KERNEL);
+
+   if ((pk.stage == NULL) || (ret == NULL)) {
+      cnt = -ENOMEM;
+   } else {
+      for (x = 0; (x < bCnt) && (cnt >= 0); x++) {
+         hdr.size = Dma_FrameInfo(buff[x], &hdr.flags, &hdr.error);
+         hdr.dest = buff[x]->dest;
+
+         if (Dma_PackPut(&pk, &hdr, NULL, sizeof(struct DmaPackedHdr)) < 0) cnt = -1;
+
+         for (next = buff[x]; (next != NULL) && (cnt >= 0); next = next->chainNext) {
+            if (Dma_PackPut(&pk, next->zcUser ? NULL : next->buffAddr, next, next->size) < 0) cnt = -1;
+         }
+
+         // Zero padding up to the next record
+         if ((cnt >= 0) && (DMA_PACKED_ALIGN(hdr.size) > hdr.size)) {
+            if (Dma_PackPut(&pk, &pad, NULL, DMA_PACKED_ALIGN(hdr.size) - hdr.size) < 0) cnt = -1;
+         }
+
+         if (cnt >= 0) cnt++;
+      }
+
+      if ((cnt >= 0) && (Dma_PackFlush(&pk) < 0)) cnt = -1;
+
+      if (cnt < 0)
+         dev_warn(dev->device, "Dma_ReadPacked: failed to copy frames to user space\n");
+   }
+
+   // Return all buffers to the hardware at once
+   if (ret != NULL) {
+      for (x = 0, total = 0; x < bCnt; x++) {
+         while (buff[x] != NULL) {
+            next = buff[x]->chainNext;
+            buff[x]->chainNext = NULL;
+            ret[total++] = buff[x];
+            buff[x] = next;
+         }
+      }
+      dev->hwFunc->retRxBuffer(dev, ret, total);
+   } else {
+      for (x = 0; x < bCnt; x++) Dma_RetChain(dev, buff[x]);
+   }
+
+   if (dmaDebug(dev))
+      dev_info(dev->device, "Dma_ReadPacked: Frames=%i, Bytes=%i.\n", cnt, pk.done + used);
+
+   kfree(pk.stage);
+   kfree(ret);
+   kfree(buff);
+   return cnt;
+}
+
+/**
+ * Dma_SetReadExt - Select extended read records
+ * @dev: pointer to the DMA device
+ * @desc: pointer to the DMA descriptor
+ * @enable: non-zero to read DmaReadDataExt records, zero for DmaReadData
+ *
+ * The receive path reads the clock at harvest and queue push only while
+ * a descriptor of the device has extended records enabled. Sequence
+ * numbers are always kept.
+ *
+ * Return: 0 on success.
+ */
+int32_t Dma_SetReadExt(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t enable) {
+   unsigned long iflags;
+
+   spin_lock_irqsave(&dev->maskLock, iflags);
+
+   if (enable && !desc->readExt) {
+      desc->readExt = 1;
+      dev->rxStamp++;
+   } else if (!enable && desc->readExt) {
+      desc->readExt = 0;
+      dev->rxStamp--;
+   }
+
+   spin_unlock_irqrestore(&dev->maskLock, iflags);
+   return 0;
+}
+
+/**
+ * Dma_ReadFrame - Read one received frame with all of its buffers
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @arg: user space pointer to a DmaReadFrame structure
+ *
+ * With a data pointer the frame is gathered into the user buffer and its
+ * buffers are returned to the hardware. Without one the indexes of all
+ * buffers of the frame are written to the index array and passed to the
+ * descriptor, to be returned with DMA_Ret_Index.
+ *
+ * Return: 1 if a frame was read, 0 if none is waiting, -1 on failure.
+ */
+int32_t Dma_ReadFrame(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg) {
+   struct DmaReadFrame fr;
+   struct DmaBuffer *buff;
+   struct DmaBuffer *next;
+   uint32_t *index;
+   uint32_t size;
+   uint32_t cnt;
+   uint32_t x;
+   ssize_t bCnt;
+   ssize_t ret;
+
+   if ((ret = copy_from_user(&fr, (void *)arg, sizeof(struct DmaReadFrame)))) {
+      dev_warn(dev->device, "Dma_ReadFrame: copy_from_user failed. ret=%li, user=%p kern=%p\n",
+               ret, (void *)arg, &fr);
+      return -1;
+   }
+
+   if (sizeof(void *) == 4 || fr.is32) {
+      fr.data  &= 0xFFFFFFFF;
+      fr.index &= 0xFFFFFFFF;
+   }
+
+   if ((fr.data == 0) && ((fr.index == 0) || (fr.count == 0))) return -1;
+
+   // Get the next frame
+   if (desc->destQ != NULL)
+      bCnt = dmaDestQueuePopList(desc, NULL, 0, &buff, 1);
+   else
+      bCnt = dmaQueuePopList(&(desc->q), &buff, 1);
+
+   if (bCnt == 0) return 0;
+   dmaLcMarkFrame(dev, buff, DMA_LC_QUEUE);
+   trace_dma_queue_pop(desc, buff);
+
+   size = Dma_FrameInfo(buff, &(fr.flags), &(fr.error));
+   fr.dest = buff->dest;
+   fr.ret  = size;
+
+   for (cnt = 0, next = buff; next != NULL; next = next->chainNext) cnt++;
+
+   // Gather into the user buffer
+   if (fr.data != 0) {
+      if (fr.size < size) {
+         dev_warn(dev->device, "Dma_ReadFrame: user buffer is too small. Rx=%i, User=%i.\n", size, fr.size);
+         fr.error |= DMA_ERR_MAX;
+         fr.ret = -1;
+      } else if (Dma_CopyChain(dev, buff, (void *)fr.data) < 0) {
+         fr.ret = -1;
+      }
+      Dma_RetChain(dev, buff);
+
+   // Index array too small for the frame
+   } else if (fr.count < cnt) {
+      dev_warn(dev->device, "Dma_ReadFrame: index array is too small. Rx=%i, User=%i.\n", cnt, fr.count);
+      fr.error |= DMA_ERR_MAX;
+      fr.ret = -1;
+      Dma_RetChain(dev, buff);
+
+   // Pass the buffers to the descriptor
+   } else {
+      index = (uint32_t *)kmalloc(cnt * sizeof(uint32_t), GFP_KERNEL);
+
+      if (index != NULL) {
+         for (x = 0, next = buff; next != NULL; next = next->chainNext) index[x++] = next->index;
+      }
+
+      if ((index == NULL) || copy_to_user((void *)fr.index, index, cnt * sizeof(uint32_t))) {
+         dev_warn(dev->device, "Dma_ReadFrame: failed to copy indexes to user space\n");
+         fr.ret = -1;
+         Dma_RetChain(dev, buff);
+      } else {
+         while (buff != NULL) {
+            next = buff->chainNext;
+            buff->chainNext = NULL;
+            dmaBufferSetUser(buff, desc);
+            buff->userDirty = 1;
+
+            // Indexes reach the data through the mapped buffers only
+            if (buff->zcUser) {
+               dmaZcCopy(buff->zcRegion, buff->zcTag, buff->buffAddr, buff->size);
+               buff->zcUser = 0;
+            }
+            buff = next;
+         }
+      }
+      kfree(index);
+   }
+
+   fr.count = cnt;
+
+   if (dmaDebug(dev)) {
+      dev_info(dev->device, "Dma_ReadFrame: Ret=%i, Dest=%i, Flags=0x%.8x, Error=%i, Buffers=%i.\n",
+               fr.ret, fr.dest, fr.flags, fr.error, cnt);
+   }
+
+   if ((ret = copy_to_user((void *)arg, &fr, sizeof(struct DmaReadFrame)))) {
+      dev_warn(dev->device, "Dma_ReadFrame: copy_to_user failed. ret=%li, user=%p kern=%p\n",
+               ret, (void *)arg, &fr);
+      return -1;
+   }
+   return 1;
+}
+
+/**
+ * Dma_ZcFree - Unmap and unpin a zero-copy region
+ * @dev: pointer to the DMA device structure
+ * @rg: region to free, no longer referenced by any buffer
+ */
+void Dma_ZcFree(struct DmaDevice *dev, struct DmaZcRegion *rg) {
+   uint32_t x;
+
+   for (x = 0; x < rg->mapCount; x++)
+      dma_unmap_page(dev->device, rg->handle[x], PAGE_SIZE, rg->dir);
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+   unpin_user_pages(rg->pages, rg->pageCount);
+#else
+   for (x = 0; x < rg->pageCount; x++) put_page(rg->pages[x]);
+#endif
+
+   vfree(rg->slot);
+   vfree(rg->handle);
+   vfree(rg->pages);
+   kfree(rg);
+}
+
+/**
+ * Dma_ZcAlloc - Pin and map user memory for zero-copy
+ * @dev: pointer to the DMA device structure
+ * @addr: user address of the region
+ * @size: size of the region in bytes
+ * @dir: DMA_TO_DEVICE to transmit from the region, DMA_FROM_DEVICE to receive into it
+ * @rg: returns the allocated region
+ *
+ * Pins the pages of the region and maps each of them for DMA once.
+ *
+ * Return: 0 on success, -1 on invalid request, -ENOMEM on allocation
+ *         failure.
+ */
+int32_t Dma_ZcAlloc(struct DmaDevice *dev, uint64_t addr, uint64_t size, enum dma_data_direction dir, struct DmaZcRegion **rg) {
+   struct DmaZcRegion *nr;
+   uint64_t first;
+   uint64_t last;
+   long ret;
+
+   if ((size == 0) || (addr & 0xF) || ((addr + size) < addr)) return -1;
+
+   first = addr & PAGE_MASK;
+   last  = PAGE_ALIGN(addr + size);
+
+   if (((last - first) >> PAGE_SHIFT) > 0x7FFFFFFF) return -1;
+
+   if ((nr = (struct DmaZcRegion *)kzalloc(sizeof(struct DmaZcRegion), GFP_KERNEL)) == NULL)
+      return -ENOMEM;
+
+   nr->addr = addr;
+   nr->size = size;
+   nr->dir  = dir;
+   nr->pages = (struct page **)vmalloc(((last - first) >> PAGE_SHIFT) * sizeof(struct page *));
+   nr->handle = (dma_addr_t *)vmalloc(((last - first) >> PAGE_SHIFT) * sizeof(dma_addr_t));
+   INIT_LIST_HEAD(&(nr->link));
+
+   if ((nr->pages == NULL) || (nr->handle == NULL)) {
+      Dma_ZcFree(dev, nr);
+      return -ENOMEM;
+   }
+
+   // Pin the pages for the lifetime of the registration, the device writes receive regions
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+   ret = pin_user_pages_fast(first, (last - first) >> PAGE_SHIFT,
+                             (dir == DMA_FROM_DEVICE) ? (FOLL_WRITE | FOLL_LONGTERM) : FOLL_LONGTERM, nr->pages);
+#else
+   ret = get_user_pages_fast(first, (last - first) >> PAGE_SHIFT, (dir == DMA_FROM_DEVICE), nr->pages);
+#endif
+
+   if (ret > 0) nr->pageCount = ret;
+
+   if (ret != ((last - first) >> PAGE_SHIFT)) {
+      dev_warn(dev->device, "Dma_ZcAlloc: failed to pin user pages. ret=%li\n", ret);
+      Dma_ZcFree(dev, nr);
+      return -1;
+   }
+
+   // Map each page once
+   for (nr->mapCount = 0; nr->mapCount < nr->pageCount; nr->mapCount++) {
+      nr->handle[nr->mapCount] = dma_map_page(dev->device, nr->pages[nr->mapCount], 0, PAGE_SIZE, dir);
+
+      if (dma_mapping_error(dev->device, nr->handle[nr->mapCount])) {
+         dev_warn(dev->device, "Dma_ZcAlloc: failed to map user page %i\n", nr->mapCount);
+         Dma_ZcFree(dev, nr);
+         return -1;
+      }
+   }
+
+   *rg = nr;
+   return 0;
+}
+
+/**
+ * Dma_ZcAddId - Assign a descriptor region id
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @rg: region to add
+ *
+ * Transmit and receive regions share the ids of the descriptor.
+ *
+ * Return: Region id on success, -1 if all ids are in use.
+ */
+int32_t Dma_ZcAddId(struct DmaDevice *dev, struct DmaDesc *desc, struct DmaZcRegion *rg) {
+   unsigned long iflags;
+   int32_t id;
+
+   spin_lock_irqsave(&(dev->txLock), iflags);
+   for (id = 0; id < DMA_MAX_ZC_REGION; id++) {
+      if (desc->zcRegion[id] == NULL) {
+         desc->zcRegion[id] = rg;
+         break;
+      }
+   }
+   spin_unlock_irqrestore(&(dev->txLock), iflags);
+
+   return (id == DMA_MAX_ZC_REGION) ? -1 : id;
+}
+
+/**
+ * Dma_RegTxRegion - Register user memory for zero-copy transmit
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @arg: user space pointer to a DmaTxRegion structure
+ *
+ * Pins the pages of the region and maps each of them for DMA once. The
+ * region stays registered until DMA_Unreg_TxRegion or the descriptor
+ * is closed. Only available when the hardware returns transmit buffers
+ * by index.
+ *
+ * Return: Region id on success, -1 on invalid request, -ENOMEM on
+ *         allocation failure.
+ */
+int32_t Dma_RegTxRegion(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg) {
+   struct DmaTxRegion reg;
+   struct DmaZcRegion *rg;
+   unsigned long iflags;
+   uint64_t *done;
+   int32_t id;
+   long ret;
+
+   if (!dev->zeroCopy) {
+      dev_warn(dev->device, "Dma_RegTxRegion: zero-copy transmit is not supported by the hardware\n");
+      return -1;
+   }
+
+   if ((ret = copy_from_user(&reg, (void *)arg, sizeof(struct DmaTxRegion)))) {
+      dev_warn(dev->device, "Dma_RegTxRegion: copy_from_user failed. ret=%li, user=%p kern=%p\n",
+               ret, (void *)arg, &reg);
+      return -1;
+   }
+
+   if (sizeof(void *) == 4 || reg.is32) reg.addr &= 0xFFFFFFFF;
+
+   // Completion ring shared by all regions of the descriptor
+   if (desc->zcDone == NULL) {
+      if ((done = (uint64_t *)kmalloc(dev->cfgTxCount * sizeof(uint64_t), GFP_KERNEL)) == NULL)
+         return -ENOMEM;
+
+      spin_lock_irqsave(&(dev->txLock), iflags);
+      if (desc->zcDone == NULL) {
+         desc->zcDone = done;
+         done = NULL;
+      }
+      spin_unlock_irqrestore(&(dev->txLock), iflags);
+      kfree(done);
+   }
+
+   if ((ret = Dma_ZcAlloc(dev, reg.addr, reg.size, DMA_TO_DEVICE, &rg)) < 0) return ret;
+
+   if ((id = Dma_ZcAddId(dev, desc, rg)) < 0) {
+      Dma_ZcFree(dev, rg);
+      return -1;
+   }
+
+   if (dmaDebug(dev))
+      dev_info(dev->device, "Dma_RegTxRegion: Region %i, Size=%lli, Pages=%i.\n", id, reg.size, rg->pageCount);
+
+   return id;
+}
+
+/**
+ * Dma_UnregTxRegion - Release a zero-copy transmit region
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @id: region id returned by Dma_RegTxRegion
+ *
+ * Return: 0 on success, -1 on invalid id, -EBUSY while frames from the
+ *         region are in flight.
+ */
+int32_t Dma_UnregTxRegion(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t id) {
+   struct DmaZcRegion *rg;
+   unsigned long iflags;
+   int32_t ret;
 
-   // Attempt to copy register data from user space
-   ret = copy_from_user(&rData, (void *)arg, sizeof(struct DmaRegisterData));
-   if (ret) {
-      dev_warn(dev->device, "Dma_WriteRegister: copy_from_user failed. ret=%i, user=%p kern=%p\n",
-               ret, (void *)arg, &rData);
+   if (id >= DMA_MAX_ZC_REGION) return -1;
+
+   ret = 0;
+   spin_lock_irqsave(&(dev->txLock), iflags);
+
+   if (((rg = desc->zcRegion[id]) == NULL) || (rg->dir != DMA_TO_DEVICE)) {
+      ret = -1;
+   } else if (rg->inFlight > 0) {
+      ret = -EBUSY;
+   } else {
+      desc->zcRegion[id] = NULL;
+   }
+
+   spin_unlock_irqrestore(&(dev->txLock), iflags);
+
+   if (ret == 0) Dma_ZcFree(dev, rg);
+   return ret;
+}
+
+/**
+ * Dma_ZcSegment - Find the next contiguous part of a zero-copy frame
+ * @dev: pointer to the DMA device structure
+ * @rg: region holding the frame
+ * @off: offset of the part in the region
+ * @len: bytes remaining in the frame
+ * @addr: returns the DMA address of the part
+ *
+ * Pages which are contiguous in DMA address space are merged, up to the
+ * buffer size the hardware is configured for.
+ *
+ * Return: Size of the part in bytes.
+ */
+uint32_t Dma_ZcSegment(struct DmaDevice *dev, struct DmaZcRegion *rg, uint64_t off, uint64_t len, dma_addr_t *addr) {
+   uint64_t pos;
+   uint32_t page;
+   uint32_t pOff;
+   uint32_t size;
+   uint32_t take;
+
+   pos  = (rg->addr & ~PAGE_MASK) + off;
+   page = pos >> PAGE_SHIFT;
+   pOff = pos & ~PAGE_MASK;
+
+   *addr = rg->handle[page] + pOff;
+   size = 0;
+
+   while ((len > 0) && (size < dev->cfgSize)) {
+      if ((size > 0) && ((rg->handle[page] + pOff) != (*addr + size))) break;
+
+      take = min_t(uint64_t, len, PAGE_SIZE - pOff);
+      take = min_t(uint32_t, take, dev->cfgSize - size);
+
+      size += take;
+      len -= take;
+      pOff = 0;
+      page++;
+   }
+   return size;
+}
+
+/**
+ * Dma_WriteZc - Send a frame directly from a registered user region
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the writing descriptor
+ * @arg: user space pointer to a DmaWriteZc structure
+ *
+ * Each DMA contiguous part of the frame is posted with a transmit buffer
+ * which carries the user address in place of its own memory, chained with
+ * the continue bit as for a copied frame. The buffers count against the
+ * writer's transmit share until the hardware returns them, the last one
+ * then reports the frame tag through DMA_Get_TxDone.
+ *
+ * Return: Frame size on success, 0 if not enough buffers or completion
+ *         entries are available, -1 on failure.
+ */
+ssize_t Dma_WriteZc(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg) {
+   struct DmaWriteZc wz;
+   struct DmaZcRegion *rg;
+   struct DmaBuffer **buff;
+   unsigned long iflags;
+   dma_addr_t addr;
+   uint64_t off;
+   uint64_t left;
+   uint32_t len;
+   uint32_t got;
+   uint32_t cnt;
+   uint32_t x;
+   ssize_t ret;
+
+   if ((ret = copy_from_user(&wz, (void *)arg, sizeof(struct DmaWriteZc)))) {
+      dev_warn(dev->device, "Dma_WriteZc: copy_from_user failed. ret=%li, user=%p kern=%p\n",
+               ret, (void *)arg, &wz);
       return -1;
    }
 
-   // Validate register address range
-   if (((dev->base + rData.address) < dev->rwBase) ||
-       ((dev->base + rData.address + 4) > (dev->rwBase + dev->rwSize))) {
+   if ((wz.region >= DMA_MAX_ZC_REGION) || (wz.size == 0) || (wz.offset & 0xF)) return -1;
+   if (Dma_TxDestValid(dev, wz.dest) < 0) return -1;
+
+   // Hold the region while the frame is prepared
+   spin_lock_irqsave(&(dev->txLock), iflags);
+   if (((rg = desc->zcRegion[wz.region]) != NULL) && (rg->dir == DMA_TO_DEVICE) &&
+       (wz.offset <= rg->size) && (wz.size <= (rg->size - wz.offset)))
+      rg->inFlight++;
+   else
+      rg = NULL;
+   spin_unlock_irqrestore(&(dev->txLock), iflags);
+
+   if (rg == NULL) return -1;
+
+   buff = NULL;
+
+   // Number of contiguous parts
+   for (cnt = 0, off = wz.offset, left = wz.size; left > 0; cnt++) {
+      len = Dma_ZcSegment(dev, rg, off, left, &addr);
+      off += len;
+      left -= len;
+   }
+
+   if ((cnt > dev->txBuffers.count) || ((desc->txLimit != 0) && (cnt > desc->txLimit))) {
+      dev_warn(dev->device, "Dma_WriteZc: frame of %i bytes needs %i TX buffers.\n", wz.size, cnt);
+      ret = -1;
+      goto release;
+   }
+
+   if ((buff = (struct DmaBuffer **)kmalloc(cnt * sizeof(struct DmaBuffer *), GFP_KERNEL)) == NULL) {
+      ret = -ENOMEM;
+      goto release;
+   }
+
+   // Reserve completion entries, one per buffer bounds the frames in flight
+   spin_lock_irqsave(&(dev->txLock), iflags);
+   if ((desc->zcDoneCount + desc->zcInFlight + cnt) <= dev->cfgTxCount) {
+      desc->zcInFlight += cnt;
+      rg->inFlight += cnt;
+      ret = 1;
+   } else {
+      ret = 0;
+   }
+   spin_unlock_irqrestore(&(dev->txLock), iflags);
+
+   if (ret == 0) goto release;
+
+   // Take every buffer of the frame or none
+   for (got = 0; got < cnt; got++) {
+      if ((buff[got] = dmaTxBufferPop(dev, desc)) == NULL) break;
+   }
+
+   if (got < cnt) {
+      while (got-- > 0) dmaTxBufferPush(dev, buff[got]);
+
+      spin_lock_irqsave(&(dev->txLock), iflags);
+      desc->zcInFlight -= cnt;
+      rg->inFlight -= cnt;
+      spin_unlock_irqrestore(&(dev->txLock), iflags);
+
+      ret = 0;
+      goto release;
+   }
+
+   // Point each buffer at its part of the user region
+   for (x = 0, off = wz.offset, left = wz.size; x < cnt; x++) {
+      len = Dma_ZcSegment(dev, rg, off, left, &addr);
+
+      buff[x]->count++;
+      buff[x]->zcRegion = rg;
+      buff[x]->zcHandle = addr;
+      buff[x]->zcTag    = wz.tag;
+      buff[x]->zcLast   = (x == (cnt - 1));
+      buff[x]->size     = len;
+      buff[x]->dest     = wz.dest;
+      buff[x]->flags    = (x == (cnt - 1)) ? wz.flags : (wz.flags | 0x10000);
+
+      off += len;
+      left -= len;
+   }
+
+   // Make the user data visible to the device
+   dmaZcSync(dev, rg, wz.offset, wz.size, 1);
+
+   ret = Dma_SendChain(dev, buff, cnt, wz.dest);
+
+   if (dmaDebug(dev))
+      dev_info(dev->device, "Dma_WriteZc: Region=%i, Offset=%lli, Size=%i, Dest=%i, Buffers=%i, res=%li\n",
+               wz.region, wz.offset, wz.size, wz.dest, cnt, ret);
+
+   if (ret >= 0) ret = wz.size;
+
+release:
+   spin_lock_irqsave(&(dev->txLock), iflags);
+   rg->inFlight--;
+   spin_unlock_irqrestore(&(dev->txLock), iflags);
+
+   kfree(buff);
+   return ret;
+}
+
+/**
+ * Dma_GetTxDone - Return the tags of completed zero-copy frames
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @arg: user space pointer to a DmaTxDone structure
+ *
+ * Return: Number of tags copied to user space, or -1 on failure.
+ */
+int32_t Dma_GetTxDone(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg) {
+   struct DmaTxDone td;
+   unsigned long iflags;
+   uint64_t *tags;
+   uint32_t cnt;
+   ssize_t ret;
+
+   if ((ret = copy_from_user(&td, (void *)arg, sizeof(struct DmaTxDone)))) {
+      dev_warn(dev->device, "Dma_GetTxDone: copy_from_user failed. ret=%li, user=%p kern=%p\n",
+               ret, (void *)arg, &td);
       return -1;
    }
 
-   // Write data to the register
-   writel(rData.data, dev->base + rData.address);
+   if (sizeof(void *) == 4 || td.is32) td.tags &= 0xFFFFFFFF;
 
-   return 0;
+   if ((td.count == 0) || (desc->zcDone == NULL)) return 0;
+   if (td.count > dev->cfgTxCount) td.count = dev->cfgTxCount;
+
+   if ((tags = (uint64_t *)kmalloc(td.count * sizeof(uint64_t), GFP_KERNEL)) == NULL)
+      return -ENOMEM;
+
+   spin_lock_irqsave(&(dev->txLock), iflags);
+   for (cnt = 0; (cnt < td.count) && (desc->zcDoneCount > 0); cnt++) {
+      tags[cnt] = desc->zcDone[desc->zcDoneRead];
+      desc->zcDoneRead = (desc->zcDoneRead + 1) % dev->cfgTxCount;
+      desc->zcDoneCount--;
+   }
+   spin_unlock_irqrestore(&(dev->txLock), iflags);
+
+   ret = cnt;
+   if ((cnt > 0) && copy_to_user((void *)td.tags, tags, cnt * sizeof(uint64_t))) {
+      dev_warn(dev->device, "Dma_GetTxDone: failed to copy tags to user space\n");
+      ret = -1;
+   }
+
+   kfree(tags);
+   return ret;
 }
 
 /**
- * Dma_ReadRegister - Read a register from a DMA device.
- * @dev: pointer to the DmaDevice structure.
- * @arg: user space pointer to DmaRegisterData structure where the read data will be stored.
+ * Dma_RegRxRegion - Register user memory for zero-copy receive
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @arg: user space pointer to a DmaRxRegion structure
  *
- * This function reads a register from the DMA device specified by @dev,
- * using the address specified in the @arg user space DmaRegisterData structure.
- * The read value is then written back to the same structure in user space.
- * If any step fails, the function returns an error.
+ * The region is split into slots of one buffer each which are handed to
+ * the hardware in place of the memory of the receive buffers as they are
+ * posted. The hardware selects a buffer before the destination of the
+ * frame is known, so only a descriptor holding every open destination
+ * may register, and other descriptors can not open destinations until
+ * all slots of the region are given back. Frames which land in a slot are
+ * read by index and reported by their user address, frames received
+ * after the region is released are copied into the driver buffer. A slot
+ * must be contiguous in DMA address
+ * space, slots larger than a page need huge pages or an IOMMU. Only
+ * available when the hardware returns buffers by index.
  *
- * Return: 0 on success, -1 on failure.
+ * Return: Region id on success, -1 on invalid request, -ENOMEM on
+ *         allocation failure.
  */
-int32_t Dma_ReadRegister(struct DmaDevice *dev, uint64_t arg) {
-   int32_t ret;
-   struct DmaRegisterData rData;
+int32_t Dma_RegRxRegion(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg) {
+   struct DmaRxRegion reg;
+   struct DmaZcRegion *rg;
+   unsigned long iflags;
+   dma_addr_t addr;
+   uint64_t off;
+   int32_t id;
+   long ret;
 
-   // Attempt to copy DmaRegisterData structure from user space
-   if ((ret = copy_from_user(&rData, (void *)arg, sizeof(struct DmaRegisterData)))) {
-      dev_warn(dev->device, "Dma_ReadRegister: copy_from_user failed. ret=%i, user=%p kern=%p\n", ret, (void *)arg, &rData);
+   if (!dev->zeroCopy) {
+      dev_warn(dev->device, "Dma_RegRxRegion: zero-copy receive is not supported by the hardware\n");
       return -1;
    }
 
-   // Validate register address within the allowed range
-   if (((dev->base + rData.address) < dev->rwBase) ||
-       ((dev->base + rData.address + 4) > (dev->rwBase + dev->rwSize))) {
+   if ((ret = copy_from_user(&reg, (void *)arg, sizeof(struct DmaRxRegion)))) {
+      dev_warn(dev->device, "Dma_RegRxRegion: copy_from_user failed. ret=%li, user=%p kern=%p\n",
+               ret, (void *)arg, &reg);
       return -1;
    }
 
-   // Read register value
-   rData.data = readl(dev->base + rData.address);
+   if (sizeof(void *) == 4 || reg.is32) reg.addr &= 0xFFFFFFFF;
 
-   // Attempt to copy the updated DmaRegisterData structure back to user space
-   if ((ret = copy_to_user((void *)arg, &rData, sizeof(struct DmaRegisterData)))) {
-      dev_warn(dev->device, "Dma_ReadRegister: copy_to_user failed. ret=%i, user=%p kern=%p\n", ret, (void *)arg, &rData);
+   if (reg.size < dev->cfgSize) return -1;
+
+   // Free regions released earlier
+   Dma_RxZcReap(dev);
+
+   if ((ret = Dma_ZcAlloc(dev, reg.addr, reg.size, DMA_FROM_DEVICE, &rg)) < 0) return ret;
+
+   rg->owner = desc;
+
+   if ((rg->slot = (uint64_t *)vmalloc((reg.size / dev->cfgSize) * sizeof(uint64_t))) == NULL) {
+      Dma_ZcFree(dev, rg);
+      return -ENOMEM;
+   }
+
+   // Keep the slots which are contiguous for the device
+   for (off = 0; (off + dev->cfgSize) <= reg.size; off += dev->cfgSize) {
+      if (Dma_ZcSegment(dev, rg, off, dev->cfgSize, &addr) == dev->cfgSize)
+         rg->slot[rg->slotCount++] = off;
+   }
+
+   if (rg->slotCount == 0) {
+      dev_warn(dev->device, "Dma_RegRxRegion: no DMA contiguous slot of %i bytes in region\n", dev->cfgSize);
+      Dma_ZcFree(dev, rg);
+      return -1;
+   }
+
+   if ((id = Dma_ZcAddId(dev, desc, rg)) < 0) {
+      Dma_ZcFree(dev, rg);
+      return -1;
+   }
+
+   // The descriptor must hold every open destination, checked with the mask locked
+   spin_lock_irqsave(&dev->maskLock, iflags);
+
+   if ((!bitmap_subset(dev->destBusy, desc->destMask, DMA_MAX_DEST)) || Dma_RxZcOther(dev, desc)) {
+      spin_unlock_irqrestore(&dev->maskLock, iflags);
+      dev_warn(dev->device, "Dma_RegRxRegion: destinations are open by other readers\n");
+
+      spin_lock_irqsave(&(dev->txLock), iflags);
+      desc->zcRegion[id] = NULL;
+      spin_unlock_irqrestore(&(dev->txLock), iflags);
+
+      Dma_ZcFree(dev, rg);
       return -1;
    }
 
+   // Slots are taken as receive buffers are posted
+   spin_lock(&(dev->zcRxLock));
+   list_add_tail(&(rg->link), &(dev->zcRxList));
+   spin_unlock(&(dev->zcRxLock));
+
+   spin_unlock_irqrestore(&dev->maskLock, iflags);
+
+   if (dmaDebug(dev))
+      dev_info(dev->device, "Dma_RegRxRegion: Region %i, Size=%lli, Slots=%i.\n", id, reg.size, rg->slotCount);
+
+   return id;
+}
+
+/**
+ * Dma_UnregRxRegion - Release a zero-copy receive region
+ * @dev: pointer to the DMA device structure
+ * @desc: pointer to the DMA descriptor
+ * @id: region id returned by Dma_RegRxRegion
+ *
+ * Indexes already read from the region stay valid until returned, the
+ * memory is unpinned once the hardware has given back all of its slots.
+ *
+ * Return: 0 on success, -1 on invalid id.
+ */
+int32_t Dma_UnregRxRegion(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t id) {
+   struct DmaZcRegion *rg;
+   unsigned long iflags;
+
+   if (id >= DMA_MAX_ZC_REGION) return -1;
+
+   spin_lock_irqsave(&(dev->txLock), iflags);
+   if (((rg = desc->zcRegion[id]) != NULL) && (rg->dir == DMA_FROM_DEVICE))
+      desc->zcRegion[id] = NULL;
+   else
+      rg = NULL;
+   spin_unlock_irqrestore(&(dev->txLock), iflags);
+
+   if (rg == NULL) return -1;
+
+   Dma_RxZcClose(dev, rg);
+   Dma_RxZcReap(dev);
    return 0;
 }
+
+/**
+ * Dma_RxZcClose - Stop handing out the slots of a receive region
+ * @dev: pointer to the DMA device structure
+ * @rg: region to close
+ *
+ * Slots still attached to receive buffers are detached when the buffers
+ * are next posted to the hardware.
+ */
+void Dma_RxZcClose(struct DmaDevice *dev, struct DmaZcRegion *rg) {
+   unsigned long iflags;
+
+   spin_lock_irqsave(&(dev->zcRxLock), iflags);
+   rg->closing = 1;
+   spin_unlock_irqrestore(&(dev->zcRxLock), iflags);
+}
+
+/**
+ * Dma_RxZcOther - Check for receive regions of other descriptors
+ * @dev: pointer to the DMA device structure
+ * @desc: descriptor whose own regions are ignored, NULL to check all regions
+ *
+ * A region stays on the list until the hardware has given back all of its
+ * slots, so closed regions whose slots may still be posted are included.
+ * A region whose owner was closed belongs to no descriptor.
+ * Called with the device maskLock held.
+ *
+ * Return: 1 if such a region exists, 0 otherwise.
+ */
+uint32_t Dma_RxZcOther(struct DmaDevice *dev, struct DmaDesc *desc) {
+   struct DmaZcRegion *rg;
+   uint32_t ret;
+
+   ret = 0;
+   spin_lock(&(dev->zcRxLock));
+   list_for_each_entry(rg, &(dev->zcRxList), link) {
+      if ((desc == NULL) || (rg->owner != desc)) {
+         ret = 1;
+         break;
+      }
+   }
+   spin_unlock(&(dev->zcRxLock));
+   return ret;
+}
+
+/**
+ * Dma_RxZcReap - Free closed receive regions without attached slots
+ * @dev: pointer to the DMA device structure
+ */
+void Dma_RxZcReap(struct DmaDevice *dev) {
+   struct DmaZcRegion *rg;
+   struct DmaZcRegion *next;
+   unsigned long iflags;
+   LIST_HEAD(done);
+
+   spin_lock_irqsave(&(dev->zcRxLock), iflags);
+   list_for_each_entry_safe(rg, next, &(dev->zcRxList), link) {
+      if (rg->closing && (rg->attached == 0)) list_move_tail(&(rg->link), &done);
+   }
+   spin_unlock_irqrestore(&(dev->zcRxLock), iflags);
+
+   list_for_each_entry_safe(rg, next, &done, link) {
+      if (dmaDebug(dev))
+         dev_info(dev->device, "Dma_RxZcReap: Freeing receive region, Size=%lli.\n", rg->size);
+      Dma_ZcFree(dev, rg);
+   }
+}
+
+/**
+ * Dma_TxZcReap - Free released transmit regions without buffers in hardware
+ * @dev: pointer to the DMA device structure
+ */
+void Dma_TxZcReap(struct DmaDevice *dev) {
+   struct DmaZcRegion *rg;
+   struct DmaZcRegion *next;
+   unsigned long iflags;
+   LIST_HEAD(done);
+
+   spin_lock_irqsave(&(dev->txLock), iflags);
+   list_for_each_entry_safe(rg, next, &(dev->zcTxList), link) {
+      if (rg->inFlight == 0) list_move_tail(&(rg->link), &done);
+   }
+   spin_unlock_irqrestore(&(dev->txLock), iflags);
+
+   list_for_each_entry_safe(rg, next, &done, link) {
+      if (dmaDebug(dev))
+         dev_info(dev->device, "Dma_TxZcReap: Freeing transmit region, Size=%lli.\n", rg->size);
+      Dma_ZcFree(dev, rg);
+   }
+}
+
+/**
+ * Dma_ZcWork - Work item freeing released zero-copy regions
+ * @work: pointer to the zcWork member of the DMA device
+ *
+ * Scheduled from interrupt context when the last slot of a closed receive
+ * region or the last buffer of a released transmit region is returned by
+ * the hardware.
+ */
+void Dma_ZcWork(struct work_struct *work) {
+   struct DmaDevice *dev;
+
+   dev = container_of(work, struct DmaDevice, zcWork);
+   Dma_RxZcReap(dev);
+   Dma_TxZcReap(dev);
+}
+
+/**
+ * Dma_ZcCopyUser - Copy a buffer received into a user region
+ * @dev: pointer to the DMA device structure
+ * @buff: buffer carrying the slot
+ * @dp: user space destination
+ *
+ * Return: Number of bytes copied, or -1 on failure.
+ */
+ssize_t Dma_ZcCopyUser(struct DmaDevice *dev, struct DmaBuffer *buff, void *dp) {
+   struct DmaZcRegion *rg;
+   uint64_t pos;
+   uint32_t left;
+   uint32_t len;
+   void *src;
+   long ret;
+
+   rg = buff->zcRegion;
+
+   for (pos = (rg->addr & ~PAGE_MASK) + buff->zcTag, left = buff->size; left > 0; pos += len, left -= len, dp += len) {
+      len = min_t(uint64_t, left, PAGE_SIZE - (pos & ~PAGE_MASK));
+
+      src = kmap(rg->pages[pos >> PAGE_SHIFT]);
+      ret = copy_to_user(dp, src + (pos & ~PAGE_MASK), len);
+      kunmap(rg->pages[pos >> PAGE_SHIFT]);
+
+      if (ret) {
+         dev_warn(dev->device, "Read: failed to copy zero-copy data to user space ret=%li, user=%p size=%u.\n",
+                  ret, dp, len);
+         return -1;
+      }
+   }
+   return buff->size;
+}
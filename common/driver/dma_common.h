@@ -27,15 +27,233 @@
 #include <linux/types.h>
 #include <linux/fs.h>
 #include <linux/interrupt.h>
+#include <linux/hrtimer.h>
+#include <linux/mutex.h>
+#include <linux/version.h>
+#include <linux/jump_label.h>
+#include <linux/workqueue.h>
 #include <DmaDriver.h>
 #include <dma_buffer.h>
 
 // Maximum number of destination channels
 #define DMA_MAX_DEST (8*DMA_MASK_SIZE)
 
+// Maximum number of readers sharing a destination
+#define DMA_MAX_GROUP 32
+
+// Destinations per block of per CPU counters
+#define DMA_STATS_BLOCK 256
+
+// Refresh period of the statistics page in ms
+#define DMA_STATS_PERIOD 100
+
+// Register operations copied from user space per step of a batch
+#define DMA_REG_BATCH 256
+
+// Longest poll timeout in us which spins instead of sleeping between reads
+#define DMA_REG_SPIN 100
+
+// Bounce buffer size of register block transfers
+#define DMA_BLOCK_SIZE 4096
+
+// Debug output test, the static key is only enabled while a device has debug set
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 3, 0)
+DECLARE_STATIC_KEY_FALSE(gDmaDebugKey);
+#define dmaDebug(dev) (static_branch_unlikely(&gDmaDebugKey) && ((dev)->debug > 0))
+#else
+#define dmaDebug(dev) ((dev)->debug > 0)
+#endif
+
+#ifdef DMA_LIFECYCLE
+
+// Log2 latency bins, the last bin also holds all longer times
+#define DMA_LC_BINS 32
+
+// Receive buffer lifecycle stages, each named for the state the buffer leaves
+enum DmaLcStage {
+   DMA_LC_WORK,     // Interrupt to service work, per interrupt
+   DMA_LC_HW,       // Posted to the hardware to harvested
+   DMA_LC_DELIVER,  // Harvested to pushed on the receive queue
+   DMA_LC_QUEUE,    // Queued to taken by a reader
+   DMA_LC_USER,     // Taken by a reader to returned
+   DMA_LC_FREE,     // Returned by a reader to posted to the hardware
+   DMA_LC_COUNT
+};
+
+/**
+ * struct DmaLcHist - Latency histogram of one lifecycle stage.
+ * @count: Number of samples.
+ * @total: Sum of the samples in ns.
+ * @max: Largest sample in ns.
+ * @bin: Sample count per log2 of the time in ns.
+ *
+ * Updated without locks from all contexts that move a buffer.
+ */
+struct DmaLcHist {
+   atomic64_t count;
+   atomic64_t total;
+   atomic64_t max;
+   atomic64_t bin[DMA_LC_BINS];
+};
+
+#endif
+
 // Forward declarations
 struct hardware_functions;
 struct DmaDesc;
+struct AxiVersion;
+
+/**
+ * struct DmaGroup - Readers sharing a single destination.
+ * @member: Descriptors which have joined the group.
+ * @hold: Member receiving the remainder of a continued frame, or NULL.
+ * @count: Number of valid entries in @member.
+ * @next: Member which receives the next frame in round-robin order.
+ * @mode: Distribution mode, DMA_GROUP_RR or DMA_GROUP_LOAD.
+ * @drop: Set when @hold left the group, the rest of its frame is dropped.
+ *
+ * Protected by the device maskLock. Buffers handed to a member are owned
+ * by that member's descriptor exactly as for an exclusive destination.
+ */
+struct DmaGroup {
+   struct DmaDesc * member[DMA_MAX_GROUP];
+   struct DmaDesc * hold;
+   uint32_t count;
+   uint32_t next;
+   uint32_t mode;
+   uint32_t drop;
+};
+
+/**
+ * struct DmaZcRegion - Pinned user memory for zero-copy transmit or receive.
+ * @addr: User address of the region.
+ * @size: Size of the region in bytes.
+ * @dir: DMA_TO_DEVICE for a transmit region, DMA_FROM_DEVICE for a receive region.
+ * @pageCount: Number of pinned pages.
+ * @mapCount: Number of pages mapped for DMA.
+ * @inFlight: Transmit buffers sending from the region, protected by dev->txLock.
+ * @pages: Pinned pages of the region.
+ * @handle: DMA address of each page.
+ * @owner: Descriptor which registered the region, only compared, never dereferenced.
+ * @slot: Offsets of the DMA contiguous receive slots, each one buffer in size.
+ * @slotCount: Number of entries in @slot.
+ * @slotNext: Next slot not yet attached to a receive buffer.
+ * @attached: Receive buffers carrying a slot of the region.
+ * @closing: Set once the region is released, its slots are detached as they return.
+ * @link: Link in the device list of receive regions, or of released transmit regions.
+ *
+ * The receive fields are protected by dev->zcRxLock.
+ */
+struct DmaZcRegion {
+   uint64_t addr;
+   uint64_t size;
+   enum dma_data_direction dir;
+   uint32_t pageCount;
+   uint32_t mapCount;
+   uint32_t inFlight;
+   struct page ** pages;
+   dma_addr_t   * handle;
+
+   // Receive slots
+   struct DmaDesc * owner;
+   uint64_t * slot;
+   uint32_t   slotCount;
+   uint32_t   slotNext;
+   uint32_t   attached;
+   uint8_t    closing;
+   struct list_head link;
+};
+
+/**
+ * DMA_PACK_STAGE - Largest staging buffer of a packed read.
+ */
+#define DMA_PACK_STAGE 65536
+
+/**
+ * struct DmaPackState - State of a packed read.
+ * @dev: Device being read.
+ * @data: User buffer receiving the records.
+ * @done: Bytes written to @data.
+ * @stage: Staging buffer.
+ * @stageSize: Size of @stage.
+ * @fill: Bytes collected in @stage.
+ */
+struct DmaPackState {
+   struct DmaDevice * dev;
+   uint64_t  data;
+   uint32_t  done;
+   uint8_t * stage;
+   uint32_t  stageSize;
+   uint32_t  fill;
+};
+
+/**
+ * DMA_TX_BATCH - Frames released to hardware per transmit timer call.
+ */
+#define DMA_TX_BATCH 32
+
+/**
+ * DMA_TX_GRANT_MS - Time in ms a writer may hold granted transmit buffers
+ * without taking one before the grant returns to the shared pool.
+ */
+#define DMA_TX_GRANT_MS 100
+
+/**
+ * struct DmaPacer - Token bucket transmit pacing for one destination.
+ * @dev: Back-pointer to the owning DmaDevice.
+ * @lock: Protects the pacer state.
+ * @timer: Releases held frames as tokens become available.
+ * @queue: Frames waiting for tokens, linked through DmaBuffer destLink.
+ * @armed: Non-zero while @timer is scheduled.
+ * @queued: Number of frames in @queue.
+ * @cont: Non-zero while the last released buffer had the continue bit set.
+ * @frameRate: Frames per second, 0 for no frame limit.
+ * @byteRate: Bytes per second, 0 for no byte limit.
+ * @frameMax: Frame bucket depth, in frames scaled by NSEC_PER_SEC.
+ * @byteMax: Byte bucket depth, in bytes scaled by NSEC_PER_SEC.
+ * @frameFill: Time in ns to fill the empty frame bucket.
+ * @byteFill: Time in ns to fill the empty byte bucket.
+ * @frameTok: Frame tokens, scaled by NSEC_PER_SEC.
+ * @byteTok: Byte tokens, scaled by NSEC_PER_SEC.
+ * @last: Time in ns of the last token refill.
+ * @start: Time in ns the rates were set, used for the achieved rates.
+ * @frames: Frames released since @start.
+ * @bytes: Bytes released since @start.
+ * @waitTot: Total time in ns frames waited for tokens.
+ * @waitMax: Longest time in ns a frame waited for tokens.
+ *
+ * Scaling the tokens by NSEC_PER_SEC lets a refill of elapsed * rate be
+ * computed without division in the transmit path.
+ */
+struct DmaPacer {
+   struct DmaDevice * dev;
+   spinlock_t         lock;
+   struct hrtimer     timer;
+   struct list_head   queue;
+   uint32_t           armed;
+   uint32_t           queued;
+   uint32_t           cont;
+
+   // Configuration
+   uint64_t frameRate;
+   uint64_t byteRate;
+   uint64_t frameMax;
+   uint64_t byteMax;
+   uint64_t frameFill;
+   uint64_t byteFill;
+
+   // Buckets
+   uint64_t frameTok;
+   uint64_t byteTok;
+   uint64_t last;
+
+   // Statistics
+   uint64_t start;
+   uint64_t frames;
+   uint64_t bytes;
+   uint64_t waitTot;
+   uint64_t waitMax;
+};
 
 /**
  * struct DmaDevice - Represents a DMA-capable device.
@@ -70,6 +288,8 @@ struct DmaDesc;
  * @commandLock: Spinlock for command operations.
  * @maskLock: Spinlock for destination mask operations.
  * @desc: Array of pointers to descriptor structures for DMA channels.
+ * @group: Array of pointers to shared reader groups for DMA channels.
+ * @destBusy: Destinations held by a descriptor or a shared group.
  * @txBuffers: List of transmit buffers.
  * @rxBuffers: List of receive buffers.
  * @tq: Transmit queue structure.
@@ -121,6 +341,53 @@ struct DmaDevice {
    // Debug flag
    uint8_t debug;
 
+   // Hardware returns buffers by index, allowing zero-copy, set by the card init
+   uint8_t zeroCopy;
+
+   // Zero-copy receive regions of all descriptors, protected by zcRxLock
+   spinlock_t         zcRxLock;
+   struct list_head   zcRxList;
+
+   // Released transmit regions with buffers still in hardware, protected by txLock
+   struct list_head   zcTxList;
+
+   // Frees released regions once the hardware is done with them
+   struct work_struct zcWork;
+
+   // Receive sequence numbers per destination and count of descriptors
+   // using extended read records, protected by maskLock
+   uint32_t rxSeq[DMA_MAX_DEST];
+   uint32_t rxStamp;
+
+   // Per destination counters, per CPU blocks allocated when a destination
+   // in the block is first claimed, block 0 at init
+   struct DmaDestStats __percpu * destStats[DMA_MAX_DEST / DMA_STATS_BLOCK];
+
+   // debugfs directory of the device
+   struct dentry * debugDir;
+
+   // Shared statistics page, refreshed by statsWork while user space has it mapped,
+   // statsLock orders new mappings against the removal of the page
+   struct DmaStatsPage * statsPage;
+   struct delayed_work   statsWork;
+   atomic_t              statsMaps;
+   spinlock_t            statsLock;
+
+   // Service pass statistics, updated by the card service routine
+   uint64_t svcPass;
+   uint64_t svcHandled;
+   uint64_t svcEmpty;
+   uint32_t svcMax;
+
+   // Static firmware identity of cards with an AxiVersion block, protected by commandLock
+   struct AxiVersion * aVer;
+
+#ifdef DMA_LIFECYCLE
+   // Buffer lifecycle histograms, shown and reset through debugfs
+   struct DmaLcHist lc[DMA_LC_COUNT];
+   uint64_t         lcIrq;
+#endif
+
    // IRQ
    uint32_t irq;
 
@@ -128,22 +395,87 @@ struct DmaDevice {
    spinlock_t writeHwLock;
    spinlock_t commandLock;
    spinlock_t maskLock;
+   spinlock_t txLock;
 
    // Owners
    struct DmaDesc * desc[DMA_MAX_DEST];
 
+   // Shared owners
+   struct DmaGroup * group[DMA_MAX_DEST];
+
+   // Destinations in use, exclusive or shared
+   DECLARE_BITMAP(destBusy, DMA_MAX_DEST);
+
+   // Transmit pacing, allocated on first use and kept until cleanup
+   struct DmaPacer * pacer[DMA_MAX_DEST];
+
+   // Scheduled transmit queue ordered by launch time, protected by launchLock
+   spinlock_t     launchLock;
+   struct rb_root launchQ;
+   struct hrtimer launchTimer;
+   uint32_t       launchCount;
+
+   // Scheduled transmit statistics, error is actual minus requested launch time
+   uint64_t launchFrames;
+   uint64_t launchLate;
+   uint64_t launchErrTot;
+   uint64_t launchErrMax;
+
    // Transmit/receive buffer list
    struct DmaBufferList txBuffers;
    struct DmaBufferList rxBuffers;
 
    // Transmit queue
    struct DmaQueue tq;
+
+   // Transmit buffer sharing, protected by txLock
+   struct list_head txWaiters;
+   struct list_head txGranted;
+   struct list_head txEvents;
+   uint32_t txHeld;
+   uint32_t txReserved;
 };
 
 /**
  * struct DmaDesc - DMA descriptor for a device.
  * @destMask: Destination mask for DMA transfers.
+ * @groupMask: Mask of shared destinations this descriptor has joined.
  * @q: Receive queue for the descriptor.
+ * @destQ: Optional per-destination receive queues, NULL when disabled.
+ * @destReady: Destinations with a non-empty queue in @destQ.
+ * @destCount: Total number of buffers in @destQ.
+ * @destNext: Next destination in the read rotation.
+ * @txReserve: Transmit buffers reserved for this descriptor.
+ * @txLimit: Maximum transmit buffers in use, 0 for no limit.
+ * @txQuantum: Buffers granted per round while waiting.
+ * @txInUse: Transmit buffers currently charged to this descriptor.
+ * @txGrant: Free transmit buffers granted but not yet taken.
+ * @txDeficit: Grants remaining in the current round.
+ * @txLowat: Transmit buffers required before reporting POLLOUT.
+ * @txWaitLink: Link in the device list of waiting writers.
+ * @txGrantLink: Link in the device list of writers holding grants.
+ * @txGrantTime: Time in jiffies of the last grant given or taken.
+ * @txWait: Wait queue for transmit buffer availability.
+ * @rxChain: Open reassembly chain per destination, NULL when reassembly is disabled.
+ * @rxChainMax: Maximum buffers reassembled into one frame.
+ * @rxSmall: Ring of packed small frames, NULL when small frame copy-out is off.
+ * @rxSmallMax: Largest frame copied into @rxSmall.
+ * @rxSmallSize: Size of @rxSmall in bytes, a power of two.
+ * @rxSmallHead: Free running write position in @rxSmall.
+ * @rxSmallTail: Free running read position in @rxSmall.
+ * @rxSmallLock: Serializes readers and reconfiguration of @rxSmall.
+ * @readExt: Set when read returns DmaReadDataExt records.
+ * @rxEvent: Optional eventfd signalled on receive, protected by dev->maskLock.
+ * @rxCoalesce: Frames per receive signal while the queue is not empty.
+ * @rxEventPend: Frames received since the last receive signal.
+ * @txEvent: Optional eventfd signalled on transmit buffers, protected by dev->txLock.
+ * @txEventLink: Link in the device list of bound transmit eventfds.
+ * @txEventReady: Set while transmit buffers were signalled available to @txEvent.
+ * @zcRegion: Registered zero-copy transmit regions, protected by dev->txLock.
+ * @zcInFlight: Zero-copy transmit buffers not yet returned by the hardware.
+ * @zcDone: Ring of completed zero-copy frame tags, cfgTxCount entries.
+ * @zcDoneRead: Next entry to read in @zcDone.
+ * @zcDoneCount: Number of entries in @zcDone.
  * @async_queue: Asynchronous notification queue.
  * @dev: Back-pointer to the associated DmaDevice.
  *
@@ -152,11 +484,63 @@ struct DmaDevice {
  */
 struct DmaDesc {
    // Mask of destinations
-   uint8_t destMask[DMA_MASK_SIZE];
+   DECLARE_BITMAP(destMask, DMA_MAX_DEST);
+
+   // Mask of shared destinations
+   DECLARE_BITMAP(groupMask, DMA_MAX_DEST);
 
    // Receive queue
    struct DmaQueue q;
 
+   // Per destination receive queues, protected by q.lock
+   struct list_head * destQ;
+   DECLARE_BITMAP(destReady, DMA_MAX_DEST);
+   uint32_t destCount;
+   uint32_t destNext;
+
+   // Transmit buffer share, protected by dev->txLock
+   uint32_t txReserve;
+   uint32_t txLimit;
+   uint32_t txQuantum;
+   uint32_t txInUse;
+   uint32_t txGrant;
+   uint32_t txDeficit;
+   uint32_t txLowat;
+   struct list_head txWaitLink;
+   struct list_head txGrantLink;
+   unsigned long txGrantTime;
+   wait_queue_head_t txWait;
+
+   // Receive frame reassembly, protected by dev->maskLock
+   struct DmaBuffer ** rxChain;
+   uint32_t rxChainMax;
+
+   // Small frame copy-out ring, written under dev->maskLock, read under rxSmallLock
+   uint8_t * rxSmall;
+   uint32_t  rxSmallMax;
+   uint32_t  rxSmallSize;
+   uint32_t  rxSmallHead;
+   uint32_t  rxSmallTail;
+   struct mutex rxSmallLock;
+
+   // Read returns extended records, counted in dev->rxStamp
+   uint8_t readExt;
+
+   // Event notification
+   struct eventfd_ctx * rxEvent;
+   uint32_t rxCoalesce;
+   uint32_t rxEventPend;
+   struct eventfd_ctx * txEvent;
+   struct list_head txEventLink;
+   uint32_t txEventReady;
+
+   // Zero-copy transmit, protected by dev->txLock
+   struct DmaZcRegion * zcRegion[DMA_MAX_ZC_REGION];
+   uint32_t zcInFlight;
+   uint64_t * zcDone;
+   uint32_t zcDoneRead;
+   uint32_t zcDoneCount;
+
    // Async queue
    struct fasync_struct *async_queue;
 
@@ -174,6 +558,8 @@ struct DmaDesc {
  * @sendBuffer: Send buffer function.
  * @command: Command execution function.
  * @seqShow: Function to display device information in a sequential file.
+ * @statsRegs: Optional function filling the firmware register snapshot of the
+ *             statistics page, returns the number of registers read.
  *
  * This structure defines a set of hardware-specific operations that are
  * required to manage a DMA device. It includes functions for initialization,
@@ -188,6 +574,7 @@ struct hardware_functions {
    int32_t     (*sendBuffer)(struct DmaDevice *dev, struct DmaBuffer **buff, uint32_t count);
    int32_t     (*command)(struct DmaDevice *dev, uint32_t cmd, uint64_t arg);
    void        (*seqShow)(struct seq_file *s, struct DmaDevice *dev);
+   uint32_t    (*statsRegs)(struct DmaDevice *dev, uint32_t *regs, uint32_t count);
 };
 
 // Global array of devices
@@ -220,9 +607,88 @@ void * Dma_SeqStart(struct seq_file *s, loff_t *pos);
 void * Dma_SeqNext(struct seq_file *s, void *v, loff_t *pos);
 void Dma_SeqStop(struct seq_file *s, void *v);
 int Dma_SeqShow(struct seq_file *s, void *v);
+int Dma_StatsAlloc(struct DmaDevice *dev, uint32_t dest);
+void Dma_StatsFree(struct DmaDevice *dev);
+int Dma_StatsSum(struct DmaDevice *dev, uint32_t dest, struct DmaDestStats *sum);
+int Dma_StatsPageInit(struct DmaDevice *dev);
+void Dma_StatsPageWork(struct work_struct *work);
+void Dma_StatsVmOpen(struct vm_area_struct *vma);
+void Dma_StatsVmClose(struct vm_area_struct *vma);
+int Dma_StatsMmap(struct DmaDevice *dev, struct vm_area_struct *vma);
+void Dma_ServiceStats(struct DmaDevice *dev, uint32_t handleCount);
+int32_t Dma_GetDestStats(struct DmaDevice *dev, uint64_t arg);
+int Dma_StatsOpen(struct inode *inode, struct file *file);
+int Dma_StatsShow(struct seq_file *s, void *v);
+#ifdef DMA_LIFECYCLE
+int Dma_LcOpen(struct inode *inode, struct file *file);
+int Dma_LcShow(struct seq_file *s, void *v);
+ssize_t Dma_LcWrite(struct file *file, const char __user *buffer, size_t count, loff_t *pos);
+#endif
+void Dma_SetDebug(struct DmaDevice *dev, uint32_t level);
+void Dma_MaskToBitmap(const uint8_t *mask, unsigned long *bits);
 int Dma_SetMaskBytes(struct DmaDevice *dev, struct DmaDesc *desc, uint8_t * mask);
+int Dma_AddMaskBytes(struct DmaDevice *dev, struct DmaDesc *desc, uint8_t * mask);
+int Dma_DelMaskBytes(struct DmaDevice *dev, struct DmaDesc *desc, uint8_t * mask);
+int Dma_ClaimMaskBytes(struct DmaDevice *dev, struct DmaDesc *desc, uint8_t * mask, uint32_t first, const char *name);
+void Dma_BitmapToMask(const unsigned long *bits, uint8_t *mask);
+int32_t Dma_SetDestQueue(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t enable);
+int32_t Dma_GetDestReady(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg);
+int32_t Dma_ReadSelect(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg);
+void Dma_ReadBuffers(struct DmaDesc *desc, struct DmaReadData *rd, struct DmaBuffer **buff, ssize_t bCnt);
+int32_t Dma_SetTxQuota(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg);
+void Dma_PacerRefill(struct DmaPacer *pacer, uint64_t now);
+uint64_t Dma_PacerWait(struct DmaPacer *pacer, uint32_t frames, uint64_t bytes);
+void Dma_PacerTake(struct DmaPacer *pacer, struct DmaBuffer *buff, uint64_t now);
+uint64_t Dma_PacerRate(uint64_t count, uint64_t elapsed);
+int32_t Dma_PacerSend(struct DmaDevice *dev, struct DmaPacer *pacer, struct DmaBuffer **buff, uint32_t cnt);
+enum hrtimer_restart Dma_PacerTimer(struct hrtimer *timer);
+int32_t Dma_SetTxPace(struct DmaDevice *dev, uint64_t arg);
+int32_t Dma_TxDestValid(struct DmaDevice *dev, uint32_t dest);
+ssize_t Dma_WriteChain(struct DmaDevice *dev, struct DmaDesc *desc, struct DmaWriteSeg *seg, uint32_t segCnt, struct DmaWriteData *wr);
+ssize_t Dma_WriteGather(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg);
+uint32_t Dma_FrameInfo(struct DmaBuffer *buff, uint32_t *flags, uint32_t *error);
+ssize_t Dma_CopyChain(struct DmaDevice *dev, struct DmaBuffer *buff, void *dp);
+uint32_t Dma_RetChain(struct DmaDevice *dev, struct DmaBuffer *buff);
+int32_t Dma_SetRxChain(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t max);
+int32_t Dma_ReadFrame(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg);
+int32_t Dma_SendChain(struct DmaDevice *dev, struct DmaBuffer **buff, uint32_t cnt, uint32_t dest);
+void Dma_ZcFree(struct DmaDevice *dev, struct DmaZcRegion *rg);
+int32_t Dma_ZcAlloc(struct DmaDevice *dev, uint64_t addr, uint64_t size, enum dma_data_direction dir, struct DmaZcRegion **rg);
+int32_t Dma_ZcAddId(struct DmaDevice *dev, struct DmaDesc *desc, struct DmaZcRegion *rg);
+int32_t Dma_RegTxRegion(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg);
+int32_t Dma_UnregTxRegion(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t id);
+uint32_t Dma_ZcSegment(struct DmaDevice *dev, struct DmaZcRegion *rg, uint64_t off, uint64_t len, dma_addr_t *addr);
+ssize_t Dma_WriteZc(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg);
+int32_t Dma_GetTxDone(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg);
+int32_t Dma_SetRxSmall(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg);
+int32_t Dma_SmallCopy(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t data, uint32_t size, uint32_t count, uint32_t *used);
+int32_t Dma_ReadSmall(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg);
+int32_t Dma_PackPut(struct DmaPackState *pk, void *src, struct DmaBuffer *buff, uint32_t size);
+int32_t Dma_PackFlush(struct DmaPackState *pk);
+int32_t Dma_ReadPacked(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg);
+int32_t Dma_SetReadExt(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t enable);
+int32_t Dma_RegRxRegion(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg);
+int32_t Dma_UnregRxRegion(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t id);
+void Dma_RxZcClose(struct DmaDevice *dev, struct DmaZcRegion *rg);
+uint32_t Dma_RxZcOther(struct DmaDevice *dev, struct DmaDesc *desc);
+void Dma_RxZcReap(struct DmaDevice *dev);
+void Dma_TxZcReap(struct DmaDevice *dev);
+void Dma_ZcWork(struct work_struct *work);
+ssize_t Dma_ZcCopyUser(struct DmaDevice *dev, struct DmaBuffer *buff, void *dp);
+void Dma_LaunchStats(struct DmaDevice *dev, struct DmaBuffer *buff, uint64_t now);
+int32_t Dma_LaunchSend(struct DmaDevice *dev, struct DmaBuffer *buff, uint64_t launch);
+uint32_t Dma_LaunchCancel(struct DmaDevice *dev, struct DmaDesc *desc);
+enum hrtimer_restart Dma_LaunchTimer(struct hrtimer *timer);
+int32_t Dma_SetEventFd(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg);
+int32_t Dma_SetTxLowat(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t lowat);
+int32_t Dma_JoinGroup(struct DmaDevice *dev, struct DmaDesc *desc, uint64_t arg);
+int32_t Dma_LeaveGroup(struct DmaDevice *dev, struct DmaDesc *desc, uint32_t dest);
+struct DmaDesc * Dma_DestOwner(struct DmaDevice *dev, uint32_t dest, uint32_t cont);
 int32_t Dma_WriteRegister(struct DmaDevice *dev, uint64_t arg);
 int32_t Dma_ReadRegister(struct DmaDevice *dev, uint64_t arg);
+int32_t Dma_RegOp(struct DmaDevice *dev, struct DmaRegOp *op);
+int32_t Dma_RegBatch(struct DmaDevice *dev, uint64_t arg);
+int32_t Dma_RegBlock(struct DmaDevice *dev, uint64_t arg, uint8_t write);
 void Dma_UnmapReg(struct DmaDevice *dev);
 
 #endif  // __DMA_COMMON_H__
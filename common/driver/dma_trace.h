@@ -0,0 +1,157 @@
+/**
+ * ----------------------------------------------------------------------------
+ * Company    : SLAC National Accelerator Laboratory
+ * ----------------------------------------------------------------------------
+ * Description:
+ *    Tracepoints of the DMA receive and transmit paths. The events are
+ *    created in dma_common.c and are visible to perf, trace-cmd and bpftrace
+ *    under the aes_dma system. A disabled tracepoint costs a patched branch.
+ * ----------------------------------------------------------------------------
+ * This file is part of the aes_stream_drivers package. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the aes_stream_drivers package, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM aes_dma
+
+#if !defined(__DMA_TRACE_H__) || defined(TRACE_HEADER_MULTI_READ)
+#define __DMA_TRACE_H__
+
+#include <linux/tracepoint.h>
+#include <linux/kdev_t.h>
+#include <dma_common.h>
+#include <dma_buffer.h>
+
+// Device events: interrupt entry and start of a service pass
+DECLARE_EVENT_CLASS(dma_dev,
+   TP_PROTO(struct DmaDevice *dev),
+   TP_ARGS(dev),
+   TP_STRUCT__entry(
+      __field(dev_t, devNum)
+   ),
+   TP_fast_assign(
+      __entry->devNum = dev->devNum;
+   ),
+   TP_printk("dev=%d:%d", MAJOR(__entry->devNum), MINOR(__entry->devNum))
+);
+
+DEFINE_EVENT(dma_dev, dma_irq,
+   TP_PROTO(struct DmaDevice *dev),
+   TP_ARGS(dev)
+);
+
+DEFINE_EVENT(dma_dev, dma_service_start,
+   TP_PROTO(struct DmaDevice *dev),
+   TP_ARGS(dev)
+);
+
+// End of a service pass with the number of descriptors handled
+TRACE_EVENT(dma_service_end,
+   TP_PROTO(struct DmaDevice *dev, uint32_t handleCount),
+   TP_ARGS(dev, handleCount),
+   TP_STRUCT__entry(
+      __field(dev_t, devNum)
+      __field(uint32_t, handleCount)
+   ),
+   TP_fast_assign(
+      __entry->devNum = dev->devNum;
+      __entry->handleCount = handleCount;
+   ),
+   TP_printk("dev=%d:%d handled=%u", MAJOR(__entry->devNum), MINOR(__entry->devNum),
+             __entry->handleCount)
+);
+
+// Buffer events: receive completion, drop, return and transmit
+DECLARE_EVENT_CLASS(dma_buffer,
+   TP_PROTO(struct DmaDevice *dev, struct DmaBuffer *buff),
+   TP_ARGS(dev, buff),
+   TP_STRUCT__entry(
+      __field(dev_t, devNum)
+      __field(uint32_t, index)
+      __field(uint32_t, dest)
+      __field(uint32_t, size)
+      __field(uint32_t, flags)
+      __field(uint32_t, error)
+   ),
+   TP_fast_assign(
+      __entry->devNum = dev->devNum;
+      __entry->index = buff->index;
+      __entry->dest = buff->dest;
+      __entry->size = buff->size;
+      __entry->flags = buff->flags;
+      __entry->error = buff->error;
+   ),
+   TP_printk("dev=%d:%d index=%u dest=%u size=%u flags=0x%x error=0x%x",
+             MAJOR(__entry->devNum), MINOR(__entry->devNum), __entry->index,
+             __entry->dest, __entry->size, __entry->flags, __entry->error)
+);
+
+DEFINE_EVENT(dma_buffer, dma_rx,
+   TP_PROTO(struct DmaDevice *dev, struct DmaBuffer *buff),
+   TP_ARGS(dev, buff)
+);
+
+DEFINE_EVENT(dma_buffer, dma_rx_drop,
+   TP_PROTO(struct DmaDevice *dev, struct DmaBuffer *buff),
+   TP_ARGS(dev, buff)
+);
+
+DEFINE_EVENT(dma_buffer, dma_rx_ret,
+   TP_PROTO(struct DmaDevice *dev, struct DmaBuffer *buff),
+   TP_ARGS(dev, buff)
+);
+
+DEFINE_EVENT(dma_buffer, dma_tx_submit,
+   TP_PROTO(struct DmaDevice *dev, struct DmaBuffer *buff),
+   TP_ARGS(dev, buff)
+);
+
+DEFINE_EVENT(dma_buffer, dma_tx_done,
+   TP_PROTO(struct DmaDevice *dev, struct DmaBuffer *buff),
+   TP_ARGS(dev, buff)
+);
+
+// Receive queue events with the depth of the queue after the operation
+DECLARE_EVENT_CLASS(dma_queue,
+   TP_PROTO(struct DmaDesc *desc, struct DmaBuffer *buff),
+   TP_ARGS(desc, buff),
+   TP_STRUCT__entry(
+      __field(dev_t, devNum)
+      __field(uint32_t, index)
+      __field(uint32_t, dest)
+      __field(uint32_t, depth)
+   ),
+   TP_fast_assign(
+      __entry->devNum = desc->dev->devNum;
+      __entry->index = buff->index;
+      __entry->dest = buff->dest;
+      __entry->depth = (desc->destQ != NULL) ? desc->destCount : dmaQueueCount(&(desc->q));
+   ),
+   TP_printk("dev=%d:%d index=%u dest=%u depth=%u", MAJOR(__entry->devNum),
+             MINOR(__entry->devNum), __entry->index, __entry->dest, __entry->depth)
+);
+
+DEFINE_EVENT(dma_queue, dma_queue_push,
+   TP_PROTO(struct DmaDesc *desc, struct DmaBuffer *buff),
+   TP_ARGS(desc, buff)
+);
+
+DEFINE_EVENT(dma_queue, dma_queue_pop,
+   TP_PROTO(struct DmaDesc *desc, struct DmaBuffer *buff),
+   TP_ARGS(desc, buff)
+);
+
+#endif  // __DMA_TRACE_H__
+
+// Found through the driver source directory in the include path
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE dma_trace
+#include <trace/define_trace.h>
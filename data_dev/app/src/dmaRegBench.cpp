@@ -0,0 +1,164 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Company    : SLAC National Accelerator Laboratory
+ *-----------------------------------------------------------------------------
+ * Description:
+ *    Measures the register access rate of single register ioctls against
+ *    batched register operations. The default register is the AxiVersion
+ *    scratch pad, which is safe to read and write.
+ * ----------------------------------------------------------------------------
+ * This file is part of the aes_stream_drivers package. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the aes_stream_drivers package, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+
+#include <sys/types.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <argp.h>
+#include <iostream>
+#include <cstdio>
+
+#include <DmaDriver.h>
+
+using std::cout;
+using std::endl;
+
+const char *argp_program_version = "dmaRegBench 1.0";
+const char *argp_program_bug_address = "rherbst@slac.stanford.edu";
+
+struct PrgArgs {
+   const char * path;
+   uint64_t     address;
+   uint32_t     count;
+   uint32_t     batch;
+   uint32_t     write;
+};
+
+static struct PrgArgs DefArgs = { "/dev/datadev_0", 0x20004, 100000, 1024, 0 };
+
+static char args_doc[] = "";
+static char doc[]      = "   Compares single register ioctls with batched register operations.";
+
+static struct argp_option options[] = {
+   { "path",    'p', "PATH",    OPTION_ARG_OPTIONAL, "Path of datadev device to use. Default=/dev/datadev_0.", 0},
+   { "address", 'a', "ADDRESS", OPTION_ARG_OPTIONAL, "Register address. Default=0x20004 (AxiVersion scratch pad).", 0},
+   { "count",   'c', "COUNT",   OPTION_ARG_OPTIONAL, "Register accesses per test. Default=100000.", 0},
+   { "batch",   'b', "SIZE",    OPTION_ARG_OPTIONAL, "Operations per batch. Default=1024.", 0},
+   { "write",   'w', 0,         0,                   "Alternate writes and reads of the register.", 0},
+   {0}
+};
+
+error_t parseArgs(int key, char *arg, struct argp_state *state) {
+   struct PrgArgs *args = (struct PrgArgs *)state->input;
+
+   switch (key) {
+      case 'p': args->path = arg; break;
+      case 'a': args->address = strtoull(arg, NULL, 0); break;
+      case 'c': args->count = strtol(arg, NULL, 10); break;
+      case 'b': args->batch = strtol(arg, NULL, 10); break;
+      case 'w': args->write = 1; break;
+      default: return ARGP_ERR_UNKNOWN; break;
+   }
+   return(0);
+}
+
+static struct argp argp = {options, parseArgs, args_doc, doc};
+
+// Print the rate of a test
+void showRate(const char *name, uint32_t count, struct timeval *sTime, struct timeval *eTime) {
+   struct timeval dTime;
+   double duration;
+
+   timersub(eTime, sTime, &dTime);
+   duration = dTime.tv_sec + (double)dTime.tv_usec / 1000000.0;
+
+   printf("%8s   %9u   %8.3f   %12.0f   %8.3f\n", name, count, duration,
+          count / duration, (duration * 1e6) / count);
+}
+
+int main(int argc, char **argv) {
+   struct DmaRegOp * ops;
+   struct PrgArgs    args;
+   struct timeval    sTime;
+   struct timeval    eTime;
+   int32_t  s;
+   int32_t  ret;
+   uint32_t data;
+   uint32_t errCount;
+   uint32_t done;
+   uint32_t cnt;
+   uint32_t x;
+
+   memcpy(&args, &DefArgs, sizeof(struct PrgArgs));
+   argp_parse(&argp, argc, argv, 0, 0, &args);
+
+   if ( args.batch == 0 ) args.batch = 1;
+   if ( args.count == 0 ) args.count = 1;
+
+   if ( (s = open(args.path, O_RDWR)) <= 0 ) {
+      printf("Error opening %s\n", args.path);
+      return(1);
+   }
+
+   if ( (ops = (struct DmaRegOp *)malloc(args.batch * sizeof(struct DmaRegOp))) == NULL ) {
+      printf("Failed to allocate operations!\n");
+      return(1);
+   }
+
+   printf("    test    accesses   duration     accesses/s    us/each\n");
+
+   // Single register ioctls
+   errCount = 0;
+   gettimeofday(&sTime, NULL);
+
+   for (x = 0; x < args.count; x++) {
+      if ( args.write && ((x & 1) == 0) ) ret = dmaWriteRegister(s, args.address, x);
+      else ret = dmaReadRegister(s, args.address, &data);
+      if ( ret < 0 ) errCount++;
+   }
+
+   gettimeofday(&eTime, NULL);
+   showRate("single", args.count, &sTime, &eTime);
+
+   // Batched register operations
+   gettimeofday(&sTime, NULL);
+
+   for (done = 0; done < args.count; done += cnt) {
+      cnt = ((args.count - done) < args.batch) ? (args.count - done) : args.batch;
+
+      memset(ops, 0, cnt * sizeof(struct DmaRegOp));
+      for (x = 0; x < cnt; x++) {
+         ops[x].address = args.address;
+         ops[x].op      = (args.write && (((done + x) & 1) == 0)) ? DMA_REG_WRITE : DMA_REG_READ;
+         ops[x].data    = done + x;
+      }
+
+      if ( dmaRegBatch(s, cnt, ops) != (ssize_t)cnt ) errCount++;
+
+      // A read after a write of the scratch pad returns the value written
+      if ( args.write && (args.address == DefArgs.address) ) {
+         for (x = 1; x < cnt; x++) {
+            if ( (ops[x].op == DMA_REG_READ) && (ops[x-1].op == DMA_REG_WRITE) && (ops[x].data != ops[x-1].data) ) errCount++;
+         }
+      }
+   }
+
+   gettimeofday(&eTime, NULL);
+   showRate("batch", args.count, &sTime, &eTime);
+
+   if ( errCount > 0 ) printf("%u errors\n", errCount);
+
+   free(ops);
+   close(s);
+   return(0);
+}
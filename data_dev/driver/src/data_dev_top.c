@@ -296,6 +296,10 @@ int DataDev_Probe(struct pci_dev *pcidev, const struct pci_device_id *dev_id) {
    dev_info(dev->device, "Init: User space mapped to 0x%p with size 0x%x.\n", dev->rwBase, dev->rwSize);
    dev_info(dev->device, "Init: Top Register = 0x%x\n", readl(dev->reg));
 
+   // Cache the static firmware identity, read from the hardware if this fails
+   if (AxiVersion_Cache(dev, dev->base + AVER_OFF) < 0)
+      dev_warn(dev->device, "Init: Failed to cache AXI version.\n");
+
    // Finalize device probe successfully
    gDmaDevCount++;                   // Increment global device count
    probeReturn = 0;                  // Set successful return code
@@ -340,6 +344,9 @@ void DataDev_Remove(struct pci_dev *pcidev) {
    // Decrement count
    gDmaDevCount--;
 
+   // Free the cached firmware identity, Dma_Clean clears the device
+   AxiVersion_Free(dev);
+
    // Call common DMA clean function
    Dma_Clean(dev);
 
@@ -357,8 +364,8 @@ void DataDev_Remove(struct pci_dev *pcidev) {
  *
  * Executes a given command on the specified DMA device. The function
  * handles different commands, including reading the AXI version via
- * AVER_Get command and passing any other commands to the AxisG2_Command
- * function for further processing. The function returns the result of
+ * AVER_Get command, reloading its cached copy via AVER_Refresh, and passing
+ * any other commands to the AxisG2_Command function for further processing. The function returns the result of
  * the command execution, which could be a success indicator or an error code.
  *
  * Return: the result of the command execution. Returns -1 if the command
@@ -371,6 +378,11 @@ int32_t DataDev_Command(struct DmaDevice *dev, uint32_t cmd, uint64_t arg) {
          return AxiVersion_Get(dev, dev->base + AVER_OFF, arg);
          break;
 
+      case AVER_Refresh:
+         // Reload the cached AXI Version
+         return AxiVersion_Cache(dev, dev->base + AVER_OFF);
+         break;
+
       default:
          // Delegate command to AxisG2 handler
          return AxisG2_Command(dev, cmd, arg);
@@ -429,6 +441,7 @@ struct hardware_functions DataDev_functions = {
    .sendBuffer   = AxisG2_SendBuffer,
    .command      = DataDev_Command,
    .seqShow      = DataDev_SeqShow,
+   .statsRegs    = AxisG2_StatsRegs,
 };
 
 // Parameters
@@ -267,6 +267,10 @@ int DataGpu_Probe(struct pci_dev *pcidev, const struct pci_device_id *dev_id) {
    dev_info(dev->device, "Init: User space mapped to 0x%p with size 0x%x.\n", dev->rwBase, dev->rwSize);
    dev_info(dev->device, "Init: Top Register = 0x%x\n", readl(dev->reg));
 
+   // Cache the static firmware identity, read from the hardware if this fails
+   if (AxiVersion_Cache(dev, dev->base + AVER_OFF) < 0)
+      dev_warn(dev->device, "Init: Failed to cache AXI version.\n");
+
    // Finalize device probe successfully
    gDmaDevCount++;  // Increment global device count
    return 0;  // Success
@@ -311,6 +315,9 @@ void DataGpu_Remove(struct pci_dev *pcidev) {
    /* Decrement the global count of DMA devices. */
    gDmaDevCount--;
 
+   /* Free the cached firmware identity, Dma_Clean clears the device. */
+   AxiVersion_Free(dev);
+
    /* Clean up DMA resources specific to this device. */
    Dma_Clean(dev);
 
@@ -349,6 +356,11 @@ int32_t DataGpu_Command(struct DmaDevice *dev, uint32_t cmd, uint64_t arg) {
       case AVER_Get:
          return AxiVersion_Get(dev, dev->base + AVER_OFF, arg);
 
+      // AXI Version Refresh
+      // Reloads the cached AXI version after the firmware has changed.
+      case AVER_Refresh:
+         return AxiVersion_Cache(dev, dev->base + AVER_OFF);
+
       // Default handler for other commands not specifically handled above.
       // Delegates to a generic AxisG2_Command function for any other commands.
       default:
@@ -416,6 +428,7 @@ struct hardware_functions DataGpu_functions = {
    .sendBuffer   = AxisG2_SendBuffer,   // Send buffer to device.
    .command      = DataGpu_Command,     // Issue commands to device.
    .seqShow      = DataGpu_SeqShow,     // Display device sequence info.
+   .statsRegs    = AxisG2_StatsRegs,    // Snapshot registers for the statistics page.
 };
 
 /**
@@ -27,7 +27,8 @@
 /**
  * Commands for AXI version operations.
  */
-#define AVER_Get 0x1200
+#define AVER_Get     0x1200
+#define AVER_Refresh 0x1201
 
 /**
  * struct AxiVersion - Represents AXI version data.
@@ -82,5 +83,19 @@ struct AxiVersion {
       return(ioctl(fd, AVER_Get, aVer));
    }
 
+   /**
+    * axiVersionRefresh - Reload the cached AXI version information.
+    * @fd: File descriptor for the device.
+    *
+    * The static fields are cached by the driver at load time. This
+    * function rereads them from the hardware, for example after the
+    * FPGA has been reprogrammed.
+    *
+    * Return: 0 on success or an error code on failure.
+    */
+   static inline ssize_t axiVersionRefresh(int32_t fd) {
+      return(ioctl(fd, AVER_Refresh, 0));
+   }
+
 #endif  // !DMA_IN_KERNEL
 #endif  // __AXI_VERSION_H__
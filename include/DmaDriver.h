@@ -31,7 +31,7 @@
 #endif
 
 /* API Version */
-#define DMA_VERSION 0x06
+#define DMA_VERSION 0x08
 
 /* Error values */
 #define DMA_ERR_FIFO 0x01
@@ -64,10 +64,73 @@
 #define DMA_Get_RxBuffinSWQ_Count    0x1017
 #define DMA_Get_RxBuffMiss_Count     0x1018
 #define DMA_Get_GITV                 0x1019
+#define DMA_Join_Group               0x101A
+#define DMA_Leave_Group              0x101B
+#define DMA_Add_MaskBytes            0x101C
+#define DMA_Del_MaskBytes            0x101D
+#define DMA_Set_DestQueue            0x101E
+#define DMA_Get_DestReady            0x101F
+#define DMA_Read_Select              0x1020
+#define DMA_Set_TxQuota              0x1021
+#define DMA_Set_TxLowat              0x1022
+#define DMA_Set_EventFd              0x1023
+#define DMA_Set_TxPace               0x1024
+#define DMA_Write_Gather             0x1025
+#define DMA_Set_RxChain              0x1026
+#define DMA_Read_Frame               0x1027
+#define DMA_Reg_TxRegion             0x1028
+#define DMA_Unreg_TxRegion           0x1029
+#define DMA_Write_Zc                 0x102A
+#define DMA_Get_TxDone               0x102B
+#define DMA_Reg_RxRegion             0x102C
+#define DMA_Unreg_RxRegion           0x102D
+#define DMA_Set_RxSmall              0x102E
+#define DMA_Read_Small               0x102F
+#define DMA_Read_Packed              0x1030
+#define DMA_Set_ReadExt              0x1031
+#define DMA_Get_DestStats            0x1032
+#define DMA_Reg_Batch                0x1033
+#define DMA_Read_Block               0x1034
+#define DMA_Write_Block              0x1035
 
 /* Mask size */
 #define DMA_MASK_SIZE 512
 
+/* Maximum segments in a gathered write */
+#define DMA_MAX_SEGS 1024
+
+/* Maximum zero-copy transmit regions per file descriptor */
+#define DMA_MAX_ZC_REGION 16
+
+/* Packed frame records start on 8 byte boundaries */
+#define DMA_PACKED_ALIGN(size) (((size) + 7) & ~7)
+
+/* Shared destination distribution modes */
+#define DMA_GROUP_RR   0
+#define DMA_GROUP_LOAD 1
+
+/* Statistics page layout version, offset from the register space and contents */
+#define DMA_STATS_VERSION 1
+#define DMA_STATS_OFFSET  0x40000000
+#define DMA_STATS_DESTS   32
+#define DMA_STATS_REGS    32
+
+/* Furthest launch time of a scheduled write, 10 seconds ahead */
+#define DMA_LAUNCH_MAX_NS 10000000000ULL
+
+/* Highest transmit pacing rates, frames and bytes per second */
+#define DMA_PACE_FRAME_MAX 1000000000ULL
+#define DMA_PACE_BYTE_MAX  1000000000000ULL
+
+/* Register batch operations */
+#define DMA_REG_READ  0
+#define DMA_REG_WRITE 1
+#define DMA_REG_RMW   2
+#define DMA_REG_POLL  3
+
+/* Longest register poll timeout in microseconds */
+#define DMA_REG_POLL_MAX 1000000
+
 /**
  * struct DmaWriteData - Structure representing a DMA write operation.
  * @data: Physical address of the data to be written.
@@ -77,10 +140,12 @@
  * @size: Size of the data to be written.
  * @is32: Flag indicating whether the system uses 32-bit addressing.
  * @pad: Padding to align the structure to 64 bits.
+ * @launch: Launch time in ns on the CLOCK_MONOTONIC time base, 0 to send at once.
  *
  * This structure is used to initiate a DMA write operation. It contains
  * information about the data to be written, the destination, and various
- * control flags.
+ * control flags. The driver also accepts the structure without @launch,
+ * as used before API version 0x07.
  */
 struct DmaWriteData {
     uint64_t data;
@@ -90,11 +155,14 @@ struct DmaWriteData {
     uint32_t size;
     uint32_t is32;
     uint32_t pad;
+    uint64_t launch;
 };
 
 /**
  * struct DmaReadData - Structure representing a DMA read operation.
- * @data: Physical address where the read data will be stored.
+ * @data: Physical address where the read data will be stored. When zero,
+ *        returns the user address of a frame received into a region
+ *        registered with DMA_Reg_RxRegion.
  * @dest: Source address within the device.
  * @flags: Flags to control the read operation.
  * @index: Index of the buffer to be used for the read operation.
@@ -118,6 +186,139 @@ struct DmaReadData {
     int32_t ret;
 };
 
+/**
+ * struct DmaReadDataExt - Extended read record.
+ * @data: Pointer to the data buffer, or 0 to read by index.
+ * @dest: Source address within the device.
+ * @flags: Flags of the frame.
+ * @index: Index of the buffer holding the frame.
+ * @error: Error code of the frame.
+ * @size: Size of the @data buffer.
+ * @is32: Flag indicating whether the system uses 32-bit addressing.
+ * @ret: Size of the frame, or negative on failure.
+ * @seq: Receive sequence number of the frame, counted per destination.
+ * @harvest: CLOCK_MONOTONIC time in ns the driver took the frame from the hardware.
+ * @push: CLOCK_MONOTONIC time in ns the frame was queued for reading.
+ *
+ * Read after DMA_Set_ReadExt in place of struct DmaReadData. Sequence
+ * numbers also count frames dropped for lack of a reader, a gap shows
+ * lost frames. The times are 0 for frames taken from the hardware before
+ * extended records were enabled.
+ */
+struct DmaReadDataExt {
+    uint64_t data;
+    uint32_t dest;
+    uint32_t flags;
+    uint32_t index;
+    uint32_t error;
+    uint32_t size;
+    uint32_t is32;
+    int32_t  ret;
+    uint32_t seq;
+    uint64_t harvest;
+    uint64_t push;
+};
+
+/**
+ * struct DmaDestStats - Counters of one destination.
+ * @rxFrames: Received frames, a continued frame counts once.
+ * @rxBytes: Received bytes.
+ * @rxErrFifo: Received buffers reporting DMA_ERR_FIFO.
+ * @rxErrLen: Received buffers reporting DMA_ERR_LEN.
+ * @rxErrMax: Received buffers reporting DMA_ERR_MAX.
+ * @rxErrBus: Received buffers reporting DMA_ERR_BUS.
+ * @rxDrop: Received buffers dropped because no reader owned the destination.
+ * @rxOverflow: Received buffers dropped because the receive queue was full.
+ * @txFrames: Transmitted frames, a continued frame counts once.
+ * @txBytes: Transmitted bytes.
+ *
+ * Counters run from driver load and are returned by DMA_Get_DestStats.
+ */
+struct DmaDestStats {
+    uint64_t rxFrames;
+    uint64_t rxBytes;
+    uint64_t rxErrFifo;
+    uint64_t rxErrLen;
+    uint64_t rxErrMax;
+    uint64_t rxErrBus;
+    uint64_t rxDrop;
+    uint64_t rxOverflow;
+    uint64_t txFrames;
+    uint64_t txBytes;
+};
+
+/**
+ * struct DmaDestStatsReq - Request for destination counters.
+ * @data: User array of @count struct DmaDestStats entries.
+ * @dest: First destination.
+ * @count: Number of destinations.
+ * @is32: Flag indicating whether the system uses 32-bit addressing.
+ * @pad: Padding to align the structure to 64 bits.
+ */
+struct DmaDestStatsReq {
+    uint64_t data;
+    uint32_t dest;
+    uint32_t count;
+    uint32_t is32;
+    uint32_t pad;
+};
+
+/**
+ * struct DmaStatsPage - Read-only statistics page shared with user space.
+ * @version: Layout version, DMA_STATS_VERSION.
+ * @seq: Update sequence, odd while the driver is writing the page.
+ * @stamp: CLOCK_MONOTONIC time in ns of the last refresh.
+ * @period: Refresh period in ms.
+ * @regCount: Number of valid entries in @regs.
+ * @rxCount: Receive buffers.
+ * @rxUser: Receive buffers held by user space.
+ * @rxHw: Receive buffers in hardware.
+ * @rxPreHw: Receive buffers queued for hardware.
+ * @rxQueue: Receive buffers in software receive queues.
+ * @txCount: Transmit buffers.
+ * @txUser: Transmit buffers held by user space.
+ * @txHw: Transmit buffers in hardware.
+ * @txPreHw: Transmit buffers queued for hardware.
+ * @txQueue: Transmit buffers in the free queue.
+ * @svcMax: Most descriptors handled in one service pass.
+ * @pad: Padding to align the structure to 64 bits.
+ * @svcPass: Service passes of the receive and transmit completions.
+ * @svcHandled: Descriptors handled by all service passes.
+ * @svcEmpty: Service passes which found no descriptor.
+ * @regs: Snapshot of firmware status registers, the set depends on the card.
+ * @dest: Counters of destinations 0 to DMA_STATS_DESTS - 1.
+ *
+ * The page is mapped read-only with dmaMapStats. Buffer counts and service
+ * pass statistics are updated by the driver as they change. The register
+ * snapshot and destination counters are refreshed every @period ms while
+ * the page is mapped, @seq and @stamp cover that refresh. The page is read
+ * consistently with dmaReadStats.
+ */
+struct DmaStatsPage {
+    uint32_t version;
+    uint32_t seq;
+    uint64_t stamp;
+    uint32_t period;
+    uint32_t regCount;
+    uint32_t rxCount;
+    uint32_t rxUser;
+    uint32_t rxHw;
+    uint32_t rxPreHw;
+    uint32_t rxQueue;
+    uint32_t txCount;
+    uint32_t txUser;
+    uint32_t txHw;
+    uint32_t txPreHw;
+    uint32_t txQueue;
+    uint32_t svcMax;
+    uint32_t pad;
+    uint64_t svcPass;
+    uint64_t svcHandled;
+    uint64_t svcEmpty;
+    uint32_t regs[DMA_STATS_REGS];
+    struct DmaDestStats dest[DMA_STATS_DESTS];
+};
+
 /**
  * struct DmaRegisterData - Register data structure.
  * @address: Memory address.
@@ -131,6 +332,322 @@ struct DmaRegisterData {
     uint32_t data;
 };
 
+/**
+ * struct DmaRegOp - One operation of a register batch.
+ * @address: Register address.
+ * @op: Operation, one of DMA_REG_READ, DMA_REG_WRITE, DMA_REG_RMW or DMA_REG_POLL.
+ * @data: Value to write, or the expected value for DMA_REG_POLL. Replaced by
+ *        the value read for all operations except DMA_REG_WRITE.
+ * @mask: Bits modified by DMA_REG_RMW or compared by DMA_REG_POLL.
+ * @timeout: Poll timeout in microseconds, at most DMA_REG_POLL_MAX.
+ * @status: Returns 0 on success, -EFAULT for an invalid address, -EINVAL for
+ *          an invalid operation or timeout, -ETIMEDOUT for an expired poll,
+ *          -EINTR if the process was killed or -ECANCELED if an earlier
+ *          operation failed.
+ * @pad: Padding to align the structure to 64 bits.
+ *
+ * A read-modify-write writes (read & ~mask) | (data & mask) and returns the
+ * value read before the write. A poll reads until (read & mask) equals
+ * (data & mask) or the timeout expires.
+ */
+struct DmaRegOp {
+    uint64_t address;
+    uint32_t op;
+    uint32_t data;
+    uint32_t mask;
+    uint32_t timeout;
+    int32_t  status;
+    uint32_t pad;
+};
+
+/**
+ * struct DmaRegBatch - Register batch request.
+ * @data: User array of @count struct DmaRegOp entries.
+ * @count: Number of operations.
+ * @is32: Flag indicating whether the system uses 32-bit addressing.
+ */
+struct DmaRegBatch {
+    uint64_t data;
+    uint32_t count;
+    uint32_t is32;
+};
+
+/**
+ * struct DmaBlockData - Block transfer of a register window.
+ * @address: Register address of the first word.
+ * @data: User buffer holding or receiving the data.
+ * @size: Size in bytes, a multiple of 4.
+ * @is32: Flag indicating whether the system uses 32-bit addressing.
+ */
+struct DmaBlockData {
+    uint64_t address;
+    uint64_t data;
+    uint32_t size;
+    uint32_t is32;
+};
+
+/**
+ * struct DmaGroupData - Shared destination group request.
+ * @dest: Destination to be shared between readers.
+ * @mode: Distribution mode, DMA_GROUP_RR or DMA_GROUP_LOAD.
+ *
+ * This structure is passed with DMA_Join_Group to add the calling file
+ * descriptor to the set of readers consuming a single destination. The
+ * mode is only used when the first reader creates the group.
+ */
+struct DmaGroupData {
+    uint32_t dest;
+    uint32_t mode;
+};
+
+/**
+ * struct DmaTxQuota - Transmit buffer share of a file descriptor.
+ * @reserve: Transmit buffers reserved for the file descriptor.
+ * @limit: Maximum transmit buffers in use, 0 for no limit.
+ * @weight: Buffers granted per round when writers wait for buffers.
+ * @pad: Padding to align the structure to 64 bits.
+ *
+ * This structure is passed with DMA_Set_TxQuota.
+ */
+struct DmaTxQuota {
+    uint32_t reserve;
+    uint32_t limit;
+    uint32_t weight;
+    uint32_t pad;
+};
+
+/**
+ * struct DmaWriteSeg - Segment of a gathered write.
+ * @data: User address of the segment.
+ * @size: Size of the segment in bytes.
+ */
+struct DmaWriteSeg {
+    uint64_t data;
+    uint64_t size;
+};
+
+/**
+ * struct DmaWriteGather - Gathered write request.
+ * @segs: User pointer to an array of DmaWriteSeg.
+ * @segCount: Number of entries in @segs, at most DMA_MAX_SEGS.
+ * @dest: Destination of the frame.
+ * @flags: Flags of the frame, the continue bit is set by the driver between buffers.
+ * @is32: Flag indicating whether the system uses 32-bit addressing.
+ *
+ * This structure is passed with DMA_Write_Gather to send the segments as
+ * one frame, chained over as many transmit buffers as needed.
+ */
+struct DmaWriteGather {
+    uint64_t segs;
+    uint32_t segCount;
+    uint32_t dest;
+    uint32_t flags;
+    uint32_t is32;
+};
+
+/**
+ * struct DmaTxPace - Transmit rate limit of a destination.
+ * @dest: Destination to pace.
+ * @frameBurst: Frames which may be sent back to back, 0 for 1.
+ * @frameRate: Frames per second up to DMA_PACE_FRAME_MAX, 0 for no frame limit.
+ * @byteRate: Bytes per second up to DMA_PACE_BYTE_MAX, 0 for no byte limit.
+ * @byteBurst: Bytes which may be sent back to back, at least one buffer.
+ * @pad: Padding to align the structure to 64 bits.
+ *
+ * This structure is passed with DMA_Set_TxPace. Both rates set to zero
+ * remove the limit. A frame written over multiple buffers counts as one
+ * frame.
+ */
+struct DmaTxPace {
+    uint32_t dest;
+    uint32_t frameBurst;
+    uint64_t frameRate;
+    uint64_t byteRate;
+    uint32_t byteBurst;
+    uint32_t pad;
+};
+
+/**
+ * struct DmaEventFd - Eventfd notification binding.
+ * @rxFd: Eventfd signalled when frames are received, -1 for none.
+ * @txFd: Eventfd signalled when transmit buffers are available, -1 for none.
+ * @coalesce: Frames per receive signal while frames are waiting, 0 for 1.
+ * @pad: Padding to align the structure to 64 bits.
+ *
+ * This structure is passed with DMA_Set_EventFd.
+ */
+struct DmaEventFd {
+    int32_t  rxFd;
+    int32_t  txFd;
+    uint32_t coalesce;
+    uint32_t pad;
+};
+
+/**
+ * struct DmaReadSelect - Selective read request.
+ * @dests: User pointer to an array of destinations in priority order.
+ * @read: User pointer to an array of DmaReadData records.
+ * @destCount: Number of entries in @dests.
+ * @count: Number of entries in @read.
+ * @is32: Flag indicating whether the system uses 32-bit addressing.
+ * @pad: Padding to align the structure to 64 bits.
+ *
+ * This structure is passed with DMA_Read_Select to read frames from a
+ * subset of destinations once per-destination queues are enabled.
+ */
+struct DmaReadSelect {
+    uint64_t dests;
+    uint64_t read;
+    uint32_t destCount;
+    uint32_t count;
+    uint32_t is32;
+    uint32_t pad;
+};
+
+/**
+ * struct DmaTxRegion - User memory region for zero-copy transmit.
+ * @addr: User address of the region, 16 byte aligned.
+ * @size: Size of the region in bytes.
+ * @is32: Flag indicating whether the system uses 32-bit addressing.
+ * @pad: Padding to align the structure to 64 bits.
+ *
+ * This structure is passed with DMA_Reg_TxRegion, which pins and maps
+ * the region and returns its id.
+ */
+struct DmaTxRegion {
+    uint64_t addr;
+    uint64_t size;
+    uint32_t is32;
+    uint32_t pad;
+};
+
+/**
+ * struct DmaWriteZc - Zero-copy write request.
+ * @tag: User value reported by DMA_Get_TxDone once the frame is sent.
+ * @offset: Offset of the frame in the region, 16 byte aligned.
+ * @region: Region id returned by DMA_Reg_TxRegion.
+ * @size: Size of the frame in bytes.
+ * @dest: Destination of the frame.
+ * @flags: Flags of the frame.
+ *
+ * This structure is passed with DMA_Write_Zc to send a frame directly
+ * from a registered region. The frame memory must not be changed until
+ * its tag is returned by DMA_Get_TxDone.
+ */
+struct DmaWriteZc {
+    uint64_t tag;
+    uint64_t offset;
+    uint32_t region;
+    uint32_t size;
+    uint32_t dest;
+    uint32_t flags;
+};
+
+/**
+ * struct DmaTxDone - Zero-copy completion request.
+ * @tags: User pointer to an array receiving the tags of sent frames.
+ * @count: Number of entries in @tags.
+ * @is32: Flag indicating whether the system uses 32-bit addressing.
+ *
+ * This structure is passed with DMA_Get_TxDone.
+ */
+struct DmaTxDone {
+    uint64_t tags;
+    uint32_t count;
+    uint32_t is32;
+};
+
+/**
+ * struct DmaRxRegion - Zero-copy receive region.
+ * @addr: User address of the region, 16 byte aligned.
+ * @size: Size of the region in bytes, split into slots of one buffer each.
+ * @is32: Flag indicating whether the system uses 32-bit addressing.
+ * @pad: Padding for alignment.
+ *
+ * This structure is passed with DMA_Reg_RxRegion.
+ */
+struct DmaRxRegion {
+    uint64_t addr;
+    uint64_t size;
+    uint32_t is32;
+    uint32_t pad;
+};
+
+/**
+ * struct DmaReadFrame - Reassembled frame read request.
+ * @data: User buffer receiving the frame, 0 to read by index.
+ * @index: User pointer to an array receiving the buffer indexes of the frame.
+ * @dest: Destination of the frame.
+ * @flags: First user of the first buffer, last user and continue bit of the last buffer.
+ * @error: Errors of all buffers of the frame.
+ * @size: Size of the @data buffer.
+ * @count: Entries in the @index array, returns the number of buffers in the frame.
+ * @is32: Flag indicating whether the system uses 32-bit addressing.
+ * @ret: Size of the frame, or -1 if it could not be returned.
+ * @pad: Padding to align the structure to 64 bits.
+ *
+ * This structure is passed with DMA_Read_Frame to read one frame which
+ * the driver reassembled from continued buffers, see DMA_Set_RxChain.
+ */
+struct DmaReadFrame {
+    uint64_t data;
+    uint64_t index;
+    uint32_t dest;
+    uint32_t flags;
+    uint32_t error;
+    uint32_t size;
+    uint32_t count;
+    uint32_t is32;
+    int32_t  ret;
+    uint32_t pad;
+};
+
+/**
+ * struct DmaRxSmall - Small frame copy-out configuration.
+ * @max: Largest frame in bytes copied out, 0 to disable.
+ * @size: Size of the copy-out ring in bytes, rounded up to a power of two.
+ *
+ * This structure is passed with DMA_Set_RxSmall.
+ */
+struct DmaRxSmall {
+    uint32_t max;
+    uint32_t size;
+};
+
+/**
+ * struct DmaPackedHdr - Header of a packed frame record.
+ * @size: Size of the frame data following the header.
+ * @dest: Destination of the frame.
+ * @flags: Flags of the frame.
+ * @error: Error code of the frame.
+ *
+ * The next record starts DMA_PACKED_ALIGN(@size) bytes after the data.
+ */
+struct DmaPackedHdr {
+    uint32_t size;
+    uint32_t dest;
+    uint32_t flags;
+    uint32_t error;
+};
+
+/**
+ * struct DmaReadPacked - Packed read request.
+ * @data: User buffer receiving the packed frame records.
+ * @size: Size of the @data buffer.
+ * @count: Maximum number of frames to return, 0 for no limit.
+ * @is32: Flag indicating whether the system uses 32-bit addressing.
+ * @pad: Padding to align the structure to 64 bits.
+ *
+ * This structure is passed with DMA_Read_Small and DMA_Read_Packed.
+ */
+struct DmaReadPacked {
+    uint64_t data;
+    uint32_t size;
+    uint32_t count;
+    uint32_t is32;
+    uint32_t pad;
+};
+
 // Conditional inclusion for non-kernel environments
 #ifndef DMA_IN_KERNEL
     #include <signal.h>
@@ -155,7 +672,8 @@ struct DmaRegisterData {
  * This function writes a single frame of data to a DMA channel, specified by the
  * file descriptor @fd. The data to be written is pointed to by @buf, with a specified
  * size of @size. Additional parameters include flags (@flags) and a destination address
- * (@dest).
+ * (@dest). A frame larger than the driver buffer size is chained over multiple
+ * buffers by the driver, with the continue bit set on all but the last.
  *
  * Return: Number of bytes written, or a negative error code on failure.
  */
@@ -199,6 +717,63 @@ static inline ssize_t dmaWriteIndex(int32_t fd, uint32_t index, size_t size, uin
     return (write(fd, &w, sizeof(struct DmaWriteData)));
 }
 
+/**
+ * dmaWriteAt - Writes data to a DMA channel at a requested time.
+ * @fd: File descriptor for the DMA device.
+ * @buf: Pointer to the data buffer.
+ * @size: Size of the data to write.
+ * @flags: Flags for the write operation.
+ * @dest: Destination address for the write.
+ * @launch: Launch time in ns on the CLOCK_MONOTONIC time base.
+ *
+ * The driver holds the frame and passes it to the hardware at @launch,
+ * avoiding the scheduling jitter of sleeping in user space. A launch time
+ * already passed sends the frame at once, one more than DMA_LAUNCH_MAX_NS
+ * ahead is rejected. Frames still waiting are dropped when the file
+ * descriptor is closed. Launch errors are shown in the /proc status of
+ * the device.
+ *
+ * Return: Number of bytes written, or a negative error code on failure.
+ */
+static inline ssize_t dmaWriteAt(int32_t fd, const void* buf, size_t size, uint32_t flags, uint32_t dest, uint64_t launch) {
+    struct DmaWriteData w;
+
+    memset(&w, 0, sizeof(struct DmaWriteData));
+    w.dest   = dest;
+    w.flags  = flags;
+    w.size   = size;
+    w.is32   = (sizeof(void*) == 4);
+    w.data   = (uint64_t)buf;//NOLINT
+    w.launch = launch;
+
+    return (write(fd, &w, sizeof(struct DmaWriteData)));
+}
+
+/**
+ * dmaWriteIndexAt - Writes an indexed buffer to a DMA channel at a requested time.
+ * @fd: File descriptor for the DMA device.
+ * @index: Index of the data buffer.
+ * @size: Size of the data to write.
+ * @flags: Flags for the write operation.
+ * @dest: Destination address for the write.
+ * @launch: Launch time in ns on the CLOCK_MONOTONIC time base.
+ *
+ * Return: Number of bytes written, or a negative error code on failure.
+ */
+static inline ssize_t dmaWriteIndexAt(int32_t fd, uint32_t index, size_t size, uint32_t flags, uint32_t dest, uint64_t launch) {
+    struct DmaWriteData w;
+
+    memset(&w, 0, sizeof(struct DmaWriteData));
+    w.dest   = dest;
+    w.flags  = flags;
+    w.size   = size;
+    w.is32   = (sizeof(void*) == 4);
+    w.index  = index;
+    w.launch = launch;
+
+    return (write(fd, &w, sizeof(struct DmaWriteData)));
+}
+
 /**
  * dmaWriteVector - Writes an array of data frames to a DMA channel.
  * @fd: File descriptor for the DMA device.
@@ -254,41 +829,207 @@ static inline ssize_t dmaWriteVector(int32_t fd,
 }
 
 /**
- * dmaWriteIndexVector - Write Frame, memory mapped from iovector.
- * @fd: File descriptor for DMA operation.
- * @iov: Pointer to array of iovec structures.
- * @iovlen: Length of the iov array.
- * @begFlags: Flags to use for the beginning of the DMA transaction.
- * @midFlags: Flags to use for the middle of the DMA transaction.
- * @endFlags: Flags to use for the end of the DMA transaction.
- * @dest: Destination address for the DMA write.
+ * dmaWriteGather - Writes one frame gathered from an array of buffers.
+ * @fd: File descriptor for the DMA device.
+ * @iov: Pointer to the array of iovec structures holding the frame.
+ * @iovlen: Number of elements in the iov array, at most DMA_MAX_SEGS.
+ * @flags: Flags for the frame.
+ * @dest: Destination address for the write.
  *
- * This function writes a frame to a device, using DMA, where the frame data
- * is described by an array of iovec structures.
+ * Unlike dmaWriteVector, which writes one frame per iovec entry, the
+ * entries are concatenated into a single frame in one system call. The
+ * driver copies them directly into as many transmit buffers as needed and
+ * sets the continue bit on all but the last.
  *
- * Return: Total number of bytes written, or negative on failure.
+ * Return: Number of bytes written, 0 if not enough buffers are available,
+ *         or a negative error code on failure.
  */
-static inline ssize_t dmaWriteIndexVector(int32_t fd,
-                                          struct iovec* iov,
-                                          size_t iovlen,
-                                          uint32_t begFlags,
-                                          uint32_t midFlags,
-                                          uint32_t endFlags,
-                                          uint32_t dest) {
-    uint32_t x;
-    ssize_t ret;
-    ssize_t res;
-    struct DmaWriteData w;
-
-    ret = 0;
+static inline ssize_t dmaWriteGather(int32_t fd, struct iovec* iov, size_t iovlen, uint32_t flags, uint32_t dest) {
+    struct DmaWriteSeg seg[iovlen];
+    struct DmaWriteGather g;
+    size_t x;
 
     for (x = 0; x < iovlen; x++) {
-        memset(&w, 0, sizeof(struct DmaWriteData));
-        w.dest  = dest;
-        w.flags = (x == 0) ? begFlags : ((x == (iovlen - 1)) ? endFlags : midFlags);
-        w.size  = iov[x].iov_len;
-        w.is32  = (sizeof(void*) == 4);
-        w.index = (uint32_t)(((uint64_t)iov[x].iov_base) & 0xFFFFFFFF);//NOLINT
+        seg[x].data = (uint64_t)iov[x].iov_base;//NOLINT
+        seg[x].size = iov[x].iov_len;
+    }
+
+    memset(&g, 0, sizeof(struct DmaWriteGather));
+    g.segs     = (uint64_t)seg;//NOLINT
+    g.segCount = iovlen;
+    g.dest     = dest;
+    g.flags    = flags;
+    g.is32     = (sizeof(void*) == 4);
+
+    return (ioctl(fd, DMA_Write_Gather, &g));
+}
+
+/**
+ * dmaRegTxRegion - Register user memory for zero-copy transmit.
+ * @fd: File descriptor for the DMA device.
+ * @addr: Start of the region, 16 byte aligned.
+ * @size: Size of the region in bytes.
+ *
+ * The driver pins the pages of the region and maps them for DMA once, so
+ * that frames written with dmaWriteZc are read by the hardware directly
+ * from user memory without a copy.
+ *
+ * Return: Region id for dmaWriteZc, or negative on failure.
+ */
+static inline ssize_t dmaRegTxRegion(int32_t fd, void* addr, size_t size) {
+    struct DmaTxRegion r;
+
+    memset(&r, 0, sizeof(struct DmaTxRegion));
+    r.addr = (uint64_t)addr;//NOLINT
+    r.size = size;
+    r.is32 = (sizeof(void*) == 4);
+
+    return (ioctl(fd, DMA_Reg_TxRegion, &r));
+}
+
+/**
+ * dmaUnregTxRegion - Release a zero-copy transmit region.
+ * @fd: File descriptor for the DMA device.
+ * @region: Region id returned by dmaRegTxRegion.
+ *
+ * Fails while frames from the region are still being sent.
+ *
+ * Return: Result from the IOCTL call.
+ */
+static inline ssize_t dmaUnregTxRegion(int32_t fd, uint32_t region) {
+    return (ioctl(fd, DMA_Unreg_TxRegion, region));
+}
+
+/**
+ * dmaWriteZc - Write a frame directly from a registered region.
+ * @fd: File descriptor for the DMA device.
+ * @region: Region id returned by dmaRegTxRegion.
+ * @offset: Offset of the frame in the region, 16 byte aligned.
+ * @size: Size of the frame in bytes.
+ * @flags: Flags for the frame.
+ * @dest: Destination address for the write.
+ * @tag: Value returned by dmaGetTxDone once the frame has been sent.
+ *
+ * The frame memory must not be modified until its tag is returned.
+ *
+ * Return: Number of bytes queued, 0 if not enough buffers are available,
+ *         or a negative error code on failure.
+ */
+static inline ssize_t dmaWriteZc(int32_t fd, uint32_t region, uint64_t offset, uint32_t size,
+                                 uint32_t flags, uint32_t dest, uint64_t tag) {
+    struct DmaWriteZc w;
+
+    memset(&w, 0, sizeof(struct DmaWriteZc));
+    w.tag    = tag;
+    w.offset = offset;
+    w.region = region;
+    w.size   = size;
+    w.dest   = dest;
+    w.flags  = flags;
+
+    return (ioctl(fd, DMA_Write_Zc, &w));
+}
+
+/**
+ * dmaGetTxDone - Get the tags of sent zero-copy frames.
+ * @fd: File descriptor for the DMA device.
+ * @tags: Array to store the tags.
+ * @count: Number of entries in @tags.
+ *
+ * Each completion wakes writers polling for POLLOUT and signals a
+ * transmit eventfd bound with dmaSetEventFd.
+ *
+ * Return: Number of tags returned, or negative on failure.
+ */
+static inline ssize_t dmaGetTxDone(int32_t fd, uint64_t* tags, uint32_t count) {
+    struct DmaTxDone d;
+
+    memset(&d, 0, sizeof(struct DmaTxDone));
+    d.tags  = (uint64_t)tags;//NOLINT
+    d.count = count;
+    d.is32  = (sizeof(void*) == 4);
+
+    return (ioctl(fd, DMA_Get_TxDone, &d));
+}
+
+/**
+ * dmaRegRxRegion - Register user memory for zero-copy receive.
+ * @fd: File descriptor for the DMA device.
+ * @addr: Start of the region, 16 byte aligned.
+ * @size: Size of the region in bytes.
+ *
+ * The region is split into slots of the buffer size which the hardware
+ * writes in place of the driver buffers. Frames received into a slot are
+ * read with dmaReadIndexAddr and stay valid until the index is returned.
+ * Slots larger than a page must be contiguous for the device, for
+ * example by using huge pages. The descriptor must hold every open
+ * destination, other readers can not open destinations until the
+ * region is released and all of its slots are returned by the hardware.
+ *
+ * Return: Region id, or negative on failure.
+ */
+static inline ssize_t dmaRegRxRegion(int32_t fd, void* addr, size_t size) {
+    struct DmaRxRegion r;
+
+    memset(&r, 0, sizeof(struct DmaRxRegion));
+    r.addr = (uint64_t)addr;//NOLINT
+    r.size = size;
+    r.is32 = (sizeof(void*) == 4);
+
+    return (ioctl(fd, DMA_Reg_RxRegion, &r));
+}
+
+/**
+ * dmaUnregRxRegion - Release a zero-copy receive region.
+ * @fd: File descriptor for the DMA device.
+ * @region: Region id returned by dmaRegRxRegion.
+ *
+ * The memory stays pinned until the hardware has returned all of its
+ * slots, it must not be unmapped before the indexes read from it are
+ * returned.
+ *
+ * Return: Result from the IOCTL call.
+ */
+static inline ssize_t dmaUnregRxRegion(int32_t fd, uint32_t region) {
+    return (ioctl(fd, DMA_Unreg_RxRegion, region));
+}
+
+/**
+ * dmaWriteIndexVector - Write Frame, memory mapped from iovector.
+ * @fd: File descriptor for DMA operation.
+ * @iov: Pointer to array of iovec structures.
+ * @iovlen: Length of the iov array.
+ * @begFlags: Flags to use for the beginning of the DMA transaction.
+ * @midFlags: Flags to use for the middle of the DMA transaction.
+ * @endFlags: Flags to use for the end of the DMA transaction.
+ * @dest: Destination address for the DMA write.
+ *
+ * This function writes a frame to a device, using DMA, where the frame data
+ * is described by an array of iovec structures.
+ *
+ * Return: Total number of bytes written, or negative on failure.
+ */
+static inline ssize_t dmaWriteIndexVector(int32_t fd,
+                                          struct iovec* iov,
+                                          size_t iovlen,
+                                          uint32_t begFlags,
+                                          uint32_t midFlags,
+                                          uint32_t endFlags,
+                                          uint32_t dest) {
+    uint32_t x;
+    ssize_t ret;
+    ssize_t res;
+    struct DmaWriteData w;
+
+    ret = 0;
+
+    for (x = 0; x < iovlen; x++) {
+        memset(&w, 0, sizeof(struct DmaWriteData));
+        w.dest  = dest;
+        w.flags = (x == 0) ? begFlags : ((x == (iovlen - 1)) ? endFlags : midFlags);
+        w.size  = iov[x].iov_len;
+        w.is32  = (sizeof(void*) == 4);
+        w.index = (uint32_t)(((uint64_t)iov[x].iov_base) & 0xFFFFFFFF);//NOLINT
 
         do {
             res = write(fd, &w, sizeof(struct DmaWriteData));
@@ -368,6 +1109,40 @@ static inline ssize_t dmaReadIndex(int32_t fd, uint32_t* index, uint32_t* flags,
     return (r.ret);
 }
 
+/**
+ * dmaReadIndexAddr - Receive frame by index, with the address of its data.
+ * @fd: File descriptor for DMA operation.
+ * @index: Pointer to store the index of the received data.
+ * @data: Pointer to store the frame address in a region registered with
+ *        dmaRegRxRegion, or NULL when the frame is in the mapped buffer.
+ * @flags: Pointer to store flags after reading.
+ * @error: Pointer to store error code if any.
+ * @dest: Pointer to store destination address.
+ *
+ * Like dmaReadIndex, the index is returned with dmaRetIndex in both cases.
+ *
+ * Return: Size of the data received, or negative on failure.
+ */
+static inline ssize_t dmaReadIndexAddr(int32_t fd, uint32_t* index, void** data, uint32_t* flags, uint32_t* error, uint32_t* dest) {
+    struct DmaReadData r;
+    size_t ret;
+
+    memset(&r, 0, sizeof(struct DmaReadData));
+    r.is32 = (sizeof(void*) == 4);
+
+    ret = read(fd, &r, sizeof(struct DmaReadData));
+
+    if (ret <= 0) return (ret);
+
+    if (dest != NULL) *dest = r.dest;
+    if (flags != NULL) *flags = r.flags;
+    if (error != NULL) *error = r.error;
+
+    *data = (void*)r.data;//NOLINT
+    *index = r.index;
+    return (r.ret);
+}
+
 /**
  * dmaReadBulkIndex - Receive frame and access memory-mapped buffer.
  * @fd: File descriptor to read from.
@@ -811,6 +1586,487 @@ static inline ssize_t dmaSetMaskBytes(int32_t fd, uint8_t* mask) {
     return (ioctl(fd, DMA_Set_MaskBytes, mask));
 }
 
+/**
+ * dmaSubscribeMaskBytes - Reserve additional destinations on an open descriptor.
+ * @fd: File descriptor for the DMA device.
+ * @mask: Pointer to the DMA mask byte array of destinations to add.
+ *
+ * Unlike dmaSetMaskBytes this may be called any number of times. The
+ * request either reserves every destination in @mask or, if one of them
+ * is in use elsewhere, none of them.
+ *
+ * Return: Result from the IOCTL call.
+ */
+static inline ssize_t dmaSubscribeMaskBytes(int32_t fd, uint8_t* mask) {
+    return (ioctl(fd, DMA_Add_MaskBytes, mask));
+}
+
+/**
+ * dmaUnsubscribeMaskBytes - Release destinations held by an open descriptor.
+ * @fd: File descriptor for the DMA device.
+ * @mask: Pointer to the DMA mask byte array of destinations to release.
+ *
+ * Frames already received for the released destinations remain readable.
+ *
+ * Return: Result from the IOCTL call.
+ */
+static inline ssize_t dmaUnsubscribeMaskBytes(int32_t fd, uint8_t* mask) {
+    return (ioctl(fd, DMA_Del_MaskBytes, mask));
+}
+
+/**
+ * dmaJoinGroup - Join the group of readers sharing a destination.
+ * @fd: File descriptor for the DMA device.
+ * @dest: Destination to share.
+ * @mode: Distribution mode, DMA_GROUP_RR or DMA_GROUP_LOAD.
+ *
+ * Frames received on @dest are distributed across all file descriptors
+ * which have joined the group, either round-robin or to the reader with
+ * the shortest receive queue. A destination reserved with dmaSetMaskBytes
+ * can not be shared.
+ *
+ * Return: Result from the IOCTL call.
+ */
+static inline ssize_t dmaJoinGroup(int32_t fd, uint32_t dest, uint32_t mode) {
+    struct DmaGroupData grp;
+
+    grp.dest = dest;
+    grp.mode = mode;
+    return (ioctl(fd, DMA_Join_Group, &grp));
+}
+
+/**
+ * dmaLeaveGroup - Leave the group of readers sharing a destination.
+ * @fd: File descriptor for the DMA device.
+ * @dest: Destination previously joined with dmaJoinGroup.
+ *
+ * Return: Result from the IOCTL call.
+ */
+static inline ssize_t dmaLeaveGroup(int32_t fd, uint32_t dest) {
+    return (ioctl(fd, DMA_Leave_Group, dest));
+}
+
+/**
+ * dmaSetDestQueue - Enable or disable per-destination receive queues.
+ * @fd: File descriptor for the DMA device.
+ * @enable: Non-zero to queue received frames separately per destination.
+ *
+ * With per-destination queues enabled a plain read rotates over the
+ * destinations with frames waiting, so one busy destination can not
+ * starve the others, and dmaReadSelect can service a chosen subset.
+ *
+ * Return: Result from the IOCTL call.
+ */
+static inline ssize_t dmaSetDestQueue(int32_t fd, uint32_t enable) {
+    return (ioctl(fd, DMA_Set_DestQueue, enable));
+}
+
+/**
+ * dmaGetDestReady - Get the destinations with frames waiting.
+ * @fd: File descriptor for the DMA device.
+ * @mask: Pointer to a DMA mask byte array to be filled.
+ *
+ * Requires per-destination queues to be enabled with dmaSetDestQueue.
+ *
+ * Return: Result from the IOCTL call.
+ */
+static inline ssize_t dmaGetDestReady(int32_t fd, uint8_t* mask) {
+    return (ioctl(fd, DMA_Get_DestReady, mask));
+}
+
+/**
+ * dmaReadSelect - Receive a frame from a list of destinations.
+ * @fd: File descriptor to read from.
+ * @dests: Destinations to read from in priority order.
+ * @destCount: Number of entries in @dests.
+ * @buf: Buffer to store the received data.
+ * @maxSize: Maximum size of the buffer.
+ * @flags: Pointer to store flags after reading.
+ * @error: Pointer to store error code if any.
+ * @dest: Pointer to store destination address.
+ *
+ * Return: Size of the data received, 0 if no listed destination has a
+ *         frame waiting, or negative on failure.
+ */
+static inline ssize_t dmaReadSelect(int32_t fd,
+                                    uint32_t* dests,
+                                    uint32_t destCount,
+                                    void* buf,
+                                    size_t maxSize,
+                                    uint32_t* flags,
+                                    uint32_t* error,
+                                    uint32_t* dest) {
+    struct DmaReadSelect s;
+    struct DmaReadData r;
+    ssize_t ret;
+
+    memset(&r, 0, sizeof(struct DmaReadData));
+    r.size = maxSize;
+    r.is32 = (sizeof(void*) == 4);
+    r.data = (uint64_t)buf;//NOLINT
+
+    memset(&s, 0, sizeof(struct DmaReadSelect));
+    s.dests     = (uint64_t)dests;//NOLINT
+    s.read      = (uint64_t)&r;//NOLINT
+    s.destCount = destCount;
+    s.count     = 1;
+    s.is32      = (sizeof(void*) == 4);
+
+    ret = ioctl(fd, DMA_Read_Select, &s);
+
+    if (ret <= 0) return (ret);
+
+    if (dest != NULL) *dest = r.dest;
+    if (flags != NULL) *flags = r.flags;
+    if (error != NULL) *error = r.error;
+
+    return (r.ret);
+}
+
+/**
+ * dmaReadSelectBulkIndex - Receive frames from a list of destinations by index.
+ * @fd: File descriptor to read from.
+ * @dests: Destinations to read from in priority order.
+ * @destCount: Number of entries in @dests.
+ * @count: Number of elements in the buffers.
+ * @ret: Pointer to store the return values.
+ * @index: Buffer to store the indices of the DMA read operations.
+ * @flags: Buffer to store flags of the DMA read operations.
+ * @error: Buffer to store error codes of the DMA read operations.
+ * @dest: Buffer to store destination addresses of the DMA read operations.
+ *
+ * Each listed destination is drained before the next one is read.
+ *
+ * Returns: The number of frames read.
+ */
+static inline ssize_t dmaReadSelectBulkIndex(int32_t fd,
+                                             uint32_t* dests,
+                                             uint32_t destCount,
+                                             uint32_t count,
+                                             int32_t* ret,
+                                             uint32_t* index,
+                                             uint32_t* flags,
+                                             uint32_t* error,
+                                             uint32_t* dest) {
+    struct DmaReadSelect s;
+    struct DmaReadData r[count];
+    ssize_t res;
+    ssize_t x;
+
+    memset(r, 0, count * sizeof(struct DmaReadData));
+
+    memset(&s, 0, sizeof(struct DmaReadSelect));
+    s.dests     = (uint64_t)dests;//NOLINT
+    s.read      = (uint64_t)r;//NOLINT
+    s.destCount = destCount;
+    s.count     = count;
+    s.is32      = (sizeof(void*) == 4);
+
+    res = ioctl(fd, DMA_Read_Select, &s);
+
+    for (x = 0; x < res; ++x) {
+        if (dest != NULL) dest[x] = r[x].dest;
+        if (flags != NULL) flags[x] = r[x].flags;
+        if (error != NULL) error[x] = r[x].error;
+
+        index[x] = r[x].index;
+        ret[x]   = r[x].ret;
+    }
+    return (res);
+}
+
+/**
+ * dmaSetRxChain - Enable or disable receive frame reassembly.
+ * @fd: File descriptor for the DMA device.
+ * @max: Maximum buffers per frame, at least 2 and at most half the receive
+ *       buffers, or 0 to disable.
+ *
+ * When enabled, buffers received with the continue bit set are collected
+ * by the driver and delivered as one frame once the last buffer arrives.
+ * A frame reaching @max buffers is delivered with the continue bit still
+ * set and DMA_ERR_MAX in its error. A copy mode read gathers the frame
+ * into the user buffer, dmaReadFrameIndex returns all of its indexes.
+ *
+ * Return: Result from the IOCTL call.
+ */
+static inline ssize_t dmaSetRxChain(int32_t fd, uint32_t max) {
+    return (ioctl(fd, DMA_Set_RxChain, max));
+}
+
+/**
+ * dmaReadFrameIndex - Receive a reassembled frame by buffer index.
+ * @fd: File descriptor to read from.
+ * @index: Array to store the indexes of the buffers of the frame.
+ * @maxCount: Number of entries in @index.
+ * @count: Pointer to store the number of buffers in the frame.
+ * @flags: Pointer to store flags after reading.
+ * @error: Pointer to store error code if any.
+ * @dest: Pointer to store destination address.
+ *
+ * Every returned index must be released with dmaRetIndexes.
+ *
+ * Return: Size of the frame, 0 if no frame is waiting, or negative on failure.
+ */
+static inline ssize_t dmaReadFrameIndex(int32_t fd,
+                                        uint32_t* index,
+                                        uint32_t maxCount,
+                                        uint32_t* count,
+                                        uint32_t* flags,
+                                        uint32_t* error,
+                                        uint32_t* dest) {
+    struct DmaReadFrame r;
+    ssize_t res;
+
+    memset(&r, 0, sizeof(struct DmaReadFrame));
+    r.index = (uint64_t)index;//NOLINT
+    r.count = maxCount;
+    r.is32  = (sizeof(void*) == 4);
+
+    if ((res = ioctl(fd, DMA_Read_Frame, &r)) <= 0) return (res);
+
+    if (count != NULL) *count = r.count;
+    if (dest != NULL) *dest = r.dest;
+    if (flags != NULL) *flags = r.flags;
+    if (error != NULL) *error = r.error;
+
+    return (r.ret);
+}
+
+/**
+ * dmaSetRxSmall - Enable or disable small frame copy-out.
+ * @fd: File descriptor for the DMA device.
+ * @max: Largest frame in bytes to copy out, 0 to disable.
+ * @size: Size of the copy-out ring in bytes.
+ *
+ * Frames up to @max bytes are copied into a ring of the file descriptor
+ * as they arrive and their DMA buffers return to the hardware at once,
+ * so that bursts of small frames do not hold the receive buffers until
+ * they are read. The ring is read with dmaReadPacked, which keeps frames
+ * in order, or with dmaReadSmall, which must then drain the ring before
+ * the other read calls are used. Frames
+ * still in the ring are dropped when it is resized or disabled.
+ *
+ * Return: Result from the IOCTL call.
+ */
+static inline ssize_t dmaSetRxSmall(int32_t fd, uint32_t max, uint32_t size) {
+    struct DmaRxSmall r;
+
+    memset(&r, 0, sizeof(struct DmaRxSmall));
+    r.max  = max;
+    r.size = size;
+
+    return (ioctl(fd, DMA_Set_RxSmall, &r));
+}
+
+/**
+ * dmaReadSmall - Read copied out small frames in one call.
+ * @fd: File descriptor to read from.
+ * @buf: Buffer receiving packed frame records.
+ * @size: Size of @buf in bytes.
+ * @count: Maximum number of frames to read, 0 for no limit.
+ *
+ * Each record is a DmaPackedHdr followed by the frame data, walk them
+ * with dmaPackedNext.
+ *
+ * Return: Number of frames read, 0 if none are waiting, or negative on failure.
+ */
+static inline ssize_t dmaReadSmall(int32_t fd, void* buf, uint32_t size, uint32_t count) {
+    struct DmaReadPacked r;
+
+    memset(&r, 0, sizeof(struct DmaReadPacked));
+    r.data  = (uint64_t)buf;//NOLINT
+    r.size  = size;
+    r.count = count;
+    r.is32  = (sizeof(void*) == 4);
+
+    return (ioctl(fd, DMA_Read_Small, &r));
+}
+
+/**
+ * dmaReadPacked - Read many frames into one buffer.
+ * @fd: File descriptor to read from.
+ * @buf: Buffer receiving packed frame records.
+ * @size: Size of @buf in bytes.
+ * @count: Maximum number of frames to read, 0 for no limit.
+ *
+ * Returns copied out small frames followed by as many queued frames as
+ * fit in @buf, each as a DmaPackedHdr followed by the frame data, walk
+ * them with dmaPackedNext. The buffers of the frames are returned to the
+ * hardware by the call. Not available with dmaSetDestQueue.
+ *
+ * Return: Number of frames read, 0 if none are waiting, or negative on failure.
+ */
+static inline ssize_t dmaReadPacked(int32_t fd, void* buf, uint32_t size, uint32_t count) {
+    struct DmaReadPacked r;
+
+    memset(&r, 0, sizeof(struct DmaReadPacked));
+    r.data  = (uint64_t)buf;//NOLINT
+    r.size  = size;
+    r.count = count;
+    r.is32  = (sizeof(void*) == 4);
+
+    return (ioctl(fd, DMA_Read_Packed, &r));
+}
+
+/**
+ * dmaPackedNext - Step to the next packed frame record.
+ * @hdr: Current record.
+ *
+ * Return: Pointer to the next record.
+ */
+static inline struct DmaPackedHdr* dmaPackedNext(struct DmaPackedHdr* hdr) {
+    return ((struct DmaPackedHdr*)(((uint8_t*)(hdr + 1)) + DMA_PACKED_ALIGN(hdr->size)));
+}
+/**
+ * dmaSetReadExt - Select extended read records.
+ * @fd: File descriptor for the DMA device.
+ * @enable: Non-zero to read struct DmaReadDataExt, zero for struct DmaReadData.
+ *
+ * While enabled, read on @fd takes and returns DmaReadDataExt records and
+ * the driver reads the clock for every receive pass and queued frame.
+ * The plain read helpers must not be used on @fd while it is enabled.
+ *
+ * Return: Result from the IOCTL call.
+ */
+static inline ssize_t dmaSetReadExt(int32_t fd, uint32_t enable) {
+    return (ioctl(fd, DMA_Set_ReadExt, enable));
+}
+
+/**
+ * dmaReadBulkExt - Read frames by index with extended records.
+ * @fd: File descriptor for the DMA device.
+ * @count: Number of records in @r.
+ * @r: Records receiving the frames.
+ *
+ * Requires dmaSetReadExt. The buffer indexes are returned with
+ * dmaRetIndexes as for dmaReadBulkIndex.
+ *
+ * Return: Number of frames read, or negative on failure.
+ */
+static inline ssize_t dmaReadBulkExt(int32_t fd, uint32_t count, struct DmaReadDataExt* r) {
+    memset(r, 0, count * sizeof(struct DmaReadDataExt));
+    return (read(fd, r, count * sizeof(struct DmaReadDataExt)));
+}
+
+/**
+ * dmaGetDestStats - Read the counters of a range of destinations.
+ * @fd: File descriptor for the DMA device.
+ * @dest: First destination.
+ * @count: Number of destinations.
+ * @stats: Array of @count entries receiving the counters.
+ *
+ * Destinations above 255 are only counted once a reader has claimed one
+ * of the destinations in their block of 256, their entries stay zero
+ * until then.
+ *
+ * Return: Number of entries filled, or negative on failure.
+ */
+static inline ssize_t dmaGetDestStats(int32_t fd, uint32_t dest, uint32_t count, struct DmaDestStats* stats) {
+    struct DmaDestStatsReq r;
+
+    memset(&r, 0, sizeof(struct DmaDestStatsReq));
+    r.data  = (uint64_t)stats;//NOLINT
+    r.dest  = dest;
+    r.count = count;
+    r.is32  = (sizeof(void*) == 4);
+
+    return (ioctl(fd, DMA_Get_DestStats, &r));
+}
+
+/**
+ * dmaSetTxQuota - Set the transmit buffer share of a file descriptor.
+ * @fd: File descriptor for the DMA device.
+ * @reserve: Transmit buffers reserved for this file descriptor.
+ * @limit: Maximum transmit buffers in use, 0 for no limit.
+ * @weight: Buffers granted per round when writers wait for buffers, 0 for 1.
+ *
+ * Reserved buffers are held back from other writers so that low rate
+ * control traffic is not starved by bulk writers. Free buffers beyond the
+ * reservations are shared between waiting writers in proportion to their
+ * weight, and poll reports POLLOUT only to a writer that will get a buffer.
+ * Buffers granted to a writer which does not take one within 100 ms
+ * return to the shared pool.
+ *
+ * Return: Result from the IOCTL call.
+ */
+static inline ssize_t dmaSetTxQuota(int32_t fd, uint32_t reserve, uint32_t limit, uint32_t weight) {
+    struct DmaTxQuota quota;
+
+    memset(&quota, 0, sizeof(struct DmaTxQuota));
+    quota.reserve = reserve;
+    quota.limit   = limit;
+    quota.weight  = weight;
+    return (ioctl(fd, DMA_Set_TxQuota, &quota));
+}
+
+/**
+ * dmaSetTxLowat - Set the POLLOUT low-watermark of a file descriptor.
+ * @fd: File descriptor for the DMA device.
+ * @count: Transmit buffers which must be available before POLLOUT, 0 for 1.
+ *
+ * Return: Result from the IOCTL call.
+ */
+static inline ssize_t dmaSetTxLowat(int32_t fd, uint32_t count) {
+    return (ioctl(fd, DMA_Set_TxLowat, count));
+}
+
+/**
+ * dmaSetTxPace - Limit the transmit rate of a destination.
+ * @fd: File descriptor for the DMA device.
+ * @dest: Destination to pace.
+ * @frameRate: Frames per second, 0 for no frame limit.
+ * @frameBurst: Frames which may be sent back to back, 0 for 1.
+ * @byteRate: Bytes per second, 0 for no byte limit.
+ * @byteBurst: Bytes which may be sent back to back, at least one buffer.
+ *
+ * Frames written to a paced destination are held in the driver and
+ * released to the hardware by a timer as the rate allows, so writes do
+ * not block. Achieved rates and the time frames waited are shown in the
+ * /proc status of the device.
+ *
+ * Return: Result from the IOCTL call.
+ */
+static inline ssize_t dmaSetTxPace(int32_t fd,
+                                   uint32_t dest,
+                                   uint64_t frameRate,
+                                   uint32_t frameBurst,
+                                   uint64_t byteRate,
+                                   uint32_t byteBurst) {
+    struct DmaTxPace pace;
+
+    memset(&pace, 0, sizeof(struct DmaTxPace));
+    pace.dest       = dest;
+    pace.frameRate  = frameRate;
+    pace.frameBurst = frameBurst;
+    pace.byteRate   = byteRate;
+    pace.byteBurst  = byteBurst;
+    return (ioctl(fd, DMA_Set_TxPace, &pace));
+}
+
+/**
+ * dmaSetEventFd - Bind eventfd notification to a file descriptor.
+ * @fd: File descriptor for the DMA device.
+ * @rxFd: Eventfd signalled when frames are received, -1 for none.
+ * @txFd: Eventfd signalled when transmit buffers are available, -1 for none.
+ * @coalesce: Frames per receive signal while frames are waiting, 0 for 1.
+ *
+ * A signal is always sent when a frame arrives to an empty queue, so the
+ * application must read until no frames remain after each notification.
+ * The eventfds can be added to an epoll set or io_uring in place of the
+ * SIGIO handler installed by dmaAssignHandler.
+ *
+ * Return: Result from the IOCTL call.
+ */
+static inline ssize_t dmaSetEventFd(int32_t fd, int32_t rxFd, int32_t txFd, uint32_t coalesce) {
+    struct DmaEventFd ev;
+
+    memset(&ev, 0, sizeof(struct DmaEventFd));
+    ev.rxFd     = rxFd;
+    ev.txFd     = txFd;
+    ev.coalesce = coalesce;
+    return (ioctl(fd, DMA_Set_EventFd, &ev));
+}
+
 /**
  * dmaCheckVersion - Check API version of the DMA driver.
  * @fd: File descriptor for the DMA device.
@@ -883,6 +2139,77 @@ static inline ssize_t dmaReadRegister(int32_t fd, uint64_t address, uint32_t* da
     return res;
 }
 
+/**
+ * dmaReadBlock - Read a contiguous register range.
+ * @fd: File descriptor for the DMA device.
+ * @address: Register address of the first word, 4 byte aligned.
+ * @data: Buffer receiving the data.
+ * @size: Size in bytes, a multiple of 4.
+ *
+ * Copies the range in bursts instead of one register call per word, for
+ * example to read out a histogram or waveform memory. On the memory map
+ * drivers use pread with the address as the file offset instead.
+ *
+ * Return: Number of bytes read, or negative on failure.
+ */
+static inline ssize_t dmaReadBlock(int32_t fd, uint64_t address, void* data, uint32_t size) {
+    struct DmaBlockData b;
+
+    memset(&b, 0, sizeof(struct DmaBlockData));
+    b.address = address;
+    b.data    = (uint64_t)data;//NOLINT
+    b.size    = size;
+    b.is32    = (sizeof(void*) == 4);
+
+    return (ioctl(fd, DMA_Read_Block, &b));
+}
+
+/**
+ * dmaWriteBlock - Write a contiguous register range.
+ * @fd: File descriptor for the DMA device.
+ * @address: Register address of the first word, 4 byte aligned.
+ * @data: Buffer holding the data.
+ * @size: Size in bytes, a multiple of 4.
+ *
+ * On the memory map drivers use pwrite with the address as the file
+ * offset instead.
+ *
+ * Return: Number of bytes written, or negative on failure.
+ */
+static inline ssize_t dmaWriteBlock(int32_t fd, uint64_t address, const void* data, uint32_t size) {
+    struct DmaBlockData b;
+
+    memset(&b, 0, sizeof(struct DmaBlockData));
+    b.address = address;
+    b.data    = (uint64_t)data;//NOLINT
+    b.size    = size;
+    b.is32    = (sizeof(void*) == 4);
+
+    return (ioctl(fd, DMA_Write_Block, &b));
+}
+
+/**
+ * dmaRegBatch - Execute a list of register operations in one call.
+ * @fd: File descriptor for the DMA device.
+ * @count: Number of operations, at most INT_MAX.
+ * @ops: Operations, executed in order, see struct DmaRegOp.
+ *
+ * Execution stops at the first failed operation, the status of each
+ * operation is returned in @ops together with the values read.
+ *
+ * Return: Number of operations completed, or negative on failure.
+ */
+static inline ssize_t dmaRegBatch(int32_t fd, uint32_t count, struct DmaRegOp* ops) {
+    struct DmaRegBatch b;
+
+    memset(&b, 0, sizeof(struct DmaRegBatch));
+    b.data  = (uint64_t)ops;//NOLINT
+    b.count = count;
+    b.is32  = (sizeof(void*) == 4);
+
+    return (ioctl(fd, DMA_Reg_Batch, &b));
+}
+
 /**
  * dmaMapRegister - Map a DMA register space to user space.
  * @fd: File descriptor for the DMA device.
@@ -911,6 +2238,60 @@ static inline void* dmaMapRegister(int32_t fd, off_t offset, uint32_t size) {
     return mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, intOffset);
 }
 
+/**
+ * dmaMapStats - Map the statistics page read-only to user space.
+ * @fd: File descriptor for the DMA device.
+ *
+ * The page follows the register space at DMA_STATS_OFFSET.
+ *
+ * Return: Pointer to the page, or NULL on failure.
+ */
+static inline const struct DmaStatsPage* dmaMapStats(int32_t fd) {
+    off_t offset;
+    void* ptr;
+
+    offset = (off_t)ioctl(fd, DMA_Get_Buff_Size, 0) * ioctl(fd, DMA_Get_Buff_Count, 0) + DMA_STATS_OFFSET;
+
+    ptr = mmap(0, sizeof(struct DmaStatsPage), PROT_READ, MAP_SHARED, fd, offset);
+    if (ptr == MAP_FAILED) return NULL;
+
+    return (const struct DmaStatsPage*)ptr;
+}
+
+/**
+ * dmaUnMapStats - Unmap the statistics page.
+ * @page: Pointer returned by dmaMapStats.
+ *
+ * Return: Always returns 0.
+ */
+static inline ssize_t dmaUnMapStats(const struct DmaStatsPage* page) {
+    munmap((void*)page, sizeof(struct DmaStatsPage));//NOLINT
+    return 0;
+}
+
+/**
+ * dmaReadStats - Copy a consistent snapshot of the statistics page.
+ * @page: Pointer returned by dmaMapStats.
+ * @stats: Structure receiving the snapshot.
+ *
+ * Retries while the driver updates the page.
+ *
+ * Return: 0 on success, -1 if the page layout is not supported.
+ */
+static inline ssize_t dmaReadStats(const struct DmaStatsPage* page, struct DmaStatsPage* stats) {
+    uint32_t seq;
+
+    if (page->version != DMA_STATS_VERSION) return -1;
+
+    do {
+        while ((seq = __atomic_load_n(&(page->seq), __ATOMIC_ACQUIRE)) & 1) {}
+        memcpy(stats, (const void*)page, sizeof(struct DmaStatsPage));//NOLINT
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&(page->seq), __ATOMIC_RELAXED) != seq);
+
+    return 0;
+}
+
 /**
  * dmaUnMapRegister - Unmap a DMA register space from user space.
  * @fd: File descriptor for the DMA device. (Unused in this function, but kept for symmetry with map function)
@@ -34,6 +34,10 @@
 #include <linux/of_address.h>
 #include <linux/of_irq.h>
 #include <linux/slab.h>
+#include <linux/delay.h>
+#include <linux/sched.h>
+#include <linux/sched/signal.h>
+#include <linux/percpu.h>
 
 /**
  * MODULE_NAME - "axi_memory_map"
@@ -77,12 +81,20 @@ struct MapDevice dev;
  */
 struct class *gCl = NULL;
 
+/**
+ * mapLast - Memory map last used on each CPU.
+ * Description:
+ *    Checked before the xarray lookup in Map_Find.
+ */
+DEFINE_PER_CPU(struct MemMap *, mapLast);
+
 /**
  * struct file_operations MapFunctions - Define interface routines.
  * @read: Function pointer to the device read routine.
  * @write: Function pointer to the device write routine.
  * @open: Function pointer to the device open routine.
  * @release: Function pointer to the device release routine.
+ * @llseek: Function pointer to the device seek routine, the offset is the address.
  * @unlocked_ioctl: Function pointer to the device ioctl routine.
  * @compat_ioctl: Function pointer to the device ioctl routine (compat layer).
  *
@@ -94,6 +106,7 @@ struct file_operations MapFunctions = {
    .write          = Map_Write,
    .open           = Map_Open,
    .release        = Map_Release,
+   .llseek         = default_llseek,
    .unlocked_ioctl = (void *)Map_Ioctl,
    .compat_ioctl   = (void *)Map_Ioctl,
 };
@@ -131,8 +144,7 @@ char *Map_DevNode(const struct device *dev, umode_t *mode) {
  * 5. Creating a device file for the device class.
  * 6. Initializing the character device with the device's file operations.
  * 7. Adding the character device to the system, making it active.
- * 8. Allocating an initial memory map for the device to use.
- * 9. Mapping the initial memory space for the device's operations.
+ * 8. Mapping the initial memory space for the device's operations.
  *
  * Each step checks for errors, and if an error occurs, the function will
  * clean up any allocated resources and return an error code.
@@ -144,6 +156,8 @@ int Map_Init(void) {
 
    // Step 1: Zero out the device structure
    memset(&dev, 0, sizeof(struct MapDevice));
+   xa_init(&dev.windows);
+   mutex_init(&dev.mapLock);
 
    // Step 2: Set the device name
    if (strscpy(dev.devName, MOD_NAME, sizeof(dev.devName)) < 0) {
@@ -193,31 +207,17 @@ int Map_Init(void) {
       return -1;
    }
 
-   // Step 8: Allocate initial memory map
-   dev.maps = (struct MemMap *)kzalloc(sizeof(struct MemMap), GFP_KERNEL);
-   if (dev.maps == NULL) {
-      pr_err("%s: Init: Could not allocate map memory\n", MOD_NAME);
+   // Step 8: Map initial memory space
+   mutex_lock(&dev.mapLock);
+   if (Map_Alloc(plMinAddr) == NULL) {
+      mutex_unlock(&dev.mapLock);
       cdev_del(&dev.charDev);  // Clean up on failure
       device_destroy(gCl, dev.devNum);
       class_destroy(gCl);
       unregister_chrdev_region(dev.devNum, 1);
       return -1;
    }
-   dev.maps->addr = plMinAddr;
-   dev.maps->next = NULL;
-
-   // Step 9: Map initial memory space
-   dev.maps->base = ioremap_wc(dev.maps->addr, MAP_SIZE);
-   if (!dev.maps->base) {
-      pr_err("%s: Init: Could not map memory addr 0x%llx with size 0x%x.\n", MOD_NAME, (uint64_t)dev.maps->addr, MAP_SIZE);
-      kfree(dev.maps);  // Clean up on failure
-      cdev_del(&dev.charDev);
-      device_destroy(gCl, dev.devNum);
-      class_destroy(gCl);
-      unregister_chrdev_region(dev.devNum, 1);
-      return -1;
-   }
-   pr_info("%s: Init: Mapped addr 0x%llx with size 0x%x to 0x%llx.\n", MOD_NAME, (uint64_t)dev.maps->addr, MAP_SIZE, (uint64_t)dev.maps->base);
+   mutex_unlock(&dev.mapLock);
 
    return 0;
 }
@@ -230,6 +230,7 @@ int Map_Init(void) {
  * - Unregisters the device driver, releasing the device number.
  * - Iterates through the linked list of memory maps, unmaps each memory region
  *   from the device's address space, and frees the associated memory.
+ * - Releases the xarray index of the memory maps.
  * - Destroys the device class if it has been created.
  * - Logs the successful cleanup of the module.
  */
@@ -247,6 +248,7 @@ void Map_Exit(void) {
       kfree(tmp);
       tmp = next;
    }
+   xa_destroy(&dev.windows);
 
    // Destroy the device class
    if (gCl != NULL) {
@@ -295,22 +297,70 @@ int Map_Release(struct inode *inode, struct file *filp) {
    return 0;
 }
 
+/**
+ * Map_Alloc - Map the memory space holding an address
+ * @addr: The address to map
+ *
+ * This function maps the MAP_SIZE aligned window holding the address and
+ * stores it in the xarray, where lockless readers in Map_Find can see it.
+ * The new map is also added to the cleanup list. The caller must hold
+ * dev.mapLock.
+ *
+ * Return: Pointer to the new memory map on success, NULL on failure.
+ */
+struct MemMap *Map_Alloc(uint64_t addr) {
+   struct MemMap *new;
+   int ret;
+
+   // Allocate and initialize new map structure
+   if ((new = (struct MemMap *)kzalloc(sizeof(struct MemMap), GFP_KERNEL)) == NULL) {
+      pr_err("%s: Map_Alloc: Could not allocate map memory\n", MOD_NAME);
+      return NULL;
+   }
+
+   new->addr = (addr / MAP_SIZE) * MAP_SIZE;  // Align to MAP_SIZE
+   new->base = ioremap_wc(new->addr, MAP_SIZE);  // Map physical address
+   if (!new->base) {
+      pr_err("%s: Map_Alloc: Could not map memory addr 0x%llx (0x%llx) with size 0x%x.\n",
+             MOD_NAME, (uint64_t)new->addr, (uint64_t)addr, MAP_SIZE);
+      kfree(new);
+      return NULL;
+   }
+
+   // Publish to readers
+   ret = xa_err(xa_store(&dev.windows, new->addr / MAP_SIZE, new, GFP_KERNEL));
+   if (ret) {
+      pr_err("%s: Map_Alloc: Could not index map addr 0x%llx, error %d.\n",
+             MOD_NAME, (uint64_t)new->addr, ret);
+      iounmap(new->base);
+      kfree(new);
+      return NULL;
+   }
+   pr_info("%s: Map_Alloc: Mapped addr 0x%llx with size 0x%x to 0x%llx.\n",
+           MOD_NAME, (uint64_t)new->addr, MAP_SIZE, (uint64_t)new->base);
+
+   // Add to cleanup list
+   new->next = dev.maps;
+   dev.maps = new;
+   return new;
+}
+
 /**
  * Map_Find - Locate or allocate memory map space for a given address
  * @addr: The address for which to find or allocate map space
  *
- * This function searches the existing memory maps for the address. If the address
- * is within the allowed ranges and not already mapped, it allocates a new memory map.
- * It ensures the address falls within predefined ranges before attempting to map,
- * returning NULL for addresses outside these ranges or on allocation failure.
+ * This function looks up the memory map holding the address. The map last
+ * used on the current CPU is checked first, then the xarray is searched
+ * under RCU without taking a lock. Maps are only freed when the module
+ * exits, so a map found this way stays valid. If the address is within the
+ * allowed ranges and not already mapped, a new map is created under
+ * dev.mapLock. Returns NULL for addresses outside these ranges or on
+ * allocation failure.
  *
  * Return: Pointer to the mapped address space on success, NULL on failure.
  */
 uint8_t *Map_Find(uint64_t addr) {
    struct MemMap *cur;
-   struct MemMap *new;
-
-   cur = dev.maps;
 
    // Validate address range
    if (((addr < psMinAddr) || (addr > psMaxAddr)) &&
@@ -321,39 +371,25 @@ uint8_t *Map_Find(uint64_t addr) {
       return (NULL);
    }
 
-   // Search for existing map or allocate new
-   while (cur != NULL) {
-      // If current map contains address, return offset within map
-      if ((addr >= cur->addr) && (addr < (cur->addr + MAP_SIZE)))
-         return ((uint8_t *)(cur->base + (addr - cur->addr)));
-
-      // If address is beyond current map, and no next map or next map is further, insert new
-      if ((cur->next == NULL) || (addr < ((struct MemMap *)cur->next)->addr)) {
-         // Allocate and initialize new map structure
-         if ((new = (struct MemMap *)kzalloc(sizeof(struct MemMap), GFP_KERNEL)) == NULL) {
-            pr_err("%s: Map_Find: Could not allocate map memory\n", MOD_NAME);
-            return NULL;
-         }
-
-         new->addr = (addr / MAP_SIZE) * MAP_SIZE;  // Align to MAP_SIZE
-         new->base = ioremap_wc(new->addr, MAP_SIZE);  // Map physical address
-         if (!new->base) {
-            pr_err("%s: Map_Find: Could not map memory addr 0x%llx (0x%llx) with size 0x%x.\n",
-                   MOD_NAME, (uint64_t)new->addr, (uint64_t)addr, MAP_SIZE);
-            kfree(new);
-            return (NULL);
-         }
-         pr_info("%s: Map_Find: Mapped addr 0x%llx with size 0x%x to 0x%llx.\n",
-                 MOD_NAME, (uint64_t)new->addr, MAP_SIZE, (uint64_t)new->base);
-
-         // Insert new map into list
-         new->next = cur->next;
-         cur->next = new;
-      }
-      cur = cur->next;
+   // Map last used on this CPU
+   cur = this_cpu_read(mapLast);
+   if ((cur != NULL) && ((addr - cur->addr) < MAP_SIZE))
+      return ((uint8_t *)(cur->base + (addr - cur->addr)));
+
+   // Lockless lookup, xa_load holds the RCU read lock
+   cur = xa_load(&dev.windows, addr / MAP_SIZE);
+
+   // Create the map, another caller may have created it first
+   if (cur == NULL) {
+      mutex_lock(&dev.mapLock);
+      if ((cur = xa_load(&dev.windows, addr / MAP_SIZE)) == NULL)
+         cur = Map_Alloc(addr);
+      mutex_unlock(&dev.mapLock);
+      if (cur == NULL) return (NULL);
    }
 
-   return (NULL);
+   this_cpu_write(mapLast, cur);
+   return ((uint8_t *)(cur->base + (addr - cur->addr)));
 }
 
 /**
@@ -419,6 +455,11 @@ ssize_t Map_Ioctl(struct file *filp, uint32_t cmd, unsigned long arg) {
          }
          break;
 
+      case DMA_Reg_Batch:
+         // Execute a list of register operations
+         ret = Map_RegBatch(arg);
+         break;
+
       default:
          // Unsupported IOCTL command
          pr_warn("%s: Map_Ioctl: Unsupported IOCTL command.\n", MOD_NAME);
@@ -427,6 +468,131 @@ ssize_t Map_Ioctl(struct file *filp, uint32_t cmd, unsigned long arg) {
    return ret;  // Return the result
 }
 
+/**
+ * Map_RegOp - Execute one operation of a register batch
+ * @op: The operation, the value read is returned in op->data
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
+int32_t Map_RegOp(struct DmaRegOp *op) {
+   uint8_t *base;
+   uint64_t end;
+   uint32_t val;
+
+   if ((base = Map_Find(op->address)) == NULL) return -EFAULT;
+
+   switch (op->op) {
+      case DMA_REG_READ:
+         op->data = readl(base);
+         return 0;
+
+      case DMA_REG_WRITE:
+         writel(op->data, base);
+         return 0;
+
+      case DMA_REG_RMW:
+         val = readl(base);
+         writel((val & ~op->mask) | (op->data & op->mask), base);
+         op->data = val;
+         return 0;
+
+      case DMA_REG_POLL:
+         if (op->timeout > DMA_REG_POLL_MAX) return -EINVAL;
+         end = ktime_get_ns() + (uint64_t)op->timeout * NSEC_PER_USEC;
+
+         while (((val = readl(base)) & op->mask) != (op->data & op->mask)) {
+            if (ktime_get_ns() >= end) {
+               op->data = val;
+               return -ETIMEDOUT;
+            }
+            if (fatal_signal_pending(current)) return -EINTR;
+            if (op->timeout > MAP_REG_SPIN) usleep_range(10, 20);
+            else udelay(1);
+         }
+         op->data = val;
+         return 0;
+
+      default:
+         return -EINVAL;
+   }
+}
+
+/**
+ * Map_RegBatch - Execute a list of register operations
+ * @arg: User space pointer to a DmaRegBatch structure
+ *
+ * The operations are copied in steps of MAP_REG_BATCH and executed in order.
+ * The status and read value of each operation are copied back in place.
+ * Operations after a failed one are not executed and return -ECANCELED.
+ * The batch stops between steps when the process is killed.
+ *
+ * Return: Number of operations completed, negative on failure.
+ */
+ssize_t Map_RegBatch(unsigned long arg) {
+   struct DmaRegBatch req;
+   struct DmaRegOp *ops;
+   uint64_t data;
+   uint32_t done;
+   uint32_t ok;
+   uint32_t cnt;
+   uint32_t x;
+   int32_t status;
+
+   if (copy_from_user(&req, (void *)arg, sizeof(struct DmaRegBatch))) {
+      pr_warn("%s: Map_RegBatch: copy_from_user failed.\n", MOD_NAME);
+      return -1;
+   }
+
+   if (req.count == 0) return 0;
+   if (req.count > INT_MAX) return -EINVAL;
+
+   // Convert pointer based on architecture
+   data = (sizeof(void *) == 4 || req.is32) ? (req.data & 0xFFFFFFFF) : req.data;
+
+   cnt = (req.count < MAP_REG_BATCH) ? req.count : MAP_REG_BATCH;
+   if ((ops = (struct DmaRegOp *)kmalloc(cnt * sizeof(struct DmaRegOp), GFP_KERNEL)) == NULL)
+      return -ENOMEM;
+
+   status = 0;
+   ok     = 0;
+
+   for (done = 0; done < req.count; done += cnt) {
+      cnt = ((req.count - done) < MAP_REG_BATCH) ? (req.count - done) : MAP_REG_BATCH;
+
+      // Stop when the process is killed, earlier steps are already returned
+      if (fatal_signal_pending(current)) {
+         kfree(ops);
+         return -EINTR;
+      }
+
+      if (copy_from_user(ops, (void *)(data + done * sizeof(struct DmaRegOp)), cnt * sizeof(struct DmaRegOp))) {
+         pr_warn("%s: Map_RegBatch: copy_from_user failed.\n", MOD_NAME);
+         kfree(ops);
+         return -1;
+      }
+
+      for (x = 0; x < cnt; x++) {
+         if (status == 0) {
+            status = Map_RegOp(&(ops[x]));
+            ops[x].status = status;
+            if (status == 0) ok++;
+         } else {
+            ops[x].status = -ECANCELED;
+         }
+      }
+
+      if (copy_to_user((void *)(data + done * sizeof(struct DmaRegOp)), ops, cnt * sizeof(struct DmaRegOp))) {
+         pr_warn("%s: Map_RegBatch: copy_to_user failed.\n", MOD_NAME);
+         kfree(ops);
+         return -1;
+      }
+      cond_resched();
+   }
+
+   kfree(ops);
+   return ok;
+}
+
 /**
  * Map_Read - Read operation for AXI memory map device
  * @filp: file pointer to the opened device file
@@ -434,18 +600,14 @@ ssize_t Map_Ioctl(struct file *filp, uint32_t cmd, unsigned long arg) {
  * @count: number of bytes to read
  * @f_pos: offset in the file
  *
- * This function is called when a read operation is performed on the AXI memory map device file.
- * In the current implementation, reading directly from the device is not supported. This could be
- * due to the nature of the device or specific security or operational considerations.
+ * Reads the address range starting at the file offset, which is the bus
+ * address, for example with pread. The address and size must be 4 byte
+ * aligned.
  *
- * The function returns an error code to indicate that the operation is not permitted. Future
- * implementations could modify this behavior to support read operations, depending on the
- * requirements and capabilities of the hardware.
- *
- * Return: Returns -1 to indicate that the read operation is not supported.
+ * Return: Number of bytes read, or a negative error code on failure.
  */
 ssize_t Map_Read(struct file *filp, char *buffer, size_t count, loff_t *f_pos) {
-   return -1;  // DMA read operation is not supported
+   return Map_Block(buffer, count, f_pos, 0);
 }
 
 /**
@@ -455,20 +617,79 @@ ssize_t Map_Read(struct file *filp, char *buffer, size_t count, loff_t *f_pos) {
  * @count: Number of bytes to write
  * @f_pos: Offset into the device
  *
- * This function is called when a user space application attempts to write
- * data to the AXI memory map device. It translates the user space buffer
- * address to a kernel space address, finds the appropriate memory mapped
- * region, and writes the provided data into this memory region.
- *
- * Currently, this function is not implemented and simply returns -1. To
- * support write operations, one would need to validate input parameters,
- * copy data from user space to kernel space, and perform the necessary
- * memory writes to the mapped device.
+ * Writes the address range starting at the file offset, which is the bus
+ * address, for example with pwrite. The address and size must be 4 byte
+ * aligned.
  *
  * Return: On success, the number of bytes written. On error, a negative value.
  */
 ssize_t Map_Write(struct file *filp, const char* buffer, size_t count, loff_t* f_pos) {
-   return -1;  // DMA write operation is not supported
+   return Map_Block((char *)buffer, count, f_pos, 1);
+}
+
+/**
+ * Map_Block - Copy an address range to or from user space
+ * @buffer: User space buffer
+ * @count: Number of bytes to copy
+ * @f_pos: Bus address of the first word, advanced by the bytes copied
+ * @write: Non-zero to write the range, zero to read it
+ *
+ * The whole range must lie within either the PS or the PL address range.
+ * It is copied through a bounce buffer with memcpy_fromio and memcpy_toio
+ * in steps of at most MAP_BLOCK_SIZE bytes which do not cross a map
+ * window, letting the bus burst.
+ *
+ * Return: Number of bytes copied, fewer than @count when a later step
+ *         fails, or a negative error code if nothing was copied.
+ */
+ssize_t Map_Block(char *buffer, size_t count, loff_t *f_pos, uint32_t write) {
+   uint8_t *buff;
+   uint8_t *base;
+   uint64_t addr;
+   size_t done;
+   size_t cnt;
+
+   addr = *f_pos;
+
+   // Word aligned transfers only
+   if (((addr | count) & 0x3) != 0) return -EINVAL;
+   if (count == 0) return 0;
+
+   // The whole range must lie in one of the allowed ranges
+   if ((addr + count) < addr) return -EFAULT;
+   if (((addr < psMinAddr) || ((addr + count - 1) > psMaxAddr)) &&
+       ((addr < plMinAddr) || ((addr + count - 1) > plMaxAddr))) {
+      pr_err("%s: Map_Block: Invalid range 0x%llx - 0x%llx\n",
+             MOD_NAME, (uint64_t)addr, (uint64_t)(addr + count - 1));
+      return -EFAULT;
+   }
+
+   if ((buff = (uint8_t *)kmalloc(MAP_BLOCK_SIZE, GFP_KERNEL)) == NULL) return -ENOMEM;
+
+   for (done = 0; done < count; done += cnt) {
+      // Limit the step to the bounce buffer and the map window
+      cnt = count - done;
+      if (cnt > MAP_BLOCK_SIZE) cnt = MAP_BLOCK_SIZE;
+      if (cnt > (MAP_SIZE - ((addr + done) % MAP_SIZE))) cnt = MAP_SIZE - ((addr + done) % MAP_SIZE);
+
+      if ((base = Map_Find(addr + done)) == NULL) break;
+
+      if (write) {
+         if (copy_from_user(buff, buffer + done, cnt)) break;
+         memcpy_toio(base, buff, cnt);
+      } else {
+         memcpy_fromio(buff, base, cnt);
+         if (copy_to_user(buffer + done, buff, cnt)) break;
+      }
+      cond_resched();
+   }
+
+   kfree(buff);
+
+   // Report a partial transfer, the failure only when nothing was copied
+   if (done == 0) return -EFAULT;
+   *f_pos += done;
+   return done;
 }
 
 /**
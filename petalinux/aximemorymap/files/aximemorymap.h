@@ -30,11 +30,22 @@
 #include <linux/cdev.h>
 #include <linux/fs.h>
 #include <linux/version.h>
+#include <linux/mutex.h>
+#include <linux/xarray.h>
 #include <DmaDriver.h>
 
 // Defines the size of the map, set to 64K.
 #define MAP_SIZE 0x10000
 
+// Register operations copied from user space per step of a batch.
+#define MAP_REG_BATCH 256
+
+// Longest poll timeout in us which spins instead of sleeping between reads.
+#define MAP_REG_SPIN 100
+
+// Bounce buffer size of read and write.
+#define MAP_BLOCK_SIZE 4096
+
 /**
  * struct MemMap - Represents a single memory mapping.
  * @addr: Physical address of the mapping.
@@ -42,6 +53,7 @@
  * @next: Pointer to the next memory map structure.
  *
  * This structure is used to keep track of individual memory mappings.
+ * Mappings are never removed while the module is loaded.
  */
 struct MemMap {
    uint64_t addr;
@@ -56,7 +68,9 @@ struct MemMap {
  * @devName: Name of the device.
  * @charDev: Character device structure.
  * @device: Device structure.
- * @maps: Pointer to the first memory map structure.
+ * @maps: Pointer to the first memory map structure, used for cleanup.
+ * @windows: Memory maps indexed by addr / MAP_SIZE, read under RCU.
+ * @mapLock: Serializes the creation of memory maps.
  *
  * This structure represents a memory mapping device, including its
  * character device representation and list of memory mappings.
@@ -68,6 +82,8 @@ struct MapDevice {
    struct cdev charDev;
    struct device *device;
    struct MemMap *maps;
+   struct xarray windows;
+   struct mutex mapLock;
 };
 
 // Function prototypes for device operations.
@@ -82,7 +98,11 @@ int Map_Open(struct inode *inode, struct file *filp);
 int Map_Release(struct inode *inode, struct file *filp);
 ssize_t Map_Read(struct file *filp, char *buffer, size_t count, loff_t *f_pos);
 ssize_t Map_Write(struct file *filp, const char *buffer, size_t count, loff_t *f_pos);
+struct MemMap *Map_Alloc(uint64_t addr);
 uint8_t *Map_Find(uint64_t addr);
 ssize_t Map_Ioctl(struct file *filp, uint32_t cmd, unsigned long arg);
+int32_t Map_RegOp(struct DmaRegOp *op);
+ssize_t Map_RegBatch(unsigned long arg);
+ssize_t Map_Block(char *buffer, size_t count, loff_t *f_pos, uint32_t write);
 
 #endif  // __AXI_MEMORY_MAP_H__
@@ -0,0 +1 @@
+../../../common/driver/dma_trace.h
\ No newline at end of file
@@ -28,6 +28,13 @@
 #include <linux/of_irq.h>
 #include <linux/slab.h>
 #include <linux/version.h>
+#include <linux/delay.h>
+#include <linux/sched.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 11, 0)
+#include <linux/sched/signal.h>
+#endif
+#include <linux/percpu.h>
+#include <linux/rcupdate.h>
 
 // Module Name
 #define MOD_NAME "rce_memmap"
@@ -47,12 +54,16 @@ struct MapDevice dev;
 // Global variable for the device class
 struct class * gCl;
 
+// Last window hit on each CPU
+DEFINE_PER_CPU(struct MemMap *, mapLast);
+
 // Define interface routines
 struct file_operations MapFunctions = {
    .read           = Map_Read,
    .write          = Map_Write,
    .open           = Map_Open,
    .release        = Map_Release,
+   .llseek         = default_llseek,
    .unlocked_ioctl = (void *)Map_Ioctl,
    .compat_ioctl   = (void *)Map_Ioctl,
 };
@@ -68,6 +79,8 @@ int Map_Init(void) {
    int32_t res;
 
    memset(&dev, 0, sizeof(struct MapDevice));
+   INIT_RADIX_TREE(&(dev.tree), GFP_KERNEL);
+   mutex_init(&(dev.mapLock));
 
    strcpy(dev.devName,MOD_NAME);//NOLINT
 
@@ -105,29 +118,12 @@ int Map_Init(void) {
    }
 
    // Map initial space
-   if ( (dev.maps = (struct MemMap *)kmalloc(sizeof(struct MemMap), GFP_KERNEL)) == NULL ) {
-      printk(KERN_ERR MOD_NAME " Init: Could not allocate map memory\n");
-      return (-1);
-   }
-   dev.maps->addr = cfgMinAddr;
-   dev.maps->next = NULL;
-
-   // Map space
-   dev.maps->base = ioremap_wc(dev.maps->addr, MAP_SIZE);
-   if (!dev.maps->base) {
-      printk(KERN_ERR MOD_NAME " Init: Could not map memory addr %p with size 0x%x.\n", (void *)dev.maps->addr, MAP_SIZE);
-      kfree(dev.maps);
-      return (-1);
+   mutex_lock(&(dev.mapLock));
+   if ( Map_Alloc(cfgMinAddr) == NULL ) {
+      mutex_unlock(&(dev.mapLock));
+      return(-1);
    }
-   printk(KERN_INFO MOD_NAME " Init: Mapped addr %p with size 0x%x to %p.\n", (void *)dev.maps->addr, MAP_SIZE, (void *)dev.maps->base);
-
-   // Hold memory region
-//   if ( request_mem_region(dev.maps->addr, MAP_SIZE, dev.devName) == NULL ) {
-//      printk(KERN_ERR MOD_NAME " Map_Find: Memory in use.\n");
-//      iounmap(dev.maps->base);
-//      kfree(dev.maps);
-//      return (-1);
-//   }
+   mutex_unlock(&(dev.mapLock));
 
    return(0);
 }
@@ -151,6 +147,7 @@ void Map_Exit(void) {
       dev.maps = dev.maps->next;
 
       // release_mem_region(tmp->addr, MAP_SIZE);
+      radix_tree_delete(&(dev.tree), tmp->addr / MAP_SIZE);
       iounmap(tmp->base);
       kfree(tmp);
    }
@@ -172,59 +169,79 @@ int Map_Release(struct inode *inode, struct file *filp) {
    return 0;
 }
 
+// Map the window holding addr and add it to the tree, called with mapLock held
+struct MemMap * Map_Alloc(uint32_t addr) {
+   struct MemMap *new;
+
+   // Create new map
+   if ( (new = (struct MemMap *)kmalloc(sizeof(struct MemMap), GFP_KERNEL)) == NULL ) {
+      printk(KERN_ERR MOD_NAME " Map_Alloc: Could not allocate map memory\n");
+      return(NULL);
+   }
+
+   // Compute new base
+   new->addr = (addr / MAP_SIZE) * MAP_SIZE;
+
+   // Map space
+   new->base = ioremap_wc(new->addr, MAP_SIZE);
+   if (!new->base) {
+      printk(KERN_ERR MOD_NAME " Map_Alloc: Could not map memory addr %p (%p) with size 0x%x.\n", (void *)new->addr, (void*)addr, MAP_SIZE);
+      kfree(new);
+      return(NULL);
+   }
+
+   // Hold memory region
+//   if ( request_mem_region(new->addr, MAP_SIZE, dev.devName) == NULL ) {
+//      printk(KERN_ERR MOD_NAME " Map_Alloc: Memory in use.\n");
+//      iounmap(new->base);
+//      kfree(new);
+//      return(NULL);
+//   }
+
+   // Publish to lockless readers
+   if ( radix_tree_insert(&(dev.tree), new->addr / MAP_SIZE, new) != 0 ) {
+      printk(KERN_ERR MOD_NAME " Map_Alloc: Could not insert map addr %p.\n", (void *)new->addr);
+      iounmap(new->base);
+      kfree(new);
+      return(NULL);
+   }
+   printk(KERN_INFO MOD_NAME " Map_Alloc: Mapped addr %p with size 0x%x to %p.\n", (void *)new->addr, MAP_SIZE, (void *)new->base);
+
+   // Add to cleanup list
+   new->next = dev.maps;
+   dev.maps = new;
+   return(new);
+}
+
 // Find or allocate map space
 uint8_t * Map_Find(uint32_t addr) {
    struct MemMap *cur;
-   struct MemMap *new;
-
-   cur = dev.maps;
 
    if ( (addr < cfgMinAddr) || (addr > cfgMaxAddr) ) {
       printk(KERN_ERR MOD_NAME " Map_Find: Invalid address %p. Allowed range %p - %p\n", (void *)addr, (void *)cfgMinAddr, (void*)cfgMaxAddr);
       return (NULL);
    }
 
-   while (cur != NULL) {
-      // Current pointer matches
-      if ( (addr >= cur->addr) && (addr < (cur->addr + MAP_SIZE)) )
-         return((uint8_t*)(cur->base + (addr-cur->addr)));
-
-      // Next address is too high, insert new structure
-      if ( (cur->next == NULL) || (addr < ((struct MemMap *)cur->next)->addr) ) {
-         // Create new map
-         if ( (new = (struct MemMap *)kmalloc(sizeof(struct MemMap), GFP_KERNEL)) == NULL ) {
-            printk(KERN_ERR MOD_NAME " Map_Find: Could not allocate map memory\n");
-            return NULL;
-         }
-
-         // Compute new base
-         new->addr = (addr / MAP_SIZE) * MAP_SIZE;
-
-         // Map space
-         new->base = ioremap_wc(new->addr, MAP_SIZE);
-         if (!new->base) {
-            printk(KERN_ERR MOD_NAME " Map_Find: Could not map memory addr %p (%p) with size 0x%x.\n", (void *)new->addr, (void*)addr, MAP_SIZE);
-            kfree(new);
-            return (NULL);
-         }
-         printk(KERN_INFO MOD_NAME " Map_Find: Mapped addr %p with size 0x%x to %p.\n", (void *)new->addr, MAP_SIZE, (void *)new->base);
-
-         // Hold memory region
-//         if ( request_mem_region(new->addr, MAP_SIZE, dev.devName) == NULL ) {
-//            printk(KERN_ERR MOD_NAME " Map_Find: Memory in use.\n");
-//            iounmap(cur->base);
-//            kfree(new);
-//            return (NULL);
-//         }
-
-         // Insert into list
-         new->next = cur->next;
-         cur->next = new;
-      }
-      cur = cur->next;
+   // Window last used on this CPU
+   cur = this_cpu_read(mapLast);
+   if ( (cur != NULL) && ((uint32_t)(addr - cur->addr) < MAP_SIZE) )
+      return((uint8_t*)(cur->base + (addr-cur->addr)));
+
+   // Windows are only freed at module exit, so the entry stays valid after the read section
+   rcu_read_lock();
+   cur = radix_tree_lookup(&(dev.tree), addr / MAP_SIZE);
+   rcu_read_unlock();
+
+   // Create the window, another caller may have created it first
+   if ( cur == NULL ) {
+      mutex_lock(&(dev.mapLock));
+      if ( (cur = radix_tree_lookup(&(dev.tree), addr / MAP_SIZE)) == NULL ) cur = Map_Alloc(addr);
+      mutex_unlock(&(dev.mapLock));
+      if ( cur == NULL ) return(NULL);
    }
 
-   return(NULL);
+   this_cpu_write(mapLast, cur);
+   return((uint8_t*)(cur->base + (addr-cur->addr)));
 }
 
 // Perform commands
@@ -273,20 +290,184 @@ ssize_t Map_Ioctl(struct file *filp, uint32_t cmd, unsigned long arg) {
          return(0);
          break;
 
+      // List of register operations
+      case DMA_Reg_Batch:
+         return(Map_RegBatch(arg));
+         break;
+
       default:
          break;
    }
    return(-1);
 }
 
-// Read not supported
+// Execute one operation of a register batch, the value read is returned in op->data
+int32_t Map_RegOp(struct DmaRegOp *op) {
+   uint8_t *base;
+   uint64_t end;
+   uint32_t val;
+
+   // Map_Find takes a 32-bit address, a truncated one could hit another register
+   if ( op->address > 0xFFFFFFFF ) return(-EFAULT);
+   if ( (base = Map_Find(op->address)) == NULL ) return(-EFAULT);
+
+   switch (op->op) {
+      case DMA_REG_READ:
+         op->data = ioread32(base);
+         return(0);
+         break;
+
+      case DMA_REG_WRITE:
+         iowrite32(op->data, base);
+         return(0);
+         break;
+
+      case DMA_REG_RMW:
+         val = ioread32(base);
+         iowrite32((val & ~op->mask) | (op->data & op->mask), base);
+         op->data = val;
+         return(0);
+         break;
+
+      case DMA_REG_POLL:
+         if ( op->timeout > DMA_REG_POLL_MAX ) return(-EINVAL);
+         end = ktime_get_ns() + (uint64_t)op->timeout * NSEC_PER_USEC;
+
+         while ( ((val = ioread32(base)) & op->mask) != (op->data & op->mask) ) {
+            if ( ktime_get_ns() >= end ) {
+               op->data = val;
+               return(-ETIMEDOUT);
+            }
+            if ( fatal_signal_pending(current) ) return(-EINTR);
+            if ( op->timeout > MAP_REG_SPIN ) usleep_range(10, 20);
+            else udelay(1);
+         }
+         op->data = val;
+         return(0);
+         break;
+
+      default:
+         return(-EINVAL);
+         break;
+   }
+}
+
+// Execute a list of register operations in order, stopping at the first failure
+ssize_t Map_RegBatch(unsigned long arg) {
+   struct DmaRegBatch req;
+   struct DmaRegOp *ops;
+   uint64_t data;
+   uint32_t done;
+   uint32_t ok;
+   uint32_t cnt;
+   uint32_t x;
+   int32_t status;
+   ssize_t ret;
+
+   if ((ret = copy_from_user(&req, (void *)arg, sizeof(struct DmaRegBatch)))) {
+      printk(KERN_WARNING MOD_NAME " Map_RegBatch: copy_from_user failed. ret=%i, user=%p kern=%p\n", ret, (void *)arg, &req);
+      return(-1);
+   }
+
+   if ( req.count == 0 ) return(0);
+   if ( req.count > INT_MAX ) return(-EINVAL);
+
+   // Convert pointer based on architecture
+   data = (sizeof(void *) == 4 || req.is32) ? (req.data & 0xFFFFFFFF) : req.data;
+
+   cnt = (req.count < MAP_REG_BATCH) ? req.count : MAP_REG_BATCH;
+   if ( (ops = (struct DmaRegOp *)kmalloc(cnt * sizeof(struct DmaRegOp), GFP_KERNEL)) == NULL ) return(-ENOMEM);
+
+   status = 0;
+   ok     = 0;
+
+   for (done = 0; done < req.count; done += cnt) {
+      cnt = ((req.count - done) < MAP_REG_BATCH) ? (req.count - done) : MAP_REG_BATCH;
+
+      // Stop when killed, earlier steps are already returned
+      if ( fatal_signal_pending(current) ) {
+         kfree(ops);
+         return(-EINTR);
+      }
+
+      if ( copy_from_user(ops, (void *)(data + done * sizeof(struct DmaRegOp)), cnt * sizeof(struct DmaRegOp)) ) {
+         printk(KERN_WARNING MOD_NAME " Map_RegBatch: copy_from_user failed.\n");
+         kfree(ops);
+         return(-1);
+      }
+
+      // Operations after a failed one are not executed
+      for (x = 0; x < cnt; x++) {
+         if ( status == 0 ) {
+            status = Map_RegOp(&(ops[x]));
+            ops[x].status = status;
+            if ( status == 0 ) ok++;
+         } else {
+            ops[x].status = -ECANCELED;
+         }
+      }
+
+      if ( copy_to_user((void *)(data + done * sizeof(struct DmaRegOp)), ops, cnt * sizeof(struct DmaRegOp)) ) {
+         printk(KERN_WARNING MOD_NAME " Map_RegBatch: copy_to_user failed.\n");
+         kfree(ops);
+         return(-1);
+      }
+      cond_resched();
+   }
+
+   kfree(ops);
+   return(ok);
+}
+
+// Read a word aligned address range, the file offset is the address
 ssize_t Map_Read(struct file *filp, char *buffer, size_t count, loff_t *f_pos) {
-   return -1;
+   return(Map_Block(buffer, count, f_pos, 0));
 }
 
-// Dma_Write
+// Write a word aligned address range, the file offset is the address
 ssize_t Map_Write(struct file *filp, const char* buffer, size_t count, loff_t* f_pos) {
-   return -1;
+   return(Map_Block((char *)buffer, count, f_pos, 1));
+}
+
+// Copy an address range through a bounce buffer, one map window at a time
+ssize_t Map_Block(char *buffer, size_t count, loff_t *f_pos, uint32_t write) {
+   uint8_t *buff;
+   uint8_t *base;
+   uint64_t addr;
+   size_t   done;
+   size_t   cnt;
+
+   addr = *f_pos;
+
+   if ( ((addr | count) & 0x3) != 0 ) return(-EINVAL);
+   if ( count == 0 ) return(0);
+   if ( (addr < cfgMinAddr) || ((addr + count - 1) > cfgMaxAddr) ) return(-EFAULT);
+
+   if ( (buff = (uint8_t *)kmalloc(MAP_BLOCK_SIZE, GFP_KERNEL)) == NULL ) return(-ENOMEM);
+
+   for (done = 0; done < count; done += cnt) {
+      cnt = count - done;
+      if ( cnt > MAP_BLOCK_SIZE ) cnt = MAP_BLOCK_SIZE;
+      if ( cnt > (MAP_SIZE - ((addr + done) % MAP_SIZE)) ) cnt = MAP_SIZE - ((addr + done) % MAP_SIZE);
+
+      if ( (base = Map_Find(addr + done)) == NULL ) break;
+
+      if ( write ) {
+         if ( copy_from_user(buff, buffer + done, cnt) ) break;
+         memcpy_toio(base, buff, cnt);
+      } else {
+         memcpy_fromio(buff, base, cnt);
+         if ( copy_to_user(buffer + done, buff, cnt) ) break;
+      }
+      cond_resched();
+   }
+
+   kfree(buff);
+
+   // Report a partial transfer, the failure only when nothing was copied
+   if ( done == 0 ) return(-EFAULT);
+   *f_pos += done;
+   return(done);
 }
 
 module_param(cfgMinAddr, uint, 0);
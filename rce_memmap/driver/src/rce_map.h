@@ -23,12 +23,23 @@
 #include <linux/poll.h>
 #include <linux/cdev.h>
 #include <linux/fs.h>
+#include <linux/mutex.h>
+#include <linux/radix-tree.h>
 #include <DmaDriver.h>
 
 // Map size, 64K
 #define MAP_SIZE     0x10000
 
-// Memory map
+// Register operations copied per step of a batch
+#define MAP_REG_BATCH 256
+
+// Longest poll timeout in us which spins instead of sleeping
+#define MAP_REG_SPIN  100
+
+// Bounce buffer size of read and write
+#define MAP_BLOCK_SIZE 4096
+
+// Memory map, windows are not removed until the module exits
 struct MemMap {
    uint32_t    addr;
    uint8_t *   base;
@@ -43,7 +54,15 @@ struct MapDevice {
    char            devName[50];
    struct cdev     charDev;
    struct device * device;
+
+   // List of all windows, used for cleanup
    struct MemMap * maps;
+
+   // Windows indexed by addr / MAP_SIZE, lookups under RCU
+   struct radix_tree_root tree;
+
+   // Serializes window creation
+   struct mutex    mapLock;
 };
 
 char *Map_DevNode(struct device *dev, umode_t *mode);
@@ -60,9 +79,17 @@ ssize_t Map_Read(struct file *filp, char *buffer, size_t count, loff_t *f_pos);
 
 ssize_t Map_Write(struct file *filp, const char* buffer, size_t count, loff_t* f_pos);
 
+struct MemMap * Map_Alloc(uint32_t addr);
+
 uint8_t * Map_Find(uint32_t addr);
 
 ssize_t Map_Ioctl(struct file *filp, uint32_t cmd, unsigned long arg);
 
+int32_t Map_RegOp(struct DmaRegOp *op);
+
+ssize_t Map_RegBatch(unsigned long arg);
+
+ssize_t Map_Block(char *buffer, size_t count, loff_t *f_pos, uint32_t write);
+
 #endif
 
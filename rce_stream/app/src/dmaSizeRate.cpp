@@ -0,0 +1,224 @@
+/**
+ *-----------------------------------------------------------------------------
+ * Company    : SLAC National Accelerator Laboratory
+ *-----------------------------------------------------------------------------
+ * Description:
+ * Measures the loopback frame rate for a range of frame sizes. Frames are
+ * written to a destination looped back by the firmware and read back using
+ * index based buffers. The small frame rate on non-coherent platforms is
+ * dominated by cache maintenance of the buffers. With --ext the frames are
+ * read as extended records, showing the cost of the receive timestamps and
+ * the mean latency from harvest to queue and from queue to read.
+ * ----------------------------------------------------------------------------
+ * This file is part of the aes_stream_drivers package. It is subject to
+ * the license terms in the LICENSE.txt file found in the top-level directory
+ * of this distribution and at:
+ *    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+ * No part of the aes_stream_drivers package, including this file, may be
+ * copied, modified, propagated, or distributed except according to the terms
+ * contained in the LICENSE.txt file.
+ * ----------------------------------------------------------------------------
+**/
+
+#include <sys/types.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <argp.h>
+#include <iostream>
+#include <cstdio>
+
+#include <AxisDriver.h>
+
+using std::cout;
+using std::endl;
+
+#define MAX_RET_CNT_C 1000
+
+const  char * argp_program_version = "dmaSizeRate 1.0";
+const  char * argp_program_bug_address = "rherbst@slac.stanford.edu";
+
+struct PrgArgs {
+   const char * path;
+   uint32_t     dest;
+   uint32_t     minSize;
+   uint32_t     maxSize;
+   uint32_t     count;
+   uint32_t     ext;
+};
+
+static struct PrgArgs DefArgs = { "/dev/axi_stream_dma_0", 0, 64, 0, 100000, 0 };
+
+static char   args_doc[] = "dest";
+static char   doc[]      = "   Destination is passed as an integer and must be looped back by the firmware.";
+
+static struct argp_option options[] = {
+   { "path",  'p', "PATH",  OPTION_ARG_OPTIONAL, "Path of AXI stream to use. Default=/dev/axi_stream_dma_0.", 0},
+   { "min",   'n', "SIZE",  OPTION_ARG_OPTIONAL, "Smallest frame size. Default=64", 0},
+   { "max",   'x', "SIZE",  OPTION_ARG_OPTIONAL, "Largest frame size. Default=buffer size", 0},
+   { "count", 'c', "COUNT", OPTION_ARG_OPTIONAL, "Frames per size. Default=100000", 0},
+   { "ext",   'e', 0,       0,                   "Read extended records with receive timestamps.", 0},
+   {0}
+};
+
+error_t parseArgs(int key,  char *arg, struct argp_state *state) {
+   struct PrgArgs *args = (struct PrgArgs *)state->input;
+
+   switch (key) {
+      case 'p': args->path = arg; break;
+      case 'n': args->minSize = strtol(arg, NULL, 10); break;
+      case 'x': args->maxSize = strtol(arg, NULL, 10); break;
+      case 'c': args->count = strtol(arg, NULL, 10); break;
+      case 'e': args->ext = 1; break;
+      case ARGP_KEY_ARG:
+          switch (state->arg_num) {
+             case 0: args->dest = strtol(arg, NULL, 10); break;
+             default: argp_usage(state); break;
+          }
+          break;
+      case ARGP_KEY_END:
+          if ( state->arg_num < 1) argp_usage(state);
+          break;
+      default: return ARGP_ERR_UNKNOWN; break;
+   }
+   return(0);
+}
+
+static struct argp argp = {options, parseArgs, args_doc, doc};
+
+int main(int argc, char **argv) {
+   uint8_t       mask[DMA_MASK_SIZE];
+   int32_t       s;
+   int32_t       ret;
+   void **       dmaBuffers;
+   uint32_t      dmaSize;
+   uint32_t      dmaCount;
+   uint32_t      dmaIndex[MAX_RET_CNT_C];
+   int32_t       dmaRet[MAX_RET_CNT_C];
+   uint32_t      rxError[MAX_RET_CNT_C];
+   struct DmaReadDataExt rxExt[MAX_RET_CNT_C];
+   uint32_t      txIndex;
+   uint32_t      size;
+   uint32_t      txCount;
+   uint32_t      rxCount;
+   uint32_t      errCount;
+   int32_t       x;
+   double        duration;
+   double        toQueue;
+   double        toRead;
+   uint64_t      readNs;
+
+   struct timespec rTime;
+
+   struct timeval sTime;
+   struct timeval lTime;
+   struct timeval eTime;
+   struct timeval dTime;
+   struct PrgArgs args;
+
+   memcpy(&args, &DefArgs, sizeof(struct PrgArgs));
+   argp_parse(&argp, argc, argv, 0, 0, &args);
+
+   if ( (s = open(args.path, O_RDWR)) <= 0 ) {
+      printf("Error opening %s\n", args.path);
+      return(1);
+   }
+
+   if ( (dmaBuffers = dmaMapDma(s, &dmaCount, &dmaSize)) == NULL ) {
+      printf("Failed to map dma buffers!\n");
+      return(0);
+   }
+
+   dmaInitMaskBytes(mask);
+   dmaAddMaskBytes(mask, args.dest);
+
+   if ( dmaSetMaskBytes(s, mask) < 0 ) {
+      printf("Failed to reserve destination %i!\n", args.dest);
+      return(0);
+   }
+
+   if ( args.ext && (dmaSetReadExt(s, 1) < 0) ) {
+      printf("Failed to enable extended read records!\n");
+      return(0);
+   }
+
+   if ( (args.maxSize == 0) || (args.maxSize > dmaSize) ) args.maxSize = dmaSize;
+   if ( args.minSize == 0 ) args.minSize = 1;
+
+   printf("     size      count   duration     frames/s       MB/s   errors");
+   if ( args.ext ) printf("   queue us    read us");
+   printf("\n");
+
+   for (size = args.minSize; size <= args.maxSize; size = (size > (args.maxSize / 2)) ? (args.maxSize + 1) : (size * 2)) {
+      txCount  = 0;
+      rxCount  = 0;
+      errCount = 0;
+      toQueue  = 0;
+      toRead   = 0;
+
+      gettimeofday(&sTime, NULL);
+      lTime = sTime;
+
+      while ( rxCount < args.count ) {
+         // Keep the transmit side busy
+         while ( (txCount < args.count) && ((txIndex = dmaGetIndex(s)) < dmaCount) ) {
+            if ( dmaWriteIndex(s, txIndex, size, axisSetFlags(0x2, 0, 0), args.dest) <= 0 ) {
+               dmaRetIndex(s, txIndex);
+               break;
+            }
+            txCount++;
+         }
+
+         // Collect the looped back frames
+         if ( args.ext ) {
+            ret = dmaReadBulkExt(s, MAX_RET_CNT_C, rxExt);
+            clock_gettime(CLOCK_MONOTONIC, &rTime);
+            readNs = (uint64_t)rTime.tv_sec * 1000000000ULL + rTime.tv_nsec;
+
+            for (x = 0; x < ret; x++) {
+               dmaRet[x]   = rxExt[x].ret;
+               dmaIndex[x] = rxExt[x].index;
+               rxError[x]  = rxExt[x].error;
+               toQueue += (double)(rxExt[x].push - rxExt[x].harvest);
+               toRead  += (double)(readNs - rxExt[x].push);
+            }
+         } else {
+            ret = dmaReadBulkIndex(s, MAX_RET_CNT_C, dmaRet, dmaIndex, NULL, rxError, NULL);
+         }
+
+         for (x = 0; x < ret; x++) {
+            if ( (dmaRet[x] != (int32_t)size) || (rxError[x] != 0) ) errCount++;
+         }
+         if ( ret > 0 ) {
+            dmaRetIndexes(s, ret, dmaIndex);
+            rxCount += ret;
+            gettimeofday(&lTime, NULL);
+
+         // Give up on frames which are not looped back
+         } else if ( txCount == args.count ) {
+            gettimeofday(&eTime, NULL);
+            if ( (eTime.tv_sec - lTime.tv_sec) > 2 ) {
+               errCount += (txCount - rxCount);
+               break;
+            }
+         }
+      }
+
+      gettimeofday(&eTime, NULL);
+      timersub(&eTime, &sTime, &dTime);
+      duration = dTime.tv_sec + (double)dTime.tv_usec / 1000000.0;
+
+      printf("%9i   %8i   %8.3f   %10.0f   %8.1f   %6i", size, rxCount, duration,
+             rxCount / duration, ((double)rxCount * size) / (duration * 1e6), errCount);
+      if ( args.ext && (rxCount > 0) ) printf("   %8.2f   %8.2f", toQueue / rxCount / 1e3, toRead / rxCount / 1e3);
+      printf("\n");
+   }
+
+   dmaUnMapDma(s, dmaBuffers);
+   close(s);
+   return(0);
+}
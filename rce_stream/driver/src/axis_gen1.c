@@ -16,6 +16,7 @@
 **/
 #include <AxisDriver.h>
 #include <axis_gen1.h>
+#include <dma_trace.h>
 #include <linux/seq_file.h>
 #include <linux/signal.h>
 
@@ -37,6 +38,7 @@ irqreturn_t AxisG1_Irq(int irq, void *dev_id) {
    uint32_t    handle;
    uint32_t    size;
    uint32_t    status;
+   uint32_t    handleCount;
 
    struct DmaDesc     * desc;
    struct DmaBuffer   * buff;
@@ -53,6 +55,8 @@ irqreturn_t AxisG1_Irq(int irq, void *dev_id) {
 
       // Disable interrupts
       iowrite32(0x0, &(reg->intEnable));
+      trace_dma_irq(dev);
+      handleCount = 0;
 
       // Read from FIFOs
       while ( (stat = ioread32(&(reg->fifoValid))) != 0 ) {
@@ -61,10 +65,15 @@ irqreturn_t AxisG1_Irq(int irq, void *dev_id) {
             // Read handle
             if (((handle = ioread32(&(reg->txFree))) & 0x80000000) != 0) {
                handle &= 0x7FFFFFFC;
+               ++handleCount;
 
-               if ( dev->debug > 0 )
+               if ( dmaDebug(dev) )
                   dev_info(dev->device, "Irq: Return TX Status Value 0x%.8x.\n", handle);
 
+               // Lookup is only done while the event is enabled
+               if ( trace_dma_tx_done_enabled() && ((buff = dmaFindBufferList(&(dev->txBuffers), handle)) != NULL) )
+                  trace_dma_tx_done(dev, buff);
+
                // Attempt to find buffer in tx pool and return. otherwise return rx entry to hw.
                if ((buff = dmaRetBufferIrq(dev, handle)) != NULL) {
                   iowrite32(handle, &(reg->rxFree));
@@ -77,6 +86,7 @@ irqreturn_t AxisG1_Irq(int irq, void *dev_id) {
             // Read handle
             while (((handle = ioread32(&(reg->rxPend))) & 0x80000000) != 0) {
                handle &= 0x7FFFFFFC;
+               ++handleCount;
 
                // Read size
                do {
@@ -121,28 +131,42 @@ irqreturn_t AxisG1_Irq(int irq, void *dev_id) {
                      buff->error |= DMA_ERR_LEN;
                   }
 
-                  if ( dev->debug > 0 ) {
+                  if ( dmaDebug(dev) ) {
                      dev_info(dev->device, "Irq: Rx size=%i, Dest=%i, Flags=0x%x, Error=0x%x.\n",
                         buff->size, buff->dest, buff->flags, buff->error);
                   }
+                  trace_dma_rx(dev, buff);
+                  dmaStatsRx(dev, buff);
 
                   // Lock mask records
                   // This ensures close does not occur while irq routine is
                   // pushing data to desc rx queue
                   spin_lock(&dev->maskLock);
 
+                  // Harvest time and sequence number
+                  dmaRxStamp(dev, buff, (dev->rxStamp > 0) ? ktime_get_ns() : 0);
+                  dmaLcMark(dev, buff, DMA_LC_HW);
+
                   // Find owner of lane/vc
-                  if ( buff->dest < DMA_MAX_DEST ) {
-                      desc = dev->desc[buff->dest];
-                  } else {
-                      desc = NULL;
-                  }
+                  desc = Dma_DestOwner(dev, buff->dest, 0);
 
                   // Return entry to FPGA if destc is not open
                   if ( desc == NULL ) {
-                     if ( dev->debug > 0 ) {
+                     if ( dmaDebug(dev) ) {
                         dev_info(dev->device, "Irq: Port not open return to free list.\n");
                      }
+                     trace_dma_rx_drop(dev, buff);
+                     dmaStatsDrop(dev, buff);
+                     dmaBufferToHw(buff);
+                     dmaLcSkip(buff);
+                     dmaLcMark(dev, buff, DMA_LC_FREE);
+                     iowrite32(handle, &(reg->rxFree));
+
+                  // Small frame copied out, return entry to FPGA
+                  } else if ( dmaRxSmall(desc, buff) ) {
+                     dmaBufferToHw(buff);
+                     dmaLcSkip(buff);
+                     dmaLcMark(dev, buff, DMA_LC_FREE);
                      iowrite32(handle, &(reg->rxFree));
 
                   // lane/vc is open,  Add to RX Queue
@@ -161,6 +185,8 @@ irqreturn_t AxisG1_Irq(int irq, void *dev_id) {
          }
       }
 
+      Dma_ServiceStats(dev, handleCount);
+
       // Enable interrupts
       iowrite32(0x1, &(reg->intEnable));
       return(IRQ_HANDLED);
@@ -250,6 +276,9 @@ void AxisG1_RetRxBuffer(struct DmaDevice *dev, struct DmaBuffer **buff, uint32_t
    reg = (struct AxisG1Reg *)dev->reg;
 
    for (x=0; x < count; x++) {
+      dmaLcMark(dev, buff[x], DMA_LC_USER);
+      trace_dma_rx_ret(dev, buff[x]);
+
       if ( dmaBufferToHw(buff[x]) < 0 ) {
          dev_warn(dev->device, "RetRxBuffer: Failed to map dma buffer.\n");
       } else {
@@ -261,6 +290,7 @@ void AxisG1_RetRxBuffer(struct DmaDevice *dev, struct DmaBuffer **buff, uint32_t
 
 // Send a buffer
 int32_t AxisG1_SendBuffer(struct DmaDevice *dev, struct DmaBuffer **buff, uint32_t count) {
+   unsigned long iflags;
    uint32_t control;
    uint32_t x;
 
@@ -276,15 +306,17 @@ int32_t AxisG1_SendBuffer(struct DmaDevice *dev, struct DmaBuffer **buff, uint32
          dev_warn(dev->device, "SendBuffer: Failed to map dma buffer.\n");
          return(-1);
       }
+      trace_dma_tx_submit(dev, buff[x]);
+      dmaStatsTx(dev, buff[x]);
 
-      // Write to hardware
-      spin_lock(&dev->writeHwLock);
+      // Write to hardware, may be called from the pacing timer
+      spin_lock_irqsave(&dev->writeHwLock, iflags);
 
       iowrite32(buff[x]->buffHandle, &(reg->txPostA));
       iowrite32(buff[x]->size, &(reg->txPostB));
       iowrite32(control, &(reg->txPostC));
 
-      spin_unlock(&dev->writeHwLock);
+      spin_unlock_irqrestore(&dev->writeHwLock, iflags);
    }
    return(count);
 }